@@ -3,6 +3,8 @@
 
 #include <string>
 #include <fstream>
+#include <map>
+#include <vector>
 #include "nlohmann/json.hpp"
 
 using json = nlohmann::json;
@@ -21,15 +23,84 @@ struct SimArgs {
   float timeStep;
 };
 
+// Feed and kill rates that vary over the grid, in place of the uniform
+// simArgs.feed and simArgs.kill. CPU only (the field and scalar engines); the
+// Metal renderer keeps the uniform rates. Ranges are linear ramps from the
+// first value at the first cell to the second at the last, feed across the
+// columns and kill down the rows, as in Pearson's (F, k) map. Per-cell
+// fields hold width * height values, row-major, and take precedence.
+struct RateField {
+  bool feedRamp = false;
+  bool killRamp = false;
+  float feedRange[2] = {0.0f, 0.0f};
+  float killRange[2] = {0.0f, 0.0f};
+  std::vector<float> feedCells;
+  std::vector<float> killCells;
+
+  bool active() const {
+    return feedRamp || killRamp || !feedCells.empty() || !killCells.empty();
+  }
+};
+
+// Value of a ramp over `count` cells at cell i.
+inline float rampValue(const float range[2], int i, int count) {
+  return count > 1 ? range[0] + (range[1] - range[0]) * i / (count - 1) : range[0];
+}
+
+// Reaction model of the CPU model engine (cpu/Models.hpp). "gray_scott" is
+// the model everything else runs, with its rates and diffusion taken from
+// simArgs unless given here; the other models read their parameters by name.
+// "expression" reads its reaction rates from the config as expressions, one
+// per species (cpu/Expression.hpp).
+struct ModelConfig {
+  std::string name = "gray_scott";
+  std::vector<float> diffusion;        // per species
+  std::map<std::string, float> params; // model parameters by name
+  std::vector<std::string> species;    // expression variable names, default u, v, w, z
+  std::vector<std::string> reactions;  // expression rate of each species
+  bool clamp = false;                  // expression species clamped to [0, 1]
+
+  bool grayScott() const { return name == "gray_scott"; }
+};
+
 struct Config {
   float noiseDensity;
   int stepsPerFrame;
   std::string name;
   int width;
   int height;
+  // Slices of a 3D volume (volume engine), 1 for a plain 2D grid.
+  int depth = 1;
+  // Surface mesh of the mesh engine (cpu/Mesh.hpp), empty for a grid.
+  std::string mesh;
+  // Boundary condition for the CPU engines: "periodic", "neumann" or "dirichlet".
+  std::string boundary;
+  // Laplacian stencil for the CPU stencil engine (cpu/Stencils.hpp):
+  // "5-point", "9-point" or "4th-order". Every other engine and the Metal
+  // renderer use the 5-point one.
+  std::string stencil = "5-point";
   SimArgs simArgs;
+  RateField rates;
+  ModelConfig model;
 };
 
+// Simulation args of cell (x, y), with the rate field applied.
+inline SimArgs cellArgs(const Config &config, int x, int y) {
+  SimArgs args = config.simArgs;
+  const RateField &rates = config.rates;
+  if (!rates.feedCells.empty()) {
+    args.feed = rates.feedCells[size_t(y) * config.width + x];
+  } else if (rates.feedRamp) {
+    args.feed = rampValue(rates.feedRange, x, config.width);
+  }
+  if (!rates.killCells.empty()) {
+    args.kill = rates.killCells[size_t(y) * config.width + x];
+  } else if (rates.killRamp) {
+    args.kill = rampValue(rates.killRange, y, config.height);
+  }
+  return args;
+}
+
 inline Config getConfig(std::string path, std::string configName) {
   std::ifstream f(path);
   json data = json::parse(f);
@@ -40,6 +111,10 @@ inline Config getConfig(std::string path, std::string configName) {
   config.height = data["height"];
   config.stepsPerFrame = data["steps_per_frame"];
   config.noiseDensity = data["noise_density"];
+  config.boundary = data.value("boundary", "periodic");
+  config.depth = data.value("depth", 1);
+  config.mesh = data.value("mesh", "");
+  config.stencil = data.value("stencil", "5-point");
   // Simulations specific overrides for global confs
   if (data[configName].contains("noise_density")) {
     config.noiseDensity = data[configName]["noise_density"];
@@ -47,17 +122,83 @@ inline Config getConfig(std::string path, std::string configName) {
   if (data[configName].contains("steps_per_frame")) {
     config.stepsPerFrame = data[configName]["steps_per_frame"];
   }
-  // Simulation args
-  config.simArgs.frequency = data[configName]["frequency"];
-  config.simArgs.scale = data[configName]["scale"];
-  config.simArgs.diffA = data[configName]["diffA"];
-  config.simArgs.diffB = data[configName]["diffB"];
-  config.simArgs.feed = data[configName]["feed_rate"];
-  config.simArgs.kill = data[configName]["kill_rate"];
+  if (data[configName].contains("boundary")) {
+    config.boundary = data[configName]["boundary"];
+  }
+  if (data[configName].contains("depth")) {
+    config.depth = data[configName]["depth"];
+  }
+  if (data[configName].contains("mesh")) {
+    config.mesh = data[configName]["mesh"];
+  }
+  if (data[configName].contains("stencil")) {
+    config.stencil = data[configName]["stencil"];
+  }
+  // Reaction model, Gray-Scott unless named
+  const json &pattern = data[configName];
+  config.model.name = pattern.value("model", "gray_scott");
+  if (pattern.contains("diffusion")) {
+    config.model.diffusion = pattern["diffusion"].get<std::vector<float>>();
+  }
+  if (pattern.contains("params")) {
+    config.model.params = pattern["params"].get<std::map<std::string, float>>();
+  }
+  if (pattern.contains("species")) {
+    config.model.species = pattern["species"].get<std::vector<std::string>>();
+  }
+  if (pattern.contains("reactions")) {
+    config.model.reactions = pattern["reactions"].get<std::vector<std::string>>();
+  }
+  config.model.clamp = pattern.value("clamp", false);
+  // Simulation args. Other models do not need the Gray-Scott ones; diffA and
+  // diffB then mirror their first two diffusion rates.
+  if (config.model.grayScott()) {
+    config.simArgs.frequency = pattern["frequency"];
+    config.simArgs.scale = pattern["scale"];
+    config.simArgs.diffA = pattern["diffA"];
+    config.simArgs.diffB = pattern["diffB"];
+    config.simArgs.feed = pattern["feed_rate"];
+    config.simArgs.kill = pattern["kill_rate"];
+  } else {
+    const std::vector<float> &diffusion = config.model.diffusion;
+    config.simArgs.frequency = pattern.value("frequency", 0.0f);
+    config.simArgs.scale = pattern.value("scale", 0.0f);
+    config.simArgs.diffA = pattern.value("diffA", diffusion.size() > 0 ? diffusion[0] : 0.0f);
+    config.simArgs.diffB = pattern.value("diffB", diffusion.size() > 1 ? diffusion[1] : 0.0f);
+    config.simArgs.feed = pattern.value("feed_rate", 0.0f);
+    config.simArgs.kill = pattern.value("kill_rate", 0.0f);
+  }
   config.simArgs.timeStep = data["time_step"];
+  if (data[configName].contains("time_step")) {
+    config.simArgs.timeStep = data[configName]["time_step"];
+  }
+  // Optional [first, last] ramps, see RateField
+  if (data[configName].contains("feed_range")) {
+    config.rates.feedRamp = true;
+    config.rates.feedRange[0] = data[configName]["feed_range"][0];
+    config.rates.feedRange[1] = data[configName]["feed_range"][1];
+  }
+  if (data[configName].contains("kill_range")) {
+    config.rates.killRamp = true;
+    config.rates.killRange[0] = data[configName]["kill_range"][0];
+    config.rates.killRange[1] = data[configName]["kill_range"][1];
+  }
   return config;
 }
 
+// Names of all patterns defined in a config file (every object-valued key).
+inline std::vector<std::string> getConfigNames(std::string path) {
+  std::ifstream f(path);
+  json data = json::parse(f);
+  std::vector<std::string> names;
+  for (auto it = data.begin(); it != data.end(); ++it) {
+    if (it.value().is_object()) {
+      names.push_back(it.key());
+    }
+  }
+  return names;
+}
+
 // Convenience for default config
 inline Config getConfig() {
   return getConfig("pattern-confs/pearson.json", "coral");
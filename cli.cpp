@@ -0,0 +1,1074 @@
+// Headless driver for the CPU backend. Runs a pattern from pearson.json for a
+// fixed number of steps, reports throughput and dumps the final state.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Config.hpp"
+#include "cpu/BatchEngine.hpp"
+#include "cpu/Engine.hpp"
+#include "cpu/HexLattice.hpp"
+#include "cpu/MeshEngine.hpp"
+#include "cpu/VolumeEngine.hpp"
+
+namespace {
+
+struct CliArgs {
+  std::string confPath = "pattern-confs/pearson.json";
+  std::string configName = "coral";
+  std::string engineName = "scalar";
+  bool engineChosen = false; // --engine given; otherwise rate fields pick the field engine,
+                             // reaction models other than Gray-Scott the model engine and
+                             // stencils other than 5-point the stencil engine
+  std::string stencil;       // --stencil, in place of the pattern's
+  std::string outPath;
+  std::string pgmPath;
+  std::string plyPath;
+  std::string meshPath;
+  std::string resample; // WxH or "auto": square frames from the hex engine
+  int steps = 1000;
+  bool verify = false;
+  bool scaling = false;
+  bool accuracy = false;
+  bool stencils = false; // benchmark every stencil on the stencil engine
+  double convergeTime = 0.0; // largest simulated time for --converge, 0 when off
+  std::vector<std::string> compare;
+  std::vector<std::string> sweep; // patterns of a --sweep batch
+  std::string sweepGrid;          // F0:F1:NF,K0:K1:NK of a --sweep-grid batch
+  std::string pearsonMap;         // F0:F1,K0:K1 ramps of --pearson-map
+  std::string feedFieldPath;      // per-cell feed rates, raw float32
+  std::string killFieldPath;      // per-cell kill rates, raw float32
+  int width = 0;
+  int height = 0;
+  int depth = 0;
+  EngineOptions options;
+};
+
+void printUsage() {
+  std::cout << "Usage: rd-cli [pattern_name] [options]\n"
+            << "  --config PATH    pattern file (default pattern-confs/pearson.json)\n"
+            << "  --engine NAME    CPU engine (default scalar; field for patterns with\n"
+            << "                   rate fields, model for other reaction models, stencil\n"
+            << "                   for stencils other than 5-point)\n"
+            << "  --steps N        number of simulation steps (default 1000)\n"
+            << "  --isa NAME       row kernel: auto, avx512, avx2 or scalar (default auto)\n"
+            << "  --threads N      worker threads for threaded engines (default: all)\n"
+            << "  --tile WxH       tile size in cells (default: sized from the L2 cache)\n"
+            << "  --time-block K   steps fused per tile pass by the temporal engine\n"
+            << "                   (default: picked from the cache size)\n"
+            << "  --sparse-threshold T  change below which the sparse engine lets a\n"
+            << "                   tile sleep (default 1e-6)\n"
+            << "  --implicit-dt DT time step of the spectral, adi and rkl engines (default\n"
+            << "                   0.3 / (1 + feed); steps past 1 / (1 + feed) are rejected)\n"
+            << "  --tolerance E    largest local error per step of the adaptive engine\n"
+            << "                   (default 1e-3)\n"
+            << "  --stencil S      laplacian stencil: 5-point (default), 9-point (isotropic)\n"
+            << "                   or 4th-order; runs on the stencil engine\n"
+            << "  --width W        override grid width\n"
+            << "  --height H       override grid height\n"
+            << "  --depth D        run a 3D volume of D slices on the volume engine\n"
+            << "                   (--engine volume for a single slice);\n"
+            << "                   --out writes the whole volume, --pgm is a prefix for\n"
+            << "                   one image per slice, --tile WxH sets the rows per band\n"
+            << "  --mesh FILE      run on the vertices of a triangle mesh on the mesh engine:\n"
+            << "                   .obj or .ply, sphere:L (icosphere, L subdivisions) or\n"
+            << "                   torus:UxV; --out writes A/B per vertex\n"
+            << "  --mesh-order O   vertex order of the mesh engine: rcm (default), morton\n"
+            << "                   or input\n"
+            << "  --ply FILE       write the mesh with final A, B and B as grey vertex colour\n"
+            << "  --seed S         seed for the initial noise (default 1)\n"
+            << "  --out FILE       write final state as raw interleaved float32 A/B\n"
+            << "  --pgm FILE       write final B concentration as an 8-bit PGM image\n"
+            << "  --resample WxH   hex engine: write --out and --pgm resampled onto a W x H\n"
+            << "                   square grid over the lattice (auto: one cell per unit\n"
+            << "                   area) instead of the native offset rows\n"
+            << "  --list           list available engines\n"
+            << "  --verify         check the engine against the scalar reference on every\n"
+            << "                   pattern in the config file (the model engine on scalar\n"
+            << "                   kernels for other reaction models)\n"
+            << "  --accuracy       compare pattern statistics of the engine against the\n"
+            << "                   float soa engine on every pattern in the config file\n"
+            << "  --scaling        benchmark the engine at 1, 2, 4, ... threads\n"
+            << "  --stencils       benchmark every stencil on the stencil engine: cost per\n"
+            << "                   cell and per cell and unit of simulated time\n"
+            << "  --compare A,B,.. benchmark several engines on the same pattern and options\n"
+            << "  --converge T     time the engine, or the --compare engines, until the\n"
+            << "                   pattern stops changing or T simulated time units pass\n"
+            << "  --sweep A,B,..   run several patterns as one batch, one per SIMD lane;\n"
+            << "                   --out and --pgm become prefixes for one file per pattern\n"
+            << "  --sweep-grid F0:F1:NF,K0:K1:NK  same for an NF x NK grid of feed and kill\n"
+            << "                   rates around the pattern\n"
+            << "  --pearson-map F0:F1,K0:K1  one grid with feed ramping from F0 to F1 along\n"
+            << "                   x and kill from K0 to K1 along y (field engine)\n"
+            << "  --feed-field FILE  per-cell feed rates, width x height raw float32\n"
+            << "  --kill-field FILE  per-cell kill rates, same format\n";
+}
+
+std::vector<std::string> splitList(const std::string &list) {
+  std::vector<std::string> items;
+  for (size_t start = 0; start <= list.size();) {
+    size_t comma = std::min(list.find(',', start), list.size());
+    items.push_back(list.substr(start, comma - start));
+    start = comma + 1;
+  }
+  return items;
+}
+
+bool parseArgs(int argc, char **argv, CliArgs &args) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto value = [&]() -> const char * {
+      if (i + 1 >= argc) {
+        std::cerr << "Missing value for " << arg << std::endl;
+        exit(1);
+      }
+      return argv[++i];
+    };
+    if (arg == "--help" || arg == "-h") {
+      printUsage();
+      exit(0);
+    } else if (arg == "--list") {
+      for (const std::string &name : engineNames()) {
+        std::cout << name << std::endl;
+      }
+      exit(0);
+    } else if (arg == "--config") {
+      args.confPath = value();
+    } else if (arg == "--engine") {
+      args.engineName = value();
+      args.engineChosen = true;
+    } else if (arg == "--isa") {
+      std::string name = value();
+      if (!parseIsa(name, args.options.isa)) {
+        std::cerr << "Unknown instruction set: " << name << std::endl;
+        return false;
+      }
+    } else if (arg == "--threads") {
+      args.options.threads = atoi(value());
+    } else if (arg == "--tile") {
+      std::string tile = value();
+      if (sscanf(tile.c_str(), "%dx%d", &args.options.tileWidth, &args.options.tileHeight) != 2) {
+        std::cerr << "Tile size must look like 256x64: " << tile << std::endl;
+        return false;
+      }
+    } else if (arg == "--time-block") {
+      args.options.timeBlock = atoi(value());
+    } else if (arg == "--compare") {
+      args.compare = splitList(value());
+    } else if (arg == "--sweep") {
+      args.sweep = splitList(value());
+    } else if (arg == "--sweep-grid") {
+      args.sweepGrid = value();
+    } else if (arg == "--pearson-map") {
+      args.pearsonMap = value();
+    } else if (arg == "--feed-field") {
+      args.feedFieldPath = value();
+    } else if (arg == "--kill-field") {
+      args.killFieldPath = value();
+    } else if (arg == "--sparse-threshold") {
+      args.options.sparseThreshold = static_cast<float>(atof(value()));
+    } else if (arg == "--implicit-dt") {
+      args.options.implicitTimeStep = static_cast<float>(atof(value()));
+    } else if (arg == "--tolerance") {
+      args.options.tolerance = static_cast<float>(atof(value()));
+    } else if (arg == "--converge") {
+      args.convergeTime = atof(value());
+    } else if (arg == "--scaling") {
+      args.scaling = true;
+    } else if (arg == "--stencils") {
+      args.stencils = true;
+    } else if (arg == "--stencil") {
+      args.stencil = value();
+      Stencil stencil;
+      if (!parseStencil(args.stencil, stencil)) {
+        std::cerr << "Unknown stencil: " << args.stencil << std::endl;
+        return false;
+      }
+    } else if (arg == "--accuracy") {
+      args.accuracy = true;
+    } else if (arg == "--verify") {
+      args.verify = true;
+    } else if (arg == "--steps") {
+      args.steps = atoi(value());
+    } else if (arg == "--width") {
+      args.width = atoi(value());
+    } else if (arg == "--height") {
+      args.height = atoi(value());
+    } else if (arg == "--depth") {
+      args.depth = atoi(value());
+    } else if (arg == "--mesh") {
+      args.meshPath = value();
+    } else if (arg == "--mesh-order") {
+      std::string name = value();
+      if (!parseMeshOrder(name, args.options.meshOrder)) {
+        std::cerr << "Unknown mesh order: " << name << std::endl;
+        return false;
+      }
+    } else if (arg == "--ply") {
+      args.plyPath = value();
+    } else if (arg == "--seed") {
+      args.options.seed = static_cast<unsigned>(strtoul(value(), nullptr, 10));
+    } else if (arg == "--out") {
+      args.outPath = value();
+    } else if (arg == "--pgm") {
+      args.pgmPath = value();
+    } else if (arg == "--resample") {
+      args.resample = value();
+      int w, h;
+      if (args.resample != "auto" &&
+          (sscanf(args.resample.c_str(), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0)) {
+        std::cerr << "Resample size must look like 512x512 or auto: " << args.resample
+                  << std::endl;
+        return false;
+      }
+    } else if (arg.rfind("--", 0) == 0) {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return false;
+    } else {
+      args.configName = arg;
+    }
+  }
+  return true;
+}
+
+// Both exporters read the engine's memory through its view, whatever the
+// layout, and produce the interleaved texture layout / B channel.
+void writeRawRows(std::ostream &f, const StateView &state) {
+  std::vector<float> row(2 * size_t(state.width));
+  for (int y = 0; y < state.height; y++) {
+    state.copyRow(y, row.data());
+    f.write(reinterpret_cast<const char *>(row.data()), row.size() * sizeof(float));
+  }
+}
+
+bool writeRaw(const std::string &path, const StateView &state) {
+  std::ofstream f(path, std::ios::binary);
+  writeRawRows(f, state);
+  return bool(f);
+}
+
+bool writePgm(const std::string &path, const StateView &state) {
+  std::ofstream f(path, std::ios::binary);
+  f << "P5\n" << state.width << " " << state.height << "\n255\n";
+  for (int y = 0; y < state.height; y++) {
+    for (int x = 0; x < state.width; x++) {
+      float b = std::clamp(state.B(x, y), 0.0f, 1.0f);
+      f.put(static_cast<char>(b * 255.0f + 0.5f));
+    }
+  }
+  return bool(f);
+}
+
+double timeSteps(Engine &engine, int steps) {
+  auto start = std::chrono::steady_clock::now();
+  engine.step(steps);
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+// Thread scaling curve for one engine: 1, 2, 4, ... threads up to the number
+// of hardware threads, each from the same seed.
+int benchmarkScaling(const CliArgs &args, const Config &config) {
+  int maxThreads = args.options.threads > 0
+                       ? args.options.threads
+                       : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<int> counts;
+  for (int t = 1; t < maxThreads; t *= 2) {
+    counts.push_back(t);
+  }
+  counts.push_back(maxThreads);
+
+  printf("%8s %14s %9s %11s  %s\n", "threads", "Mcell-upd/s", "speedup", "efficiency",
+         "engine");
+  double base = 0.0;
+  for (int threads : counts) {
+    EngineOptions options = args.options;
+    options.threads = threads;
+    std::unique_ptr<Engine> engine = makeSeededEngine(args.engineName, config, options);
+    if (!engine) {
+      std::cerr << "Unknown engine: " << args.engineName << std::endl;
+      return 1;
+    }
+    double rate = double(config.width) * config.height * args.steps /
+                  timeSteps(*engine, args.steps) / 1e6;
+    if (base == 0.0) {
+      base = rate;
+    }
+    printf("%8d %14.1f %8.2fx %10.0f%%  %s\n", threads, rate, rate / base,
+           100.0 * rate / base / threads, engine->name());
+  }
+  return 0;
+}
+
+// Side-by-side throughput of several engines from the same seed. The first
+// engine is the baseline for the relative column.
+int benchmarkEngines(const CliArgs &args, const Config &config) {
+  printf("%-36s %14s %10s %9s\n", "engine", "Mcell-upd/s", "ns/cell", "relative");
+  double base = 0.0;
+  for (const std::string &name : args.compare) {
+    std::unique_ptr<Engine> engine = makeSeededEngine(name, config, args.options);
+    if (!engine) {
+      std::cerr << "Unknown engine: " << name << std::endl;
+      return 1;
+    }
+    double seconds = timeSteps(*engine, args.steps);
+    double cellUpdates = double(config.width) * config.height * args.steps;
+    double rate = cellUpdates / seconds;
+    if (base == 0.0) {
+      base = rate;
+    }
+    printf("%-36s %14.1f %10.3f %8.2fx\n", engine->name(), rate / 1e6, 1e9 / rate,
+           rate / base);
+    std::string stats = engine->stats();
+    if (!stats.empty()) {
+      std::cout << "    " << stats << std::endl;
+    }
+  }
+  return 0;
+}
+
+// Cost of each stencil on the stencil engine from the same seed, relative to
+// the 5-point one. A wider stencil costs more per step but may allow a
+// coarser grid; the last column folds in how far each lets forward Euler
+// step, as time per cell and simulated time unit at the stability limit.
+int benchmarkStencils(const CliArgs &args, const Config &config) {
+  printf("%-10s %5s %14s %10s %9s %10s %14s\n", "stencil", "taps", "Mcell-upd/s", "ns/cell",
+         "relative", "max dt", "ns/cell/time");
+  double base = 0.0;
+  for (Stencil stencil : {Stencil::FivePoint, Stencil::NinePoint, Stencil::FourthOrder}) {
+    Config run = config;
+    run.stencil = stencilName(stencil);
+    std::unique_ptr<Engine> engine = makeSeededEngine("stencil", run, args.options);
+    double seconds = timeSteps(*engine, args.steps);
+    double rate = double(config.width) * config.height * args.steps / seconds;
+    if (base == 0.0) {
+      base = rate;
+    }
+    const float limit = stencilStepLimit(stencil, config.simArgs, 2.0f);
+    printf("%-10s %5d %14.1f %10.3f %8.2fx %10.3g %14.3f\n", stencilName(stencil),
+           stencilTaps(stencil), rate / 1e6, 1e9 / rate, rate / base, limit,
+           1e9 / rate / limit);
+  }
+  std::cout << "engine " << makeEngine("stencil", config, args.options)->name() << std::endl;
+  return 0;
+}
+
+// Largest per-cell difference from the scalar engine accepted by --verify.
+// FMA contraction and a different summation order change the last bit of
+// each update; over a few hundred steps that stays well below 1e-3, while a
+// real indexing or wrapping bug shows up as an O(0.1) difference.
+const float kVerifyTolerance = 1e-3f;
+
+// Root mean square of the per-value difference, A and B alike.
+double rmsDifference(const Grid &lhs, const Grid &rhs) {
+  double sum = 0.0;
+  for (size_t i = 0; i < lhs.cells.size(); i++) {
+    double diff = double(lhs.cells[i]) - rhs.cells[i];
+    sum += diff * diff;
+  }
+  return std::sqrt(sum / lhs.cells.size());
+}
+
+float maxDifference(const Grid &lhs, const Grid &rhs) {
+  float diff = 0.0f;
+  for (size_t i = 0; i < lhs.cells.size(); i++) {
+    diff = std::max(diff, std::abs(lhs.cells[i] - rhs.cells[i]));
+  }
+  return diff;
+}
+
+// The scalar engine, or for reaction models other than Gray-Scott the model
+// engine on scalar kernels, and the interpreter for expression models. The
+// hex engine and the stencil engine with stencils other than 5-point have no
+// other engine to match and are checked against themselves on scalar kernels.
+std::unique_ptr<Engine> makeReferenceEngine(const std::string &engineName, const Config &config,
+                                            EngineOptions options) {
+  if (engineName == "hex" || (engineName == "stencil" && config.stencil != "5-point")) {
+    options.isa = Isa::Scalar;
+    return makeSeededEngine(engineName, config, options);
+  }
+  if (config.model.grayScott()) {
+    return makeSeededEngine("scalar", config, options);
+  }
+  if (config.model.name == "expression") {
+    return makeSeededEngine("bytecode", config, options);
+  }
+  options.isa = Isa::Scalar;
+  return makeSeededEngine("model", config, options);
+}
+
+// Runs every pattern through the reference and the selected engine from the
+// same seed and compares the final states.
+int verifyEngine(const CliArgs &args) {
+  std::vector<std::string> names = getConfigNames(args.confPath);
+  bool ok = true;
+  for (const std::string &name : names) {
+    Config config = getConfig(args.confPath, name);
+    if (args.width > 0) {
+      config.width = args.width;
+    }
+    if (args.height > 0) {
+      config.height = args.height;
+    }
+    if (!args.stencil.empty()) {
+      config.stencil = args.stencil;
+    }
+    std::unique_ptr<Engine> reference;
+    std::unique_ptr<Engine> engine;
+    try {
+      reference = makeReferenceEngine(args.engineName, config, args.options);
+      engine = makeSeededEngine(args.engineName, config, args.options);
+    } catch (const std::invalid_argument &e) {
+      printf("%-20s skipped: %s\n", name.c_str(), e.what());
+      continue;
+    }
+    if (!engine) {
+      std::cerr << "Unknown engine: " << args.engineName << std::endl;
+      return 1;
+    }
+    reference->step(args.steps);
+    engine->step(args.steps);
+    Grid expected, actual;
+    reference->getState(expected);
+    engine->getState(actual);
+    float diff = maxDifference(expected, actual);
+    bool pass = diff <= kVerifyTolerance;
+    ok = ok && pass;
+    printf("%-20s %-14s max |diff| %.3g %s\n", name.c_str(), engine->name(), diff,
+           pass ? "ok" : "FAIL");
+  }
+  printf("%s (tolerance %g after %d steps)\n", ok ? "All patterns within tolerance" : "FAILED",
+         kVerifyTolerance, args.steps);
+  return ok ? 0 : 1;
+}
+
+// Summary of a final state that says whether the same pattern formed,
+// without asking for cell-by-cell agreement.
+struct PatternStats {
+  double meanA = 0.0;
+  double meanB = 0.0;
+  double stdB = 0.0;
+  double coverage = 0.0; // fraction of cells with B above kCoverageLevel
+};
+
+const float kCoverageLevel = 0.25f;
+
+PatternStats patternStats(const Grid &grid) {
+  PatternStats stats;
+  double sumB2 = 0.0;
+  size_t covered = 0;
+  for (size_t i = 0; i < grid.cells.size(); i += 2) {
+    float a = grid.cells[i];
+    float b = grid.cells[i + 1];
+    stats.meanA += a;
+    stats.meanB += b;
+    sumB2 += double(b) * b;
+    covered += b > kCoverageLevel;
+  }
+  const double n = double(grid.cellCount());
+  stats.meanA /= n;
+  stats.meanB /= n;
+  stats.stdB = std::sqrt(std::max(0.0, sumB2 / n - stats.meanB * stats.meanB));
+  stats.coverage = covered / n;
+  return stats;
+}
+
+// A reduced-precision engine counts as producing the same pattern when every
+// statistic is within kStatsTolerance of the reference, relative, or within
+// kStatsFloor absolute for statistics near zero.
+const double kStatsTolerance = 0.05;
+const double kStatsFloor = 1e-3;
+
+bool statClose(double want, double got) {
+  return std::abs(want - got) <= std::max(kStatsFloor, kStatsTolerance * std::abs(want));
+}
+
+// Runs every pattern through the float soa engine and the selected engine
+// from the same seed and compares pattern statistics. Chaotic patterns
+// diverge cell by cell from the first rounding difference, so the cell
+// differences are reported but only the statistics decide.
+int compareAccuracy(const CliArgs &args) {
+  std::vector<std::string> names = getConfigNames(args.confPath);
+  printf("%-20s %-8s %15s %15s %15s %15s %10s %10s\n", "pattern", "", "mean A", "mean B",
+         "std B", "coverage", "rms diff", "max |diff|");
+  int tolerated = 0;
+  for (const std::string &name : names) {
+    Config config = getConfig(args.confPath, name);
+    if (args.width > 0) {
+      config.width = args.width;
+    }
+    if (args.height > 0) {
+      config.height = args.height;
+    }
+    if (!args.stencil.empty()) {
+      config.stencil = args.stencil;
+    }
+    std::unique_ptr<Engine> reference;
+    std::unique_ptr<Engine> engine;
+    try {
+      reference = makeSeededEngine("soa", config, args.options);
+      engine = makeSeededEngine(args.engineName, config, args.options);
+    } catch (const std::invalid_argument &e) {
+      printf("%-20s skipped: %s\n", name.c_str(), e.what());
+      continue;
+    }
+    if (!engine) {
+      std::cerr << "Unknown engine: " << args.engineName << std::endl;
+      return 1;
+    }
+    // Engines with their own time step run to the same simulated time.
+    reference->step(args.steps);
+    engine->step(static_cast<int>(std::lround(args.steps * double(config.simArgs.timeStep) /
+                                              engine->config().simArgs.timeStep)));
+    Grid expected, actual;
+    reference->getState(expected);
+    engine->getState(actual);
+    PatternStats want = patternStats(expected);
+    PatternStats got = patternStats(actual);
+    bool ok = statClose(want.meanA, got.meanA) && statClose(want.meanB, got.meanB) &&
+              statClose(want.stdB, got.stdB) && statClose(want.coverage, got.coverage);
+    tolerated += ok;
+    printf("%-20s %-8s %7.4f %7.4f %7.4f %7.4f %7.4f %7.4f %7.4f %7.4f %10.3g %10.3g\n",
+           name.c_str(), ok ? "ok" : "DIFFERS", want.meanA, got.meanA, want.meanB, got.meanB,
+           want.stdB, got.stdB, want.coverage, got.coverage, rmsDifference(expected, actual),
+           maxDifference(expected, actual));
+  }
+  printf("%d of %zu patterns keep every statistic within %g%% of soa (soa first, %s second, "
+         "after %d steps)\n",
+         tolerated, names.size(), 100 * kStatsTolerance, args.engineName.c_str(), args.steps);
+  return 0;
+}
+
+// --converge samples the state every kConvergeChunk simulated time units and
+// calls the pattern settled once the RMS change across a chunk, per unit of
+// simulated time, falls below kConvergeRate.
+const double kConvergeChunk = 50.0;
+const double kConvergeRate = 1e-5;
+
+struct ConvergeResult {
+  long steps = 0;
+  double time = 0.0;    // simulated
+  double seconds = 0.0; // wall clock, stepping only
+  bool converged = false;
+  Grid state;
+};
+
+ConvergeResult runToConvergence(Engine &engine, double maxTime) {
+  const double dt = engine.config().simArgs.timeStep;
+  const int chunkSteps = std::max(1, static_cast<int>(std::lround(kConvergeChunk / dt)));
+  ConvergeResult result;
+  Grid previous;
+  engine.getState(previous);
+  while (result.time < maxTime) {
+    result.seconds += timeSteps(engine, chunkSteps);
+    result.steps += chunkSteps;
+    result.time += chunkSteps * dt;
+    engine.getState(result.state);
+    if (rmsDifference(previous, result.state) / (chunkSteps * dt) < kConvergeRate) {
+      result.converged = true;
+      break;
+    }
+    previous = result.state;
+  }
+  return result;
+}
+
+// Wall-clock time to a settled pattern for each engine from the same seed.
+// Engines with larger time steps need fewer steps but more work per step, so
+// this is the fair race between explicit and spectral engines. The first
+// engine is the reference for the speedup and pattern columns.
+int convergeEngines(const CliArgs &args, const Config &config) {
+  std::vector<std::string> names = args.compare;
+  if (names.empty()) {
+    names.push_back(args.engineName);
+  }
+  printf("%-36s %8s %9s %9s %9s %10s  %s\n", "engine", "steps", "time", "seconds", "speedup",
+         "rms diff", "pattern");
+  ConvergeResult base;
+  for (size_t i = 0; i < names.size(); i++) {
+    std::unique_ptr<Engine> engine = makeSeededEngine(names[i], config, args.options);
+    if (!engine) {
+      std::cerr << "Unknown engine: " << names[i] << std::endl;
+      return 1;
+    }
+    ConvergeResult result = runToConvergence(*engine, args.convergeTime);
+    const char *pattern = "reference";
+    double rms = 0.0;
+    if (i == 0) {
+      base = result;
+    } else {
+      PatternStats want = patternStats(base.state);
+      PatternStats got = patternStats(result.state);
+      bool same = statClose(want.meanA, got.meanA) && statClose(want.meanB, got.meanB) &&
+                  statClose(want.stdB, got.stdB) && statClose(want.coverage, got.coverage);
+      pattern = same ? "same statistics" : "DIFFERS";
+      rms = rmsDifference(base.state, result.state);
+    }
+    printf("%-36s %8ld %8.0f%s %9.3f %8.2fx %10.3g  %s\n", engine->name(), result.steps,
+           result.time, result.converged ? " " : "+", result.seconds,
+           base.seconds / result.seconds, rms, pattern);
+    fflush(stdout); // runs can take minutes each
+  }
+  printf("time: simulated time to settle (RMS change below %g per unit time), "
+         "+ when the %g limit was reached first\n",
+         kConvergeRate, args.convergeTime);
+  return 0;
+}
+
+// --sweep-grid: the pattern with feed and kill rates evenly spaced over the
+// given ranges, feed varying slowest.
+bool appendSweepGrid(const std::string &spec, const Config &base, std::vector<Config> &configs) {
+  float feed0, feed1, kill0, kill1;
+  int feedCount, killCount;
+  if (sscanf(spec.c_str(), "%f:%f:%d,%f:%f:%d", &feed0, &feed1, &feedCount, &kill0, &kill1,
+             &killCount) != 6 ||
+      feedCount < 1 || killCount < 1) {
+    std::cerr << "Sweep grid must look like 0.02:0.06:4,0.055:0.065:4: " << spec << std::endl;
+    return false;
+  }
+  auto spaced = [](float first, float last, int count, int i) {
+    return count > 1 ? first + (last - first) * i / (count - 1) : first;
+  };
+  for (int i = 0; i < feedCount; i++) {
+    for (int j = 0; j < killCount; j++) {
+      Config config = base;
+      config.simArgs.feed = spaced(feed0, feed1, feedCount, i);
+      config.simArgs.kill = spaced(kill0, kill1, killCount, j);
+      char name[128];
+      snprintf(name, sizeof(name), "%s_f%.4f_k%.4f", base.name.c_str(), config.simArgs.feed,
+               config.simArgs.kill);
+      config.name = name;
+      configs.push_back(config);
+    }
+  }
+  return true;
+}
+
+// Runs every configuration as one lane-interleaved batch: throughput over the
+// whole batch, pattern statistics per configuration, and one output file per
+// configuration (--out and --pgm are prefixes to the configuration name).
+int runSweep(const CliArgs &args, const std::vector<Config> &configs) {
+  std::unique_ptr<BatchEngine> batch = makeSeededBatchEngine(configs, args.options);
+  const Config &first = configs.front();
+  std::cout << configs.size() << " configurations (" << first.width << "x" << first.height
+            << "), engine " << batch->name() << ", " << args.steps << " steps" << std::endl;
+
+  auto start = std::chrono::steady_clock::now();
+  batch->step(args.steps);
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double cellUpdates = double(first.width) * first.height * args.steps * configs.size();
+  printf("%.3f s, %.1f Mcell-updates/s over the batch\n", seconds, cellUpdates / seconds / 1e6);
+  printf("State memory %.1f MiB\n", batch->stateBytes() / 1048576.0);
+
+  printf("%-32s %8s %8s %8s %8s %8s\n", "pattern", "feed", "kill", "mean B", "std B",
+         "coverage");
+  for (int i = 0; i < batch->size(); i++) {
+    const Config &config = batch->config(i);
+    Grid state;
+    batch->getState(i, state);
+    PatternStats stats = patternStats(state);
+    printf("%-32s %8.4f %8.4f %8.4f %8.4f %8.4f\n", config.name.c_str(), config.simArgs.feed,
+           config.simArgs.kill, stats.meanB, stats.stdB, stats.coverage);
+    std::string rawPath = args.outPath + config.name + ".raw";
+    if (!args.outPath.empty() && !writeRaw(rawPath, batch->stateView(i))) {
+      std::cerr << "Failed to write " << rawPath << std::endl;
+      return 1;
+    }
+    std::string pgmPath = args.pgmPath + config.name + ".pgm";
+    if (!args.pgmPath.empty() && !writePgm(pgmPath, batch->stateView(i))) {
+      std::cerr << "Failed to write " << pgmPath << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Volume mode: throughput, pattern statistics over the whole volume, and
+// the volume as raw slices back to back (--out) or one PGM per slice (--pgm
+// prefix + slice number).
+int runVolume(const CliArgs &args, const Config &config) {
+  std::unique_ptr<VolumeEngine> engine = makeSeededVolumeEngine(config, args.options);
+  std::cout << "Pattern " << config.name << " (" << config.width << "x" << config.height << "x"
+            << config.depth << "), engine " << engine->name() << ", " << args.steps << " steps"
+            << std::endl;
+  const float eulerLimit = explicitStepLimit(config.simArgs, 2.0f, 3);
+  if (config.simArgs.timeStep > eulerLimit) {
+    std::cerr << "Warning: time step " << config.simArgs.timeStep
+              << " exceeds the explicit stability limit " << eulerLimit << " of the 3D stencil"
+              << std::endl;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  engine->step(args.steps);
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double cellUpdates = double(config.width) * config.height * config.depth * args.steps;
+  printf("%.3f s, %.1f Mcell-updates/s\n", seconds, cellUpdates / seconds / 1e6);
+  printf("State memory %.1f MiB (%.2f bytes/cell)\n", engine->stateBytes() / 1048576.0,
+         double(engine->stateBytes()) / (double(config.width) * config.height * config.depth));
+
+  PatternStats total;
+  double sumB2 = 0.0;
+  Grid slice;
+  for (int z = 0; z < config.depth; z++) {
+    engine->getSlice(z, slice);
+    PatternStats stats = patternStats(slice);
+    total.meanA += stats.meanA / config.depth;
+    total.meanB += stats.meanB / config.depth;
+    total.coverage += stats.coverage / config.depth;
+    sumB2 += (stats.stdB * stats.stdB + stats.meanB * stats.meanB) / config.depth;
+  }
+  total.stdB = std::sqrt(std::max(0.0, sumB2 - total.meanB * total.meanB));
+  printf("mean A %.4f, mean B %.4f, std B %.4f, coverage %.4f\n", total.meanA, total.meanB,
+         total.stdB, total.coverage);
+
+  if (!args.outPath.empty()) {
+    std::ofstream f(args.outPath, std::ios::binary);
+    for (int z = 0; z < config.depth; z++) {
+      writeRawRows(f, engine->slice(z));
+    }
+    if (!f) {
+      std::cerr << "Failed to write " << args.outPath << std::endl;
+      return 1;
+    }
+  }
+  for (int z = 0; z < config.depth && !args.pgmPath.empty(); z++) {
+    char number[16];
+    snprintf(number, sizeof(number), "%04d", z);
+    std::string path = args.pgmPath + number + ".pgm";
+    if (!writePgm(path, engine->slice(z))) {
+      std::cerr << "Failed to write " << path << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Binary PLY of the mesh with per-vertex A, B and B as a grey colour, like
+// the PGM. Little-endian, the byte order of every platform rd-cli runs on.
+bool writePly(const std::string &path, const Mesh &mesh, const Grid &state) {
+  std::ofstream f(path, std::ios::binary);
+  f << "ply\nformat binary_little_endian 1.0\n"
+    << "element vertex " << mesh.vertexCount() << "\n"
+    << "property float x\nproperty float y\nproperty float z\n"
+    << "property float a\nproperty float b\n"
+    << "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+    << "element face " << mesh.triangleCount() << "\n"
+    << "property list uchar int vertex_indices\nend_header\n";
+  for (int v = 0; v < mesh.vertexCount(); v++) {
+    const float values[5] = {mesh.positions[3 * v], mesh.positions[3 * v + 1],
+                             mesh.positions[3 * v + 2], state.cells[2 * v], state.cells[2 * v + 1]};
+    const char grey = static_cast<char>(std::clamp(values[4], 0.0f, 1.0f) * 255.0f + 0.5f);
+    f.write(reinterpret_cast<const char *>(values), sizeof(values));
+    f.put(grey).put(grey).put(grey);
+  }
+  for (size_t t = 0; t < mesh.triangleCount(); t++) {
+    f.put(3);
+    f.write(reinterpret_cast<const char *>(&mesh.triangles[3 * t]), 3 * sizeof(int));
+  }
+  return bool(f);
+}
+
+// Mesh mode: throughput, pattern statistics over the vertices, the state per
+// vertex in the mesh's vertex order (--out) and the coloured mesh (--ply).
+int runMesh(const CliArgs &args, const Config &config) {
+  if (!args.pgmPath.empty()) {
+    std::cerr << "--pgm draws a grid; write meshes with --ply" << std::endl;
+    return 1;
+  }
+  auto start = std::chrono::steady_clock::now();
+  const Mesh mesh = loadMesh(config.mesh);
+  const double loadSeconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::unique_ptr<MeshEngine> engine = makeSeededMeshEngine(config, mesh, args.options);
+  std::cout << "Pattern " << config.name << " on " << mesh.name << " (" << mesh.vertexCount()
+            << " vertices, loaded in " << loadSeconds << " s), engine " << engine->name()
+            << ", " << args.steps << " steps" << std::endl;
+  if (config.simArgs.timeStep > engine->stepLimit()) {
+    std::cerr << "Warning: time step " << config.simArgs.timeStep
+              << " exceeds the explicit stability limit " << engine->stepLimit()
+              << " of the mesh laplacian" << std::endl;
+  }
+
+  start = std::chrono::steady_clock::now();
+  engine->step(args.steps);
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double vertexUpdates = double(mesh.vertexCount()) * args.steps;
+  printf("%.3f s, %.1f Mvertex-updates/s\n", seconds, vertexUpdates / seconds / 1e6);
+  printf("State memory %.1f MiB (%.2f bytes/vertex)\n", engine->stateBytes() / 1048576.0,
+         double(engine->stateBytes()) / mesh.vertexCount());
+  std::cout << engine->stats() << std::endl;
+
+  Grid state;
+  engine->getState(state);
+  PatternStats stats = patternStats(state);
+  printf("mean A %.4f, mean B %.4f, std B %.4f, coverage %.4f\n", stats.meanA, stats.meanB,
+         stats.stdB, stats.coverage);
+
+  if (!args.outPath.empty() && !writeRaw(args.outPath, state.view())) {
+    std::cerr << "Failed to write " << args.outPath << std::endl;
+    return 1;
+  }
+  if (!args.plyPath.empty() && !writePly(args.plyPath, mesh, state)) {
+    std::cerr << "Failed to write " << args.plyPath << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// Reads a per-cell rate field: raw float32 values, row-major.
+bool readField(const std::string &path, std::vector<float> &values) {
+  std::ifstream f(path, std::ios::binary | std::ios::ate);
+  if (!f) {
+    return false;
+  }
+  values.resize(size_t(f.tellg()) / sizeof(float));
+  f.seekg(0);
+  f.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(float));
+  return bool(f);
+}
+
+// --pearson-map, --feed-field and --kill-field on top of the pattern's own
+// rate field. The field sizes are checked by the engine.
+bool applyRateFields(const CliArgs &args, Config &config) {
+  RateField &rates = config.rates;
+  if (!args.pearsonMap.empty()) {
+    if (sscanf(args.pearsonMap.c_str(), "%f:%f,%f:%f", &rates.feedRange[0], &rates.feedRange[1],
+               &rates.killRange[0], &rates.killRange[1]) != 4) {
+      std::cerr << "Pearson map must look like 0.01:0.09,0.04:0.07: " << args.pearsonMap
+                << std::endl;
+      return false;
+    }
+    rates.feedRamp = true;
+    rates.killRamp = true;
+  }
+  if (!args.feedFieldPath.empty() && !readField(args.feedFieldPath, rates.feedCells)) {
+    std::cerr << "Failed to read " << args.feedFieldPath << std::endl;
+    return false;
+  }
+  if (!args.killFieldPath.empty() && !readField(args.killFieldPath, rates.killCells)) {
+    std::cerr << "Failed to read " << args.killFieldPath << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int run(CliArgs args) {
+  if (args.verify) {
+    return verifyEngine(args);
+  }
+  if (args.accuracy) {
+    return compareAccuracy(args);
+  }
+
+  Config config;
+  try {
+    config = getConfig(args.confPath, args.configName);
+  } catch (const std::exception &e) {
+    std::cerr << "Failed to load config " << args.configName << " from " << args.confPath
+              << ": " << e.what() << std::endl;
+    return 1;
+  }
+  if (args.width > 0) {
+    config.width = args.width;
+  }
+  if (args.height > 0) {
+    config.height = args.height;
+  }
+  if (args.depth > 0) {
+    config.depth = args.depth;
+  }
+  if (!args.meshPath.empty()) {
+    config.mesh = args.meshPath;
+  }
+  if (!applyRateFields(args, config)) {
+    return 1;
+  }
+  if (config.rates.active() && !args.engineChosen) {
+    args.engineName = "field";
+  }
+  if (!config.model.grayScott() && !args.engineChosen) {
+    args.engineName = "model";
+  }
+  if (!args.stencil.empty()) {
+    config.stencil = args.stencil;
+  }
+  if (config.stencil != "5-point" && !args.engineChosen) {
+    args.engineName = "stencil";
+  }
+
+  if (!config.mesh.empty() || args.engineName == "mesh") {
+    if (args.engineChosen && args.engineName != "mesh") {
+      std::cerr << "Meshes run on the mesh engine, not " << args.engineName << std::endl;
+      return 1;
+    }
+    if (config.mesh.empty()) {
+      std::cerr << "The mesh engine needs a mesh (--mesh)" << std::endl;
+      return 1;
+    }
+    return runMesh(args, config);
+  }
+
+  if (config.depth > 1 || args.engineName == "volume") {
+    if (args.engineChosen && args.engineName != "volume") {
+      std::cerr << "Volumes (depth > 1) run on the volume engine, not " << args.engineName
+                << std::endl;
+      return 1;
+    }
+    return runVolume(args, config);
+  }
+
+  if (!args.sweep.empty() || !args.sweepGrid.empty()) {
+    std::vector<Config> patterns;
+    for (const std::string &name : args.sweep) {
+      try {
+        patterns.push_back(getConfig(args.confPath, name));
+      } catch (const std::exception &e) {
+        std::cerr << "Failed to load config " << name << " from " << args.confPath << ": "
+                  << e.what() << std::endl;
+        return 1;
+      }
+      patterns.back().width = config.width;
+      patterns.back().height = config.height;
+      if (!applyRateFields(args, patterns.back())) {
+        return 1;
+      }
+    }
+    if (patterns.empty()) {
+      patterns.push_back(config);
+    }
+    std::vector<Config> configs;
+    for (const Config &pattern : patterns) {
+      if (args.sweepGrid.empty()) {
+        configs.push_back(pattern);
+      } else if (!appendSweepGrid(args.sweepGrid, pattern, configs)) {
+        return 1;
+      }
+    }
+    return runSweep(args, configs);
+  }
+
+  if (args.convergeTime > 0.0) {
+    std::cout << "Pattern " << config.name << " (" << config.width << "x" << config.height
+              << "), up to " << args.convergeTime << " time units" << std::endl;
+    return convergeEngines(args, config);
+  }
+
+  if (!args.compare.empty()) {
+    std::cout << "Pattern " << config.name << " (" << config.width << "x" << config.height
+              << "), " << args.steps << " steps per run" << std::endl;
+    return benchmarkEngines(args, config);
+  }
+
+  if (args.stencils) {
+    std::cout << "Pattern " << config.name << " (" << config.width << "x" << config.height
+              << "), " << args.steps << " steps per run" << std::endl;
+    return benchmarkStencils(args, config);
+  }
+
+  if (args.scaling) {
+    std::cout << "Pattern " << config.name << " (" << config.width << "x" << config.height
+              << "), " << args.steps << " steps per run" << std::endl;
+    return benchmarkScaling(args, config);
+  }
+
+  if (!args.resample.empty() && args.engineName != "hex") {
+    std::cerr << "--resample converts the hex engine's lattice; " << args.engineName
+              << " already runs on a square grid" << std::endl;
+    return 1;
+  }
+  std::unique_ptr<Engine> engine = makeSeededEngine(args.engineName, config, args.options);
+  if (!engine) {
+    std::cerr << "Unknown engine: " << args.engineName << std::endl;
+    return 1;
+  }
+  // A reaction model's diffA and diffB mirror its first two species only.
+  SimArgs fastest = config.simArgs;
+  for (float rate : config.model.diffusion) {
+    fastest.diffB = std::max(fastest.diffB, rate);
+  }
+  Stencil stencil = Stencil::FivePoint;
+  parseStencil(config.stencil, stencil);
+  const float eulerLimit = stencilStepLimit(stencil, fastest, 2.0f);
+  if (config.simArgs.timeStep > eulerLimit) {
+    std::cerr << "Warning: time step " << config.simArgs.timeStep
+              << " exceeds the explicit stability limit " << eulerLimit << " for diffusion "
+              << std::max(fastest.diffA, fastest.diffB) << " on the " << config.stencil
+              << " stencil" << std::endl;
+  }
+
+  std::cout << "Pattern " << config.name << " (" << config.width << "x" << config.height
+            << "), engine " << engine->name() << ", " << args.steps << " steps" << std::endl;
+  const RateField &rates = config.rates;
+  if (rates.feedRamp && rates.feedCells.empty()) {
+    printf("Feed %g to %g along x\n", rates.feedRange[0], rates.feedRange[1]);
+  }
+  if (rates.killRamp && rates.killCells.empty()) {
+    printf("Kill %g to %g along y\n", rates.killRange[0], rates.killRange[1]);
+  }
+
+  double seconds = timeSteps(*engine, args.steps);
+  double cellUpdates = double(config.width) * config.height * args.steps;
+
+  printf("%.3f s, %.1f Mcell-updates/s, %.1f frames/s at %d steps/frame\n", seconds,
+         cellUpdates / seconds / 1e6, args.steps / seconds / config.stepsPerFrame,
+         config.stepsPerFrame);
+  printf("State memory %.1f MiB (%.2f bytes/cell)\n", engine->stateBytes() / 1048576.0,
+         double(engine->stateBytes()) / (double(config.width) * config.height));
+  std::string stats = engine->stats();
+  if (!stats.empty()) {
+    std::cout << stats << std::endl;
+  }
+
+  if (!args.outPath.empty() || !args.pgmPath.empty()) {
+    StateView state = engine->stateView();
+    Grid square;
+    if (!args.resample.empty()) {
+      int w = 0, h = 0;
+      if (args.resample == "auto") {
+        hexSquareSize(config.width, config.height, w, h);
+      } else {
+        sscanf(args.resample.c_str(), "%dx%d", &w, &h);
+      }
+      square = Grid(w, h);
+      resampleHex(state, config.boundary == "periodic", square);
+      state = square.view();
+      printf("Resampled to %dx%d\n", w, h);
+    }
+    if (!args.outPath.empty() && !writeRaw(args.outPath, state)) {
+      std::cerr << "Failed to write " << args.outPath << std::endl;
+      return 1;
+    }
+    if (!args.pgmPath.empty() && !writePgm(args.pgmPath, state)) {
+      std::cerr << "Failed to write " << args.pgmPath << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  CliArgs args;
+  if (!parseArgs(argc, argv, args)) {
+    printUsage();
+    return 1;
+  }
+  try {
+    return run(args);
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,235 @@
+// Adaptive engine: Bogacki-Shampine 3(2) Runge-Kutta with embedded error
+// control on SoA planes. The third-order solution is kept; the difference to
+// the embedded second-order one estimates the local error, and the step size
+// follows it: it grows while the pattern coarsens slowly and shrinks during
+// fast transients, keeping the largest per-cell error below
+// EngineOptions::tolerance.
+//
+// Diffusion caps the step regardless of accuracy: the method is unstable
+// beyond explicitStepLimit() with its stability radius of 2.51, which is
+// computed up front from diffA and diffB instead of being found by rejected
+// steps.
+//
+// step(n) advances the same simulated time as n steps of the preset's
+// time_step, so steps mean the same thing as for the other engines; the
+// number of internal steps is reported by stats(). Each internal step costs
+// three rate evaluations (the last one is reused by the next step).
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "Boundary.hpp"
+#include "Engine.hpp"
+#include "Kernels.hpp"
+#include "Planes.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+// Real-axis stability radius of Bogacki-Shampine 3(2), with a margin.
+constexpr float kStabilityRadius = 2.51f;
+constexpr float kStabilitySafety = 0.9f;
+
+// Step size controller: the next step aims at kControlSafety times the
+// tolerance and changes by at most these factors.
+constexpr double kControlSafety = 0.9;
+constexpr double kMinFactor = 0.2;
+constexpr double kMaxFactor = 5.0;
+
+template <class Boundary>
+class AdaptiveEngine : public Engine {
+public:
+  AdaptiveEngine(const Config &config, const EngineOptions &options)
+      : Engine(config), _kernel(rateKernel(options.isa)), _pool(options.threads),
+        _tolerance(options.tolerance), _y(config.width, config.height, 1),
+        _stage(config.width, config.height, 1), _next(config.width, config.height, 1),
+        _partialError(_pool.size()) {
+    for (PlaneGrid &k : _k) {
+      k = PlaneGrid(config.width, config.height, 0);
+    }
+    _maxStep = kStabilitySafety * explicitStepLimit(config.simArgs, kStabilityRadius);
+    _dt = std::min(double(config.simArgs.timeStep), _maxStep);
+    char tolerance[32];
+    snprintf(tolerance, sizeof(tolerance), "%g", _tolerance);
+    _name = "adaptive/" + std::string(Boundary::name) + "/" + isaName(resolveIsa(options.isa)) +
+            "/" + std::to_string(_pool.size()) + "t/tol=" + tolerance;
+  }
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(const Grid &grid) override {
+    _y.load(grid);
+    _rateValid = false;
+  }
+  StateView stateView() const override { return _y.view(); }
+  size_t stateBytes() const override {
+    size_t bytes = _y.bytes() + _stage.bytes() + _next.bytes();
+    for (const PlaneGrid &k : _k) {
+      bytes += k.bytes();
+    }
+    return bytes;
+  }
+
+  std::string stats() const override {
+    if (_accepted == 0) {
+      return "";
+    }
+    char text[256];
+    snprintf(text, sizeof(text),
+             "%ld steps for %ld nominal steps of %g (%ld rejected), dt %.3g to %.3g, "
+             "stability limit %.3g, %ld rate evaluations",
+             _accepted, _nominalSteps, _config.simArgs.timeStep, _rejected, _minUsed, _maxUsed,
+             _maxStep, _evaluations);
+    return text;
+  }
+
+  void step(int steps) override {
+    const double target = double(steps) * _config.simArgs.timeStep;
+    _nominalSteps += steps;
+    _pool.run([&](int thread) {
+      int rowBegin, rowEnd;
+      splitRange(_config.height, _pool.size(), thread, rowBegin, rowEnd);
+      if (!_rateValid) {
+        evaluate(_y, _k[0], rowBegin, rowEnd, thread); // k1 at the start
+      }
+      double elapsed = 0.0;
+      while (elapsed < target) {
+        // Every thread computes the same h from shared state.
+        const double h = std::min(_dt, target - elapsed);
+        const bool clipped = h < _dt;
+        attempt(float(h), rowBegin, rowEnd, thread);
+        if (thread == 0) {
+          double error = *std::max_element(_partialError.begin(), _partialError.end());
+          _accept = error <= _tolerance;
+          double factor = error > 0.0 ? kControlSafety * std::cbrt(_tolerance / error)
+                                      : kMaxFactor;
+          factor = std::clamp(factor, kMinFactor, kMaxFactor);
+          if (_accept) {
+            _accepted++;
+            _minUsed = _accepted == 1 ? h : std::min(_minUsed, h);
+            _maxUsed = std::max(_maxUsed, h);
+            // A step clipped to the target says little about the next one.
+            if (!clipped || factor < 1.0) {
+              _dt = std::min(h * factor, _maxStep);
+            }
+          } else {
+            _rejected++;
+            _dt = h * factor;
+          }
+        }
+        _pool.barrier();
+        if (_accept) {
+          elapsed += h;
+          if (thread == 0) {
+            std::swap(_y, _next);
+            std::swap(_k[0], _k[3]); // first same as last
+          }
+          _pool.barrier();
+        }
+      }
+    });
+    _rateValid = true;
+  }
+
+private:
+  PlaneKernel _kernel;
+  ThreadPool _pool;
+  double _tolerance;
+  double _maxStep = 0.0;
+  double _dt = 0.0; // proposed size of the next step
+  PlaneGrid _y;     // current state
+  PlaneGrid _stage; // stage input
+  PlaneGrid _next;  // third-order solution of the step being tried
+  PlaneGrid _k[4];  // stage rates; _k[0] holds the rate of _y between calls
+  bool _rateValid = false;
+  bool _accept = false;
+  std::vector<double> _partialError; // per thread
+  long _accepted = 0;
+  long _rejected = 0;
+  long _nominalSteps = 0;
+  long _evaluations = 0;
+  double _minUsed = 0.0;
+  double _maxUsed = 0.0;
+  std::string _name;
+
+  // Rates of `in` into `rate` for this thread's rows. Waits for every row of
+  // `in` before filling its ghosts, and for every rate row at the end.
+  void evaluate(PlaneGrid &in, PlaneGrid &rate, int rowBegin, int rowEnd, int thread) {
+    _pool.barrier();
+    fillGhostColumns<Boundary>(in, rowBegin, rowEnd);
+    if (thread == 0) {
+      fillGhostRows<Boundary>(in);
+      _evaluations++;
+    }
+    _pool.barrier();
+    for (int y = rowBegin; y < rowEnd; y++) {
+      PlaneRow row = {in.rowA(y - 1), in.rowA(y),     in.rowA(y + 1), in.rowB(y - 1),
+                      in.rowB(y),     in.rowB(y + 1), rate.rowA(y),   rate.rowB(y)};
+      _kernel(row, _config.width, _config.simArgs);
+    }
+    _pool.barrier();
+  }
+
+  // out = _y + h * sum(c[i] * _k[i]) over the first `terms` rates, for this
+  // thread's rows, A and B planes alike.
+  void combine(PlaneGrid &out, float h, const float *c, int terms, int rowBegin, int rowEnd) {
+    const int width = _config.width;
+    for (int y = rowBegin; y < rowEnd; y++) {
+      for (int plane = 0; plane < 2; plane++) {
+        auto row = [&](PlaneGrid &grid) { return plane ? grid.rowB(y) : grid.rowA(y); };
+        const float *base = row(_y);
+        float *dst = row(out);
+        const float *k0 = row(_k[0]);
+        const float *k1 = row(_k[1]);
+        const float *k2 = row(_k[2]);
+        const float c0 = h * c[0];
+        const float c1 = terms > 1 ? h * c[1] : 0.0f;
+        const float c2 = terms > 2 ? h * c[2] : 0.0f;
+        for (int x = 0; x < width; x++) {
+          dst[x] = base[x] + c0 * k0[x] + c1 * k1[x] + c2 * k2[x];
+        }
+      }
+    }
+  }
+
+  // One Bogacki-Shampine step of size h from _y into _next, with k4 = f(_next)
+  // and this thread's largest error estimate in _partialError.
+  void attempt(float h, int rowBegin, int rowEnd, int thread) {
+    static const float c2[] = {0.5f};
+    static const float c3[] = {0.0f, 0.75f};
+    static const float c4[] = {2.0f / 9.0f, 1.0f / 3.0f, 4.0f / 9.0f};
+    // Third order minus embedded second order.
+    const float e[] = {h * (-5.0f / 72.0f), h * (1.0f / 12.0f), h * (1.0f / 9.0f),
+                       h * (-1.0f / 8.0f)};
+    combine(_stage, h, c2, 1, rowBegin, rowEnd);
+    evaluate(_stage, _k[1], rowBegin, rowEnd, thread);
+    combine(_stage, h, c3, 2, rowBegin, rowEnd);
+    evaluate(_stage, _k[2], rowBegin, rowEnd, thread);
+    combine(_next, h, c4, 3, rowBegin, rowEnd);
+    evaluate(_next, _k[3], rowBegin, rowEnd, thread);
+    float error = 0.0f;
+    for (int y = rowBegin; y < rowEnd; y++) {
+      for (int plane = 0; plane < 2; plane++) {
+        auto row = [&](PlaneGrid &grid) { return plane ? grid.rowB(y) : grid.rowA(y); };
+        const float *k0 = row(_k[0]);
+        const float *k1 = row(_k[1]);
+        const float *k2 = row(_k[2]);
+        const float *k3 = row(_k[3]);
+        for (int x = 0; x < _config.width; x++) {
+          float local = e[0] * k0[x] + e[1] * k1[x] + e[2] * k2[x] + e[3] * k3[x];
+          error = std::max(error, std::abs(local));
+        }
+      }
+    }
+    _partialError[thread] = error;
+    _pool.barrier();
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Engine> makeAdaptiveEngine(const Config &config, const EngineOptions &options) {
+  return withBoundary(config.boundary, [&](auto boundary) -> std::unique_ptr<Engine> {
+    return std::make_unique<AdaptiveEngine<decltype(boundary)>>(config, options);
+  });
+}
@@ -0,0 +1,240 @@
+#include "BatchEngine.hpp"
+#include <stdexcept>
+#include "Boundary.hpp"
+#include "Kernels.hpp"
+#include "Planes.hpp"
+#include "ThreadPool.hpp"
+#ifdef RD_HAVE_AVX_KERNELS
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+// Flushes denormal results and inputs to zero on the calling thread while in
+// scope. A configuration that dies out decays B through the denormal range,
+// where every operation takes a microcode assist, and in a batch that one lane
+// stalls the vector shared with every other configuration. Only values below
+// about 1e-38 change.
+class FlushDenormals {
+public:
+#ifdef RD_HAVE_AVX_KERNELS
+  FlushDenormals() : _saved(_mm_getcsr()) {
+    _mm_setcsr(_saved | kFlushToZero | kDenormalsAreZero);
+  }
+  ~FlushDenormals() { _mm_setcsr(_saved); }
+
+private:
+  static constexpr unsigned kFlushToZero = 0x8000;
+  static constexpr unsigned kDenormalsAreZero = 0x0040;
+  unsigned _saved;
+#endif
+};
+
+// Lane-interleaved planes of one lane group: `lanes` floats per cell, one
+// ghost cell (a full set of lanes) around the grid, rows aligned like
+// PlaneGrid.
+struct BatchPlanes {
+  int width = 0;
+  int height = 0;
+  int lanes = 0;
+  int stride = 0; // floats per row
+  AlignedFloats a;
+  AlignedFloats b;
+
+  BatchPlanes() = default;
+  BatchPlanes(int w, int h, int l)
+      : width(w), height(h), lanes(l), stride(roundUpFloats((w + 2) * l)),
+        a(size_t(stride) * (h + 2), 0.0f), b(size_t(stride) * (h + 2), 0.0f) {}
+
+  float *rowA(int y) { return a.data() + size_t(y + 1) * stride + lanes; }
+  float *rowB(int y) { return b.data() + size_t(y + 1) * stride + lanes; }
+  const float *rowA(int y) const { return a.data() + size_t(y + 1) * stride + lanes; }
+  const float *rowB(int y) const { return b.data() + size_t(y + 1) * stride + lanes; }
+
+  StateView view(int lane) const {
+    return {width, height, rowA(0) + lane, rowB(0) + lane, lanes, stride};
+  }
+
+  size_t bytes() const { return (a.size() + b.size()) * sizeof(float); }
+};
+
+// Ghost cells of one lane-interleaved plane row: whole cells, all lanes at once.
+template <class Boundary>
+void fillBatchGhostColumns(float *row, int w, int lanes, float fixedValue) {
+  float *left = row - lanes;
+  float *right = row + size_t(w) * lanes;
+  if constexpr (Boundary::fixed) {
+    std::fill(left, left + lanes, fixedValue);
+    std::fill(right, right + lanes, fixedValue);
+  } else {
+    const float *leftSrc = row + size_t(Boundary::source(-1, w)) * lanes;
+    const float *rightSrc = row + size_t(Boundary::source(w, w)) * lanes;
+    std::copy(leftSrc, leftSrc + lanes, left);
+    std::copy(rightSrc, rightSrc + lanes, right);
+  }
+}
+
+// One ghost row, corners included, from interior cells only, so it can run
+// concurrently with fillBatchGhostColumns.
+template <class Boundary>
+void fillBatchGhostRow(float *dst, const float *src, int w, int lanes, float fixedValue) {
+  if constexpr (Boundary::fixed) {
+    std::fill(dst - lanes, dst + size_t(w + 1) * lanes, fixedValue);
+  } else {
+    std::copy(src, src + size_t(w) * lanes, dst);
+    const float *leftSrc = src + size_t(Boundary::source(-1, w)) * lanes;
+    const float *rightSrc = src + size_t(Boundary::source(w, w)) * lanes;
+    std::copy(leftSrc, leftSrc + lanes, dst - lanes);
+    std::copy(rightSrc, rightSrc + lanes, dst + size_t(w) * lanes);
+  }
+}
+
+template <class Boundary>
+class LaneBatchEngine : public BatchEngine {
+public:
+  LaneBatchEngine(const std::vector<Config> &configs, const EngineOptions &options)
+      : BatchEngine(configs), _kernel(batchKernel(options.isa)), _pool(options.threads) {
+    const int lanes = batchLanes(options.isa);
+    const Config &first = configs.front();
+    _groups.resize((configs.size() + lanes - 1) / lanes);
+    for (size_t g = 0; g < _groups.size(); g++) {
+      Group &group = _groups[g];
+      for (BatchPlanes &planes : group.planes) {
+        planes = BatchPlanes(first.width, first.height, lanes);
+      }
+      group.args.lanes = lanes;
+      for (int l = 0; l < lanes; l++) {
+        size_t i = std::min(g * lanes + l, configs.size() - 1);
+        group.args.lane[l] = configs[i].simArgs;
+      }
+    }
+    _name = "batch/" + std::string(Boundary::name) + "/" + isaName(resolveIsa(options.isa)) +
+            "/" + std::to_string(_pool.size()) + "t/" + std::to_string(configs.size()) + "x" +
+            std::to_string(lanes) + " lanes";
+  }
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(int i, const Grid &grid) override {
+    BatchPlanes &planes = plane(i);
+    const int lane = i % planes.lanes;
+    for (int y = 0; y < grid.height; y++) {
+      const float *src = grid.row(y);
+      float *a = planes.rowA(y) + lane;
+      float *b = planes.rowB(y) + lane;
+      for (int x = 0; x < grid.width; x++) {
+        a[size_t(x) * planes.lanes] = src[2 * x];
+        b[size_t(x) * planes.lanes] = src[2 * x + 1];
+      }
+    }
+  }
+
+  StateView stateView(int i) const override {
+    const BatchPlanes &planes = _groups[i / lanes()].planes[_current];
+    return planes.view(i % planes.lanes);
+  }
+
+  size_t stateBytes() const override {
+    size_t bytes = 0;
+    for (const Group &group : _groups) {
+      bytes += group.planes[0].bytes() + group.planes[1].bytes();
+    }
+    return bytes;
+  }
+
+  void step(int steps) override {
+    const int width = _configs.front().width;
+    const int height = _configs.front().height;
+    _pool.run([&](int thread) {
+      FlushDenormals flush;
+      int rowBegin, rowEnd;
+      splitRange(height, _pool.size(), thread, rowBegin, rowEnd);
+      int current = _current;
+      for (int s = 0; s < steps; s++) {
+        for (Group &group : _groups) {
+          BatchPlanes &in = group.planes[current];
+          const int lanes = in.lanes;
+          for (int y = rowBegin; y < rowEnd; y++) {
+            fillBatchGhostColumns<Boundary>(in.rowA(y), width, lanes, fixedA<Boundary>());
+            fillBatchGhostColumns<Boundary>(in.rowB(y), width, lanes, fixedB<Boundary>());
+          }
+          if (thread == 0) {
+            for (int dstY : {-1, height}) {
+              int srcY = 0;
+              if constexpr (!Boundary::fixed) {
+                srcY = Boundary::source(dstY, height);
+              }
+              fillBatchGhostRow<Boundary>(in.rowA(dstY), in.rowA(srcY), width, lanes,
+                                          fixedA<Boundary>());
+              fillBatchGhostRow<Boundary>(in.rowB(dstY), in.rowB(srcY), width, lanes,
+                                          fixedB<Boundary>());
+            }
+          }
+        }
+        _pool.barrier();
+        for (Group &group : _groups) {
+          BatchPlanes &in = group.planes[current];
+          BatchPlanes &out = group.planes[1 - current];
+          for (int y = rowBegin; y < rowEnd; y++) {
+            PlaneRow row = {in.rowA(y - 1), in.rowA(y),     in.rowA(y + 1), in.rowB(y - 1),
+                            in.rowB(y),     in.rowB(y + 1), out.rowA(y),    out.rowB(y)};
+            _kernel(row, width, group.args);
+          }
+        }
+        current = 1 - current;
+        _pool.barrier();
+      }
+    });
+    _current = (_current + steps) % 2;
+  }
+
+private:
+  struct Group {
+    BatchPlanes planes[2]; // ping-pong
+    BatchArgs args;
+  };
+
+  BatchKernel _kernel;
+  ThreadPool _pool;
+  std::vector<Group> _groups;
+  int _current = 0;
+  std::string _name;
+
+  int lanes() const { return _groups.front().args.lanes; }
+  BatchPlanes &plane(int i) { return _groups[i / lanes()].planes[_current]; }
+};
+
+} // namespace
+
+std::unique_ptr<BatchEngine> makeSeededBatchEngine(const std::vector<Config> &configs,
+                                                   const EngineOptions &options) {
+  if (configs.empty()) {
+    throw std::invalid_argument("Parameter sweep needs at least one configuration");
+  }
+  const Config &first = configs.front();
+  for (const Config &config : configs) {
+    if (config.width != first.width || config.height != first.height ||
+        config.boundary != first.boundary) {
+      throw std::invalid_argument("Parameter sweep configurations must share size and "
+                                  "boundary: " + config.name + " differs from " + first.name);
+    }
+    if (config.rates.active()) {
+      throw std::invalid_argument("Parameter sweep configurations must use uniform feed and "
+                                  "kill rates: " + config.name + " varies them over the grid");
+    }
+    if (!config.model.grayScott()) {
+      throw std::invalid_argument("Parameter sweeps only run the Gray-Scott model, " +
+                                  config.name + " uses " + config.model.name);
+    }
+  }
+  std::unique_ptr<BatchEngine> engine =
+      withBoundary(first.boundary, [&](auto boundary) -> std::unique_ptr<BatchEngine> {
+        return std::make_unique<LaneBatchEngine<decltype(boundary)>>(configs, options);
+      });
+  for (int i = 0; i < engine->size(); i++) {
+    Grid seed(first.width, first.height);
+    seedGrid(seed, configs[i].noiseDensity, options.seed);
+    engine->setState(i, seed);
+  }
+  return engine;
+}
@@ -0,0 +1,48 @@
+#pragma once
+// Parameter sweep engine: advances a batch of same-sized grids, each with its
+// own SimArgs, in lockstep. The grids are interleaved lane by lane (see
+// BatchArgs in Kernels.hpp), so one vector holds the same cell of 8 or 16
+// configurations and every load, index computation and ghost refresh is
+// shared by the whole batch. Larger batches are split into lane groups of one
+// vector each; spare lanes of the last group repeat its last configuration.
+//
+// Each lane matches soa bit for bit at the same ISA, except that the batch
+// flushes denormals (see FlushDenormals). The batch pays on small grids: on
+// one core a 16-point mazes grid runs 3.7x faster than 16 soa runs (that
+// also flush denormals) at 16x16, 2x at 32x32 and 1.3x at 64x64, but 0.7x at
+// 128x128, where 16 grids no longer fit the L2 cache soa's tiles stay in.
+
+#include <memory>
+#include <vector>
+#include "Engine.hpp"
+
+class BatchEngine {
+public:
+  virtual ~BatchEngine() = default;
+
+  virtual const char *name() const = 0;
+
+  int size() const { return static_cast<int>(_configs.size()); }
+  const Config &config(int i) const { return _configs[i]; }
+
+  // Per-configuration state, in the same terms as Engine.
+  virtual void setState(int i, const Grid &grid) = 0;
+  virtual StateView stateView(int i) const = 0;
+  void getState(int i, Grid &grid) const { stateView(i).copyTo(grid); }
+
+  virtual size_t stateBytes() const = 0;
+
+  // Advance every configuration by `steps` updates of its own time step.
+  virtual void step(int steps) = 0;
+
+protected:
+  explicit BatchEngine(std::vector<Config> configs) : _configs(std::move(configs)) {}
+
+  std::vector<Config> _configs;
+};
+
+// Creates the batch and seeds every grid like makeSeededEngine. All configs
+// must share width, height and boundary and run Gray-Scott with uniform rates;
+// throws std::invalid_argument if not.
+std::unique_ptr<BatchEngine> makeSeededBatchEngine(const std::vector<Config> &configs,
+                                                   const EngineOptions &options);
@@ -0,0 +1,256 @@
+#pragma once
+// Boundary conditions as compile-time policies. An engine is instantiated per
+// policy, so the choice costs nothing inside the stepping loop: padded
+// engines only differ in how the ghost border is refreshed, and the reference
+// engine in how it looks up out-of-range neighbours.
+//
+//   periodic   opposite edges are neighbours (the torus the shader wraps on)
+//   neumann    zero-flux walls: ghosts mirror the cells just inside the edge
+//   dirichlet  fixed walls at the trivial steady state A = 1, B = 0
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "FixedPoint.hpp"
+#include "Grid.hpp"
+#include "HalfPlanes.hpp"
+#include "Planes.hpp"
+
+struct PeriodicBoundary {
+  static constexpr const char *name = "periodic";
+  static constexpr bool fixed = false;
+  // Source coordinate for an out-of-range coordinate i in [-n, 2n).
+  static int source(int i, int n) { return (i + n) % n; }
+};
+
+struct NeumannBoundary {
+  static constexpr const char *name = "neumann";
+  static constexpr bool fixed = false;
+  static int source(int i, int n) {
+    int mirrored = i < 0 ? -i - 1 : 2 * n - i - 1;
+    return mirrored < 0 ? 0 : mirrored >= n ? n - 1 : mirrored;
+  }
+};
+
+struct DirichletBoundary {
+  static constexpr const char *name = "dirichlet";
+  static constexpr bool fixed = true;
+  static constexpr float valueA = 1.0f;
+  static constexpr float valueB = 0.0f;
+};
+
+// Wall values of fixed policies, 0 for the others (unused there).
+template <class Boundary>
+constexpr float fixedA() {
+  if constexpr (Boundary::fixed) {
+    return Boundary::valueA;
+  }
+  return 0.0f;
+}
+
+template <class Boundary>
+constexpr float fixedB() {
+  if constexpr (Boundary::fixed) {
+    return Boundary::valueB;
+  }
+  return 0.0f;
+}
+
+// Value of channel c (0 = A, 1 = B) at (x, y), where x and y may be one cell
+// outside the grid. Used by the reference engine for every neighbour.
+template <class Boundary>
+inline float boundaryCell(const Grid &grid, int x, int y, int c) {
+  const int w = grid.width;
+  const int h = grid.height;
+  if constexpr (Boundary::fixed) {
+    if (x < 0 || x >= w || y < 0 || y >= h) {
+      return c == 0 ? Boundary::valueA : Boundary::valueB;
+    }
+    return grid.row(y)[2 * x + c];
+  } else if constexpr (std::is_same_v<Boundary, PeriodicBoundary>) {
+    // Unconditional modulo, the classic wrapped lookup.
+    return grid.row((y + h) % h)[2 * ((x + w) % w) + c];
+  } else {
+    int sx = x < 0 || x >= w ? Boundary::source(x, w) : x;
+    int sy = y < 0 || y >= h ? Boundary::source(y, h) : y;
+    return grid.row(sy)[2 * sx + c];
+  }
+}
+
+// Left and right ghost columns of rows [y0, y1). Assumes ghost <= width.
+template <class Boundary>
+inline void fillGhostColumns(PaddedGrid &grid, int y0, int y1) {
+  const int w = grid.width;
+  const int g = grid.ghost;
+  for (int y = y0; y < y1; y++) {
+    float *row = grid.row(y);
+    for (int j = 1; j <= g; j++) {
+      float *left = row - 2 * j;
+      float *right = row + 2 * (w - 1 + j);
+      if constexpr (Boundary::fixed) {
+        left[0] = right[0] = Boundary::valueA;
+        left[1] = right[1] = Boundary::valueB;
+      } else {
+        const float *leftSrc = row + 2 * Boundary::source(-j, w);
+        const float *rightSrc = row + 2 * Boundary::source(w - 1 + j, w);
+        left[0] = leftSrc[0];
+        left[1] = leftSrc[1];
+        right[0] = rightSrc[0];
+        right[1] = rightSrc[1];
+      }
+    }
+  }
+}
+
+// Top and bottom ghost rows, corners included. Reads interior cells only, so
+// it can run concurrently with fillGhostColumns.
+template <class Boundary>
+inline void fillGhostRows(PaddedGrid &grid) {
+  const int w = grid.width;
+  const int h = grid.height;
+  const int g = grid.ghost;
+  for (int j = 1; j <= g; j++) {
+    for (int dstY : {-j, h - 1 + j}) {
+      float *dst = grid.row(dstY) - 2 * g;
+      if constexpr (Boundary::fixed) {
+        for (int x = 0; x < w + 2 * g; x++) {
+          dst[2 * x] = Boundary::valueA;
+          dst[2 * x + 1] = Boundary::valueB;
+        }
+      } else {
+        const float *src = grid.row(Boundary::source(dstY, h));
+        std::copy(src, src + 2 * w, dst + 2 * g);
+        for (int i = 1; i <= g; i++) {
+          const float *leftSrc = src + 2 * Boundary::source(-i, w);
+          const float *rightSrc = src + 2 * Boundary::source(w - 1 + i, w);
+          dst[2 * (g - i)] = leftSrc[0];
+          dst[2 * (g - i) + 1] = leftSrc[1];
+          dst[2 * (g + w - 1 + i)] = rightSrc[0];
+          dst[2 * (g + w - 1 + i) + 1] = rightSrc[1];
+        }
+      }
+    }
+  }
+}
+
+// --- Structure-of-arrays planes ---
+
+// Ghost cells left and right of one plane row, float or half.
+template <class Boundary, class T>
+inline void fillPlaneGhostColumns(T *row, int w, int g, T fixedValue) {
+  for (int j = 1; j <= g; j++) {
+    if constexpr (Boundary::fixed) {
+      row[-j] = fixedValue;
+      row[w - 1 + j] = fixedValue;
+    } else {
+      row[-j] = row[Boundary::source(-j, w)];
+      row[w - 1 + j] = row[Boundary::source(w - 1 + j, w)];
+    }
+  }
+}
+
+// One ghost row of a plane, corners included, from interior cells only.
+template <class Boundary, class T>
+inline void fillPlaneGhostRow(T *dst, const T *src, int w, int g, T fixedValue) {
+  if constexpr (Boundary::fixed) {
+    std::fill(dst - g, dst + w + g, fixedValue);
+  } else {
+    std::copy(src, src + w, dst);
+    for (int i = 1; i <= g; i++) {
+      dst[-i] = src[Boundary::source(-i, w)];
+      dst[w - 1 + i] = src[Boundary::source(w - 1 + i, w)];
+    }
+  }
+}
+
+template <class Boundary>
+inline void fillGhostColumns(PlaneGrid &grid, int y0, int y1) {
+  for (int y = y0; y < y1; y++) {
+    fillPlaneGhostColumns<Boundary>(grid.rowA(y), grid.width, grid.ghost, fixedA<Boundary>());
+    fillPlaneGhostColumns<Boundary>(grid.rowB(y), grid.width, grid.ghost, fixedB<Boundary>());
+  }
+}
+
+template <class Boundary>
+inline void fillGhostRows(PlaneGrid &grid) {
+  const int w = grid.width;
+  const int h = grid.height;
+  const int g = grid.ghost;
+  for (int j = 1; j <= g; j++) {
+    for (int dstY : {-j, h - 1 + j}) {
+      int srcY = 0;
+      if constexpr (!Boundary::fixed) {
+        srcY = Boundary::source(dstY, h);
+      }
+      fillPlaneGhostRow<Boundary>(grid.rowA(dstY), grid.rowA(srcY), w, g, fixedA<Boundary>());
+      fillPlaneGhostRow<Boundary>(grid.rowB(dstY), grid.rowB(srcY), w, g, fixedB<Boundary>());
+    }
+  }
+}
+
+// 16-bit planes (HalfPlaneGrid, FixedPlaneGrid): the same, with the wall
+// values encoded once in the grid's format.
+template <class Boundary, class CodedGrid>
+inline void fillCodedGhostColumns(CodedGrid &grid, int y0, int y1) {
+  const auto wallA = grid.encodeA(fixedA<Boundary>());
+  const auto wallB = grid.encode(fixedB<Boundary>());
+  for (int y = y0; y < y1; y++) {
+    fillPlaneGhostColumns<Boundary>(grid.rowA(y), grid.width, grid.ghost, wallA);
+    fillPlaneGhostColumns<Boundary>(grid.rowB(y), grid.width, grid.ghost, wallB);
+  }
+}
+
+template <class Boundary, class CodedGrid>
+inline void fillCodedGhostRows(CodedGrid &grid) {
+  const int w = grid.width;
+  const int h = grid.height;
+  const int g = grid.ghost;
+  const auto wallA = grid.encodeA(fixedA<Boundary>());
+  const auto wallB = grid.encode(fixedB<Boundary>());
+  for (int j = 1; j <= g; j++) {
+    for (int dstY : {-j, h - 1 + j}) {
+      int srcY = 0;
+      if constexpr (!Boundary::fixed) {
+        srcY = Boundary::source(dstY, h);
+      }
+      fillPlaneGhostRow<Boundary>(grid.rowA(dstY), grid.rowA(srcY), w, g, wallA);
+      fillPlaneGhostRow<Boundary>(grid.rowB(dstY), grid.rowB(srcY), w, g, wallB);
+    }
+  }
+}
+
+template <class Boundary>
+inline void fillGhostColumns(HalfPlaneGrid &grid, int y0, int y1) {
+  fillCodedGhostColumns<Boundary>(grid, y0, y1);
+}
+
+template <class Boundary>
+inline void fillGhostRows(HalfPlaneGrid &grid) {
+  fillCodedGhostRows<Boundary>(grid);
+}
+
+template <class Boundary>
+inline void fillGhostColumns(FixedPlaneGrid &grid, int y0, int y1) {
+  fillCodedGhostColumns<Boundary>(grid, y0, y1);
+}
+
+template <class Boundary>
+inline void fillGhostRows(FixedPlaneGrid &grid) {
+  fillCodedGhostRows<Boundary>(grid);
+}
+
+// Calls fn(Policy{}) with the policy named by `name` and returns its result.
+template <class Fn>
+auto withBoundary(const std::string &name, Fn &&fn) {
+  if (name == "periodic") {
+    return fn(PeriodicBoundary{});
+  }
+  if (name == "neumann") {
+    return fn(NeumannBoundary{});
+  }
+  if (name == "dirichlet") {
+    return fn(DirichletBoundary{});
+  }
+  throw std::invalid_argument("Unknown boundary condition: " + name);
+}
@@ -0,0 +1,38 @@
+#pragma once
+// Data cache sizes used to size tiles. Falls back to conservative defaults
+// when the OS does not report them.
+
+#include <cstddef>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+
+// Size in bytes of the level 1, 2 or 3 data cache of one core (level 3 is
+// usually shared).
+inline size_t cacheSize(int level) {
+  long bytes = 0;
+#ifdef __APPLE__
+  const char *keys[] = {"hw.l1dcachesize", "hw.l2cachesize", "hw.l3cachesize"};
+  if (level >= 1 && level <= 3) {
+    int64_t value = 0;
+    size_t len = sizeof(value);
+    if (sysctlbyname(keys[level - 1], &value, &len, nullptr, 0) == 0) {
+      bytes = static_cast<long>(value);
+    }
+  }
+#elif defined(_SC_LEVEL1_DCACHE_SIZE)
+  if (level == 1) {
+    bytes = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+  } else if (level == 2) {
+    bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  } else if (level == 3) {
+    bytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+  }
+#endif
+  if (bytes > 0) {
+    return static_cast<size_t>(bytes);
+  }
+  const size_t defaults[] = {32 * 1024, 512 * 1024, 8 * 1024 * 1024};
+  return defaults[(level < 1 ? 1 : level > 3 ? 3 : level) - 1];
+}
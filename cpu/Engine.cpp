@@ -0,0 +1,185 @@
+#include "Engine.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+namespace {
+
+// Engines that wrap in their inner loops rather than through a boundary policy.
+void requirePeriodic(const std::string &name, const Config &config) {
+  if (config.boundary != "periodic") {
+    throw std::invalid_argument("Engine " + name + " only supports periodic boundaries, " +
+                                config.name + " uses " + config.boundary);
+  }
+}
+
+// Every engine but scalar and field reads feed and kill from simArgs alone.
+void requireUniformRates(const std::string &name, const Config &config) {
+  const std::vector<std::string> names = engineNames();
+  if (config.rates.active() && name != "scalar" && name != "field" &&
+      std::find(names.begin(), names.end(), name) != names.end()) {
+    throw std::invalid_argument("Engine " + name + " only supports uniform feed and kill " +
+                                "rates, " + config.name + " varies them over the grid");
+  }
+}
+
+// Volumes (depth > 1) only run on the volume engine, see VolumeEngine.hpp,
+// and meshes on the mesh engine, see MeshEngine.hpp.
+void requireFlat(const std::string &name, const Config &config) {
+  if (config.depth > 1) {
+    throw std::invalid_argument("Engine " + name + " is 2D, " + config.name + " has " +
+                                std::to_string(config.depth) + " slices");
+  }
+  if (!config.mesh.empty()) {
+    throw std::invalid_argument("Engine " + name + " runs on a grid, " + config.name +
+                                " on the mesh " + config.mesh);
+  }
+}
+
+// Every engine but model, jit and bytecode runs Gray-Scott alone.
+void requireGrayScott(const std::string &name, const Config &config) {
+  const std::vector<std::string> names = engineNames();
+  if (!config.model.grayScott() && name != "model" && name != "jit" && name != "bytecode" &&
+      std::find(names.begin(), names.end(), name) != names.end()) {
+    throw std::invalid_argument("Engine " + name + " only runs the Gray-Scott model, " +
+                                config.name + " uses " + config.model.name);
+  }
+}
+
+// Every engine but stencil runs the 5-point laplacian.
+void requireFivePoint(const std::string &name, const Config &config) {
+  const std::vector<std::string> names = engineNames();
+  if (config.stencil != "5-point" && name != "stencil" &&
+      std::find(names.begin(), names.end(), name) != names.end()) {
+    throw std::invalid_argument("Engine " + name + " only runs the 5-point stencil, " +
+                                config.name + " uses " + config.stencil);
+  }
+}
+
+// Default implicit step as a fraction of the reaction step limit. The limit
+// only rules out overshoot: close to it the patterns drift well away from
+// soa's (adi at 0.9 ends mitosis with four times the mean B), while at this
+// fraction every preset forms its pattern.
+constexpr float kImplicitStepFraction = 0.3f;
+
+} // namespace
+
+float implicitTimeStep(const Config &config, const EngineOptions &options) {
+  const float limit = reactionStepLimit(config.simArgs);
+  if (options.implicitTimeStep <= 0.0f) {
+    return kImplicitStepFraction * limit;
+  }
+  if (options.implicitTimeStep > limit) {
+    char text[160];
+    snprintf(text, sizeof(text),
+             "Time step %g is past the reaction step limit %g of %s, where the explicit "
+             "reaction overshoots",
+             options.implicitTimeStep, limit, config.name.c_str());
+    throw std::invalid_argument(text);
+  }
+  return options.implicitTimeStep;
+}
+
+std::unique_ptr<Engine> makeEngine(const std::string &name, const Config &config,
+                                   const EngineOptions &options) {
+  requireUniformRates(name, config);
+  requireFlat(name, config);
+  requireGrayScott(name, config);
+  requireFivePoint(name, config);
+  if (name == "scalar") {
+    return makeScalarEngine(config, options);
+  }
+  if (name == "simd") {
+    requirePeriodic(name, config);
+    return makeSimdEngine(config, options);
+  }
+  if (name == "tiled") {
+    requirePeriodic(name, config);
+    return makeTiledEngine(config, options);
+  }
+  if (name == "temporal") {
+    requirePeriodic(name, config);
+    return makeTemporalEngine(config, options);
+  }
+  if (name == "ghost") {
+    return makeGhostEngine(config, options);
+  }
+  if (name == "soa") {
+    return makeSoaEngine(config, options);
+  }
+  if (name == "trapezoid") {
+    return makeTrapezoidEngine(config, options);
+  }
+  if (name == "wavefront") {
+    return makeWavefrontEngine(config, options);
+  }
+  if (name == "inplace") {
+    return makeInPlaceEngine(config, options);
+  }
+  if (name == "sparse") {
+    return makeSparseEngine(config, options);
+  }
+  if (name == "fp16") {
+    return makeHalfEngine(config, options, HalfFormat::Fp16);
+  }
+  if (name == "bf16") {
+    return makeHalfEngine(config, options, HalfFormat::Bf16);
+  }
+  if (name == "fixed16") {
+    return makeFixedEngine(config, options);
+  }
+  if (name == "adaptive") {
+    return makeAdaptiveEngine(config, options);
+  }
+  if (name == "adi") {
+    return makeAdiEngine(config, options);
+  }
+  if (name == "rkl") {
+    return makeRklEngine(config, options);
+  }
+  if (name == "field") {
+    return makeFieldEngine(config, options);
+  }
+  if (name == "stencil") {
+    return makeStencilEngine(config, options);
+  }
+  if (name == "hex") {
+    return makeHexEngine(config, options);
+  }
+  if (name == "model") {
+    return makeModelEngine(config, options);
+  }
+  if (name == "jit") {
+    return makeExpressionEngine(config, options, true);
+  }
+  if (name == "bytecode") {
+    return makeExpressionEngine(config, options, false);
+  }
+  if (name == "spectral") {
+    requirePeriodic(name, config);
+    return makeSpectralEngine(config, options, false);
+  }
+  if (name == "spectral-imex") {
+    requirePeriodic(name, config);
+    return makeSpectralEngine(config, options, true);
+  }
+  return nullptr;
+}
+
+std::vector<std::string> engineNames() {
+  return {"scalar", "simd", "tiled", "temporal", "ghost", "soa", "trapezoid", "wavefront",
+          "inplace", "sparse", "fp16", "bf16", "fixed16", "spectral", "spectral-imex",
+          "adaptive", "adi", "rkl", "field", "stencil", "hex", "model", "jit", "bytecode"};
+}
+
+std::unique_ptr<Engine> makeSeededEngine(const std::string &name, const Config &config,
+                                         const EngineOptions &options) {
+  std::unique_ptr<Engine> engine = makeEngine(name, config, options);
+  if (!engine) {
+    return nullptr;
+  }
+  Grid seed(config.width, config.height);
+  seedGrid(seed, config.noiseDensity, options.seed);
+  engine->seed(seed);
+  return engine;
+}
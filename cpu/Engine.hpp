@@ -0,0 +1,112 @@
+#pragma once
+// CPU simulation engines. Each engine is a headless counterpart of the
+// sim_main compute pass that Renderer::draw dispatches on the GPU.
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Config.hpp"
+#include "Grid.hpp"
+#include "Kernels.hpp"
+#include "Mesh.hpp"
+
+struct EngineOptions {
+  unsigned seed = 1;
+  // Row kernel instruction set; clamped to what the CPU supports.
+  Isa isa = detectIsa();
+  // Worker threads including the caller; 0 means one per hardware thread.
+  int threads = 0;
+  // Tile size in cells; 0 picks it from the cache size.
+  int tileWidth = 0;
+  int tileHeight = 0;
+  // Steps fused per tile pass by the temporal engine; 0 picks it from the cache size.
+  int timeBlock = 0;
+  // Largest per-step change of A or B below which the sparse engine lets a tile sleep.
+  float sparseThreshold = 1e-6f;
+  // Step size of the spectral, ADI and RKL engines in simulated time units; 0
+  // picks the default of implicitTimeStep(). Diffusion does not limit it (RKL
+  // adds stages instead), only the explicit reaction.
+  float implicitTimeStep = 0.0f;
+  // Largest local error per step (any cell, A or B) the adaptive engine accepts.
+  float tolerance = 1e-3f;
+  // Vertex order of the mesh engine.
+  MeshOrder meshOrder = MeshOrder::Rcm;
+};
+
+class Engine {
+public:
+  explicit Engine(const Config &config) : _config(config) {}
+  virtual ~Engine() = default;
+
+  virtual const char *name() const = 0;
+
+  // State is loaded in the interleaved RG32Float layout of the sim texture.
+  virtual void setState(const Grid &grid) = 0;
+  // Loads the initial state from the noise grid of seedGrid(). Engines whose
+  // model starts from another state map each cell's noise bit to it.
+  virtual void seed(const Grid &noise) { setState(noise); }
+  // Zero-copy view of the current state in the engine's own layout. Valid
+  // until the next step().
+  virtual StateView stateView() const = 0;
+  // Interleaved copy of the current state.
+  void getState(Grid &grid) const { stateView().copyTo(grid); }
+
+  // Memory held for simulation state (all buffers and scratch), in bytes.
+  virtual size_t stateBytes() const = 0;
+
+  // Engine-specific metrics for the report, empty if there are none.
+  virtual std::string stats() const { return ""; }
+
+  // Advance the simulation by `steps` updates.
+  virtual void step(int steps) = 0;
+
+  // Same amount of work as one Renderer::draw call.
+  void stepFrame() { step(_config.stepsPerFrame); }
+
+  const Config &config() const { return _config; }
+
+protected:
+  Config _config;
+};
+
+// Engine factory, keyed by the names listed in engineNames().
+// Returns nullptr for an unknown name and throws std::invalid_argument when
+// the engine cannot run the config (e.g. an unsupported boundary condition).
+std::unique_ptr<Engine> makeEngine(const std::string &name, const Config &config,
+                                   const EngineOptions &options);
+std::vector<std::string> engineNames();
+
+// Creates the engine and seeds it like Renderer::buildTextures does.
+std::unique_ptr<Engine> makeSeededEngine(const std::string &name, const Config &config,
+                                         const EngineOptions &options);
+
+// Step of the engines that take diffusion implicitly and the reaction
+// explicitly: options.implicitTimeStep, or a fraction of reactionStepLimit()
+// when it is 0. Throws std::invalid_argument for a step past the limit.
+float implicitTimeStep(const Config &config, const EngineOptions &options);
+
+// Individual engines
+std::unique_ptr<Engine> makeScalarEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeSimdEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeTiledEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeTemporalEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeGhostEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeSoaEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeTrapezoidEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeWavefrontEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeInPlaceEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeSparseEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeHalfEngine(const Config &config, const EngineOptions &options,
+                                       HalfFormat format);
+std::unique_ptr<Engine> makeFixedEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeAdaptiveEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeAdiEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeRklEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeFieldEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeStencilEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeHexEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeModelEngine(const Config &config, const EngineOptions &options);
+std::unique_ptr<Engine> makeExpressionEngine(const Config &config, const EngineOptions &options,
+                                             bool jit);
+std::unique_ptr<Engine> makeSpectralEngine(const Config &config, const EngineOptions &options,
+                                           bool imex);
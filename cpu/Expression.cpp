@@ -0,0 +1,621 @@
+#include "Expression.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace {
+
+// Cells per interpreter block: one instruction runs over this many cells,
+// long enough to amortise the dispatch and short enough for the live
+// registers to stay in L1.
+constexpr int kBlock = 512;
+constexpr int kMaxTemporaries = 32;
+constexpr int kMaxRegisters = 128;
+
+const char *const kDefaultSpecies[kMaxSpecies] = {"u", "v", "w", "z"};
+
+const char *const kGrayScottReactions[2] = {"feed * (1 - u) - u * v * v",
+                                            "u * v * v - (feed + kill) * v"};
+
+} // namespace
+
+// Parsed expression. `op` is one of + - * / ^, 'n' for negation, 'f' for a
+// function call, 'c' for a number and 's' / 'p' for a species / parameter.
+struct ExpressionNode {
+  char op = 'c';
+  float value = 0.0f;
+  int index = 0;
+  std::string function;
+  std::unique_ptr<ExpressionNode> lhs, rhs;
+};
+
+namespace {
+
+// Recursive descent over
+//   sum     = product (('+' | '-') product)*
+//   product = unary (('*' | '/') unary)*
+//   unary   = '-' unary | power
+//   power   = primary ('^' unary)?
+//   primary = number | name | name '(' sum (',' sum)? ')' | '(' sum ')'
+class Parser {
+public:
+  Parser(const std::string &text, const ExpressionModel &model, int reaction)
+      : _text(text), _model(model), _reaction(reaction) {}
+
+  std::unique_ptr<ExpressionNode> parse() {
+    std::unique_ptr<ExpressionNode> node = sum();
+    skipSpace();
+    if (_pos < _text.size()) {
+      fail("unexpected '" + std::string(1, _text[_pos]) + "'");
+    }
+    return node;
+  }
+
+private:
+  const std::string &_text;
+  const ExpressionModel &_model;
+  int _reaction;
+  size_t _pos = 0;
+
+  [[noreturn]] void fail(const std::string &what) const {
+    throw std::invalid_argument("Reaction " + std::to_string(_reaction) + " \"" + _text +
+                                "\": " + what + " at position " + std::to_string(_pos));
+  }
+
+  void skipSpace() {
+    while (_pos < _text.size() && isspace(static_cast<unsigned char>(_text[_pos]))) {
+      _pos++;
+    }
+  }
+
+  bool accept(char c) {
+    skipSpace();
+    if (_pos < _text.size() && _text[_pos] == c) {
+      _pos++;
+      return true;
+    }
+    return false;
+  }
+
+  static std::unique_ptr<ExpressionNode> binary(char op, std::unique_ptr<ExpressionNode> lhs,
+                                                std::unique_ptr<ExpressionNode> rhs) {
+    auto node = std::make_unique<ExpressionNode>();
+    node->op = op;
+    node->lhs = std::move(lhs);
+    node->rhs = std::move(rhs);
+    return node;
+  }
+
+  std::unique_ptr<ExpressionNode> sum() {
+    std::unique_ptr<ExpressionNode> node = product();
+    for (;;) {
+      if (accept('+')) {
+        node = binary('+', std::move(node), product());
+      } else if (accept('-')) {
+        node = binary('-', std::move(node), product());
+      } else {
+        return node;
+      }
+    }
+  }
+
+  std::unique_ptr<ExpressionNode> product() {
+    std::unique_ptr<ExpressionNode> node = unary();
+    for (;;) {
+      if (accept('*')) {
+        node = binary('*', std::move(node), unary());
+      } else if (accept('/')) {
+        node = binary('/', std::move(node), unary());
+      } else {
+        return node;
+      }
+    }
+  }
+
+  std::unique_ptr<ExpressionNode> unary() {
+    if (accept('-')) {
+      return binary('n', unary(), nullptr);
+    }
+    std::unique_ptr<ExpressionNode> node = primary();
+    if (accept('^')) {
+      node = binary('^', std::move(node), unary());
+    }
+    return node;
+  }
+
+  std::unique_ptr<ExpressionNode> primary() {
+    skipSpace();
+    if (accept('(')) {
+      std::unique_ptr<ExpressionNode> node = sum();
+      if (!accept(')')) {
+        fail("expected ')'");
+      }
+      return node;
+    }
+    if (_pos == _text.size()) {
+      fail("unexpected end");
+    }
+    auto node = std::make_unique<ExpressionNode>();
+    const char *begin = _text.c_str() + _pos;
+    if (isdigit(static_cast<unsigned char>(*begin)) || *begin == '.') {
+      char *end;
+      node->value = strtof(begin, &end);
+      _pos += end - begin;
+      return node;
+    }
+    size_t start = _pos;
+    while (_pos < _text.size() &&
+           (isalnum(static_cast<unsigned char>(_text[_pos])) || _text[_pos] == '_')) {
+      _pos++;
+    }
+    if (_pos == start) {
+      fail("unexpected '" + std::string(1, _text[_pos]) + "'");
+    }
+    const std::string name = _text.substr(start, _pos - start);
+    if (accept('(')) {
+      node->op = 'f';
+      node->function = name;
+      const bool pair = name == "min" || name == "max";
+      if (!pair && name != "exp" && name != "log" && name != "sqrt" && name != "abs") {
+        fail("unknown function " + name);
+      }
+      node->lhs = sum();
+      if (pair && !accept(',')) {
+        fail("expected ','");
+      }
+      if (pair) {
+        node->rhs = sum();
+      }
+      if (!accept(')')) {
+        fail("expected ')'");
+      }
+      return node;
+    }
+    for (size_t i = 0; i < _model.species.size(); i++) {
+      if (name == _model.species[i]) {
+        node->op = 's';
+        node->index = static_cast<int>(i);
+        return node;
+      }
+    }
+    for (size_t i = 0; i < _model.paramNames.size(); i++) {
+      if (name == _model.paramNames[i]) {
+        node->op = 'p';
+        node->index = static_cast<int>(i);
+        return node;
+      }
+    }
+    fail("unknown name " + name);
+  }
+};
+
+// Exponents of x ^ n expanded into products.
+bool smallPower(const ExpressionNode &node, int &n) {
+  if (node.op != '^' || node.rhs->op != 'c') {
+    return false;
+  }
+  n = static_cast<int>(node.rhs->value);
+  return float(n) == node.rhs->value && n >= 1 && n <= 4;
+}
+
+// A float literal that reads back exactly.
+std::string literal(float value) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.9ef", value);
+  return text;
+}
+
+std::string cppExpression(const ExpressionNode &node) {
+  switch (node.op) {
+  case 'c':
+    return literal(node.value);
+  case 's':
+    return "c" + std::to_string(node.index);
+  case 'p':
+    return "p" + std::to_string(node.index);
+  case 'n':
+    return "(-" + cppExpression(*node.lhs) + ")";
+  case 'f': {
+    static const char *const names[][2] = {{"exp", "expf"},   {"log", "logf"},
+                                           {"sqrt", "sqrtf"}, {"abs", "fabsf"},
+                                           {"min", "fminf"},  {"max", "fmaxf"}};
+    std::string call;
+    for (const auto &name : names) {
+      if (node.function == name[0]) {
+        call = name[1];
+      }
+    }
+    call += "(" + cppExpression(*node.lhs);
+    if (node.rhs) {
+      call += ", " + cppExpression(*node.rhs);
+    }
+    return call + ")";
+  }
+  case '^': {
+    int n;
+    if (smallPower(node, n)) {
+      // Same association as the interpreter: ((x * x) * x) * x.
+      const std::string x = cppExpression(*node.lhs);
+      std::string product = x;
+      for (int i = 1; i < n; i++) {
+        product = "(" + product + " * " + x + ")";
+      }
+      return product;
+    }
+    return "powf(" + cppExpression(*node.lhs) + ", " + cppExpression(*node.rhs) + ")";
+  }
+  default:
+    return "(" + cppExpression(*node.lhs) + " " + node.op + " " + cppExpression(*node.rhs) +
+           ")";
+  }
+}
+
+// One interpreter instruction over a block. The operands come in as restrict
+// parameters, the form GCC honours, so each loop vectorises without alias
+// checks; emit() never writes a register an instruction reads.
+template <class Op>
+void apply(float *__restrict dst, const float *__restrict a, const float *__restrict b, int n,
+           Op op) {
+  for (int i = 0; i < n; i++) {
+    dst[i] = op(a[i], b[i]);
+  }
+}
+
+// The step, in the operation order of the generated kernel.
+void diffuse(const float *__restrict up, const float *__restrict mid,
+             const float *__restrict down, const float *__restrict rate, float *__restrict out,
+             int n, float diffusion, float dt, bool clamp) {
+  for (int i = 0; i < n; i++) {
+    float c = mid[i];
+    float lap = up[i] + down[i] + mid[i - 1] + mid[i + 1] - 4.0f * c;
+    out[i] = c + dt * (diffusion * lap + rate[i]);
+  }
+  if (clamp) {
+    for (int i = 0; i < n; i++) {
+      out[i] = out[i] < 0.0f ? 0.0f : out[i] > 1.0f ? 1.0f : out[i];
+    }
+  }
+}
+
+// [A-Za-z_][A-Za-z0-9_]*. Names end up in the source handed to the JIT
+// compiler, so anything else is rejected rather than escaped.
+bool isIdentifier(const std::string &name) {
+  if (name.empty() || !(std::isalpha(static_cast<unsigned char>(name[0])) || name[0] == '_')) {
+    return false;
+  }
+  return std::all_of(name.begin(), name.end(), [](char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+  });
+}
+
+bool hasControlCharacters(const std::string &text) {
+  return std::any_of(text.begin(), text.end(),
+                     [](char c) { return std::iscntrl(static_cast<unsigned char>(c)); });
+}
+
+} // namespace
+
+ExpressionModel expressionModel(const Config &config) {
+  const ModelConfig &model = config.model;
+  ExpressionModel result;
+  result.args = {};
+  result.args.timeStep = config.simArgs.timeStep;
+  if (model.grayScott()) {
+    result.species = {"u", "v"};
+    result.reactions.assign(kGrayScottReactions, kGrayScottReactions + 2);
+    result.paramNames = {"feed", "kill"};
+    result.args.diffusion[0] = config.simArgs.diffA;
+    result.args.diffusion[1] = config.simArgs.diffB;
+    result.args.param[0] = config.simArgs.feed;
+    result.args.param[1] = config.simArgs.kill;
+    result.clamp = true;
+    return result;
+  }
+  if (model.name != "expression") {
+    throw std::invalid_argument(config.name + ": model " + model.name +
+                                " has no reaction expressions");
+  }
+  const size_t species = model.reactions.size();
+  if (species < 2 || species > size_t(kMaxSpecies)) {
+    throw std::invalid_argument(config.name + ": expression models need 2 to " +
+                                std::to_string(kMaxSpecies) + " reactions");
+  }
+  if (model.diffusion.size() != species) {
+    throw std::invalid_argument(config.name + ": expression model needs " +
+                                std::to_string(species) + " diffusion rates");
+  }
+  if (!model.species.empty() && model.species.size() != species) {
+    throw std::invalid_argument(config.name + ": expression model names " +
+                                std::to_string(model.species.size()) + " species for " +
+                                std::to_string(species) + " reactions");
+  }
+  if (model.params.size() > size_t(kMaxModelParams)) {
+    throw std::invalid_argument(config.name + ": expression models take at most " +
+                                std::to_string(kMaxModelParams) + " parameters");
+  }
+  for (const std::string &name : model.species) {
+    if (!isIdentifier(name)) {
+      throw std::invalid_argument(config.name + ": species name \"" + name +
+                                  "\" is not an identifier");
+    }
+  }
+  for (const auto &param : model.params) {
+    if (!isIdentifier(param.first)) {
+      throw std::invalid_argument(config.name + ": parameter name \"" + param.first +
+                                  "\" is not an identifier");
+    }
+  }
+  for (const std::string &reaction : model.reactions) {
+    if (hasControlCharacters(reaction)) {
+      throw std::invalid_argument(config.name + ": reaction \"" + reaction +
+                                  "\" contains control characters");
+    }
+  }
+  result.reactions = model.reactions;
+  result.species = model.species;
+  if (result.species.empty()) {
+    result.species.assign(kDefaultSpecies, kDefaultSpecies + species);
+  }
+  for (size_t s = 0; s < species; s++) {
+    result.args.diffusion[s] = model.diffusion[s];
+  }
+  for (const auto &[name, value] : model.params) {
+    result.args.param[result.paramNames.size()] = value;
+    result.paramNames.push_back(name);
+  }
+  result.clamp = model.clamp;
+  return result;
+}
+
+ReactionProgram::ReactionProgram(const ExpressionModel &model) : _model(model) {
+  for (size_t i = 0; i < model.paramNames.size(); i++) {
+    constant(model.args.param[i]);
+  }
+  for (size_t s = 0; s < model.reactions.size(); s++) {
+    _trees.push_back(Parser(model.reactions[s], _model, static_cast<int>(s)).parse());
+  }
+  // Literals become constants before any temporary is numbered.
+  struct Collect {
+    ReactionProgram &program;
+    void operator()(const ExpressionNode &node) {
+      if (node.op == 'c') {
+        program.constant(node.value);
+      }
+      if (node.lhs) {
+        (*this)(*node.lhs);
+      }
+      if (node.rhs) {
+        (*this)(*node.rhs);
+      }
+    }
+  } collect{*this};
+  for (const auto &tree : _trees) {
+    collect(*tree);
+  }
+  const int firstTemporary = static_cast<int>(model.species.size() + _constants.size());
+  for (const auto &tree : _trees) {
+    // Each rate keeps its register while the next ones are evaluated.
+    const int used = _temporaries;
+    _results.push_back(emit(*tree, firstTemporary + used));
+    if (_results.back() >= firstTemporary) {
+      _temporaries = std::max(_temporaries, _results.back() - firstTemporary + 1);
+    }
+  }
+  if (_temporaries > kMaxTemporaries || firstTemporary + _temporaries > kMaxRegisters) {
+    throw std::invalid_argument("Reactions need " + std::to_string(_constants.size()) +
+                                " constants and " + std::to_string(_temporaries) +
+                                " temporaries, more than the interpreter holds");
+  }
+  _blocks.resize(_constants.size() * kBlock);
+  for (size_t i = 0; i < _constants.size(); i++) {
+    std::fill_n(_blocks.begin() + i * kBlock, kBlock, _constants[i]);
+  }
+}
+
+ReactionProgram::~ReactionProgram() = default;
+
+int ReactionProgram::constant(float value) {
+  const int species = static_cast<int>(_model.species.size());
+  const int params = static_cast<int>(_model.paramNames.size());
+  for (size_t i = params; i < _constants.size(); i++) {
+    if (_constants[i] == value) {
+      return species + static_cast<int>(i);
+    }
+  }
+  _constants.push_back(value);
+  return species + static_cast<int>(_constants.size()) - 1;
+}
+
+// Emits code for `node` using temporaries from `firstFree` up and returns the
+// register holding its value. Registers are allocated like a stack, and an
+// instruction's operands are evaluated above its destination, so no
+// instruction writes a register it reads.
+int ReactionProgram::emit(const ExpressionNode &node, int firstFree) {
+  const int firstTemporary = static_cast<int>(_model.species.size() + _constants.size());
+  auto push = [&](Op op, int dst, int a, int b) {
+    _code.push_back({op, uint16_t(dst), uint16_t(a), uint16_t(b)});
+    _temporaries = std::max(_temporaries, dst - firstTemporary + 1);
+    return dst;
+  };
+  // Operands above firstFree; the second skips the register of the first.
+  auto operands = [&](const ExpressionNode &lhs, const ExpressionNode *rhs, int &a, int &b) {
+    a = emit(lhs, firstFree + 1);
+    b = rhs ? emit(*rhs, a == firstFree + 1 ? firstFree + 2 : firstFree + 1) : a;
+  };
+  int a, b;
+  switch (node.op) {
+  case 'c':
+    return constant(node.value);
+  case 's':
+    return node.index;
+  case 'p':
+    return static_cast<int>(_model.species.size()) + node.index;
+  case 'n':
+    a = emit(*node.lhs, firstFree + 1);
+    return push(Op::Neg, firstFree, a, a);
+  case 'f': {
+    operands(*node.lhs, node.rhs.get(), a, b);
+    const std::string &f = node.function;
+    const Op op = f == "exp"    ? Op::Exp
+                  : f == "log"  ? Op::Log
+                  : f == "sqrt" ? Op::Sqrt
+                  : f == "abs"  ? Op::Abs
+                  : f == "min"  ? Op::Min
+                                : Op::Max;
+    return push(op, firstFree, a, b);
+  }
+  case '^': {
+    int n;
+    if (smallPower(node, n)) {
+      if (n == 1) {
+        return emit(*node.lhs, firstFree);
+      }
+      a = emit(*node.lhs, firstFree + 2);
+      // ((x * x) * x) * x, alternating between two registers so that the
+      // last product lands in firstFree.
+      int product = a;
+      for (int k = 2; k <= n; k++) {
+        product = push(Op::Mul, firstFree + (n - k) % 2, product, a);
+      }
+      return product;
+    }
+    operands(*node.lhs, node.rhs.get(), a, b);
+    return push(Op::Pow, firstFree, a, b);
+  }
+  default:
+    operands(*node.lhs, node.rhs.get(), a, b);
+    return push(node.op == '+'   ? Op::Add
+                : node.op == '-' ? Op::Sub
+                : node.op == '*' ? Op::Mul
+                                 : Op::Div,
+                firstFree, a, b);
+  }
+}
+
+void ReactionProgram::stepRow(const ModelRow &row, int count) const {
+  const int species = static_cast<int>(_model.species.size());
+  const int constants = static_cast<int>(_constants.size());
+  alignas(64) float temporaries[kMaxTemporaries][kBlock];
+  const float *regs[kMaxRegisters];
+  float *temp[kMaxRegisters];
+  for (int i = 0; i < constants; i++) {
+    regs[species + i] = _blocks.data() + size_t(i) * kBlock;
+  }
+  for (int i = 0; i < _temporaries; i++) {
+    temp[species + constants + i] = temporaries[i];
+    regs[species + constants + i] = temporaries[i];
+  }
+  const ModelArgs &args = _model.args;
+  for (int x0 = 0; x0 < count; x0 += kBlock) {
+    const int n = std::min(kBlock, count - x0);
+    for (int s = 0; s < species; s++) {
+      regs[s] = row.mid[s] + x0;
+    }
+    for (const Instruction &in : _code) {
+      float *dst = temp[in.dst];
+      const float *a = regs[in.a];
+      const float *b = regs[in.b];
+      switch (in.op) {
+      case Op::Add:
+        apply(dst, a, b, n, [](float x, float y) { return x + y; });
+        break;
+      case Op::Sub:
+        apply(dst, a, b, n, [](float x, float y) { return x - y; });
+        break;
+      case Op::Mul:
+        apply(dst, a, b, n, [](float x, float y) { return x * y; });
+        break;
+      case Op::Div:
+        apply(dst, a, b, n, [](float x, float y) { return x / y; });
+        break;
+      case Op::Neg:
+        apply(dst, a, b, n, [](float x, float) { return -x; });
+        break;
+      case Op::Exp:
+        apply(dst, a, b, n, [](float x, float) { return expf(x); });
+        break;
+      case Op::Log:
+        apply(dst, a, b, n, [](float x, float) { return logf(x); });
+        break;
+      case Op::Sqrt:
+        apply(dst, a, b, n, [](float x, float) { return sqrtf(x); });
+        break;
+      case Op::Abs:
+        apply(dst, a, b, n, [](float x, float) { return fabsf(x); });
+        break;
+      case Op::Min:
+        apply(dst, a, b, n, [](float x, float y) { return fminf(x, y); });
+        break;
+      case Op::Max:
+        apply(dst, a, b, n, [](float x, float y) { return fmaxf(x, y); });
+        break;
+      case Op::Pow:
+        apply(dst, a, b, n, [](float x, float y) { return powf(x, y); });
+        break;
+      }
+    }
+    for (int s = 0; s < species; s++) {
+      diffuse(row.up[s] + x0, row.mid[s] + x0, row.down[s] + x0, regs[_results[s]],
+              row.out[s] + x0, n, args.diffusion[s], args.timeStep, _model.clamp);
+    }
+  }
+}
+
+std::string ReactionProgram::source() const {
+  const int species = static_cast<int>(_model.species.size());
+  std::string s = "// Generated by rd-cli from the reactions\n";
+  for (int i = 0; i < species; i++) {
+    s += "//   d" + _model.species[i] + "/dt = " + _model.reactions[i] + "\n";
+  }
+  s += "#include <math.h>\n\n";
+  s += "struct ModelRow {\n  const float *up[" + std::to_string(kMaxSpecies) + "], *mid[" +
+       std::to_string(kMaxSpecies) + "], *down[" + std::to_string(kMaxSpecies) +
+       "];\n  float *out[" + std::to_string(kMaxSpecies) + "];\n};\n\n";
+  s += "struct ModelArgs {\n  float diffusion[" + std::to_string(kMaxSpecies) +
+       "];\n  float param[" + std::to_string(kMaxModelParams) +
+       "];\n  float timeStep;\n};\n\n";
+  // Rows as restrict-qualified parameters, the form GCC and Clang reliably
+  // honour, so the loop vectorises without alias checks.
+  std::string params, call;
+  for (int i = 0; i < species; i++) {
+    const std::string n = std::to_string(i);
+    params += "const float *__restrict up" + n + ", const float *__restrict mid" + n +
+              ", const float *__restrict down" + n + ", float *__restrict out" + n + ",\n    ";
+    call += "row.up[" + n + "], row.mid[" + n + "], row.down[" + n + "], row.out[" + n + "], ";
+  }
+  s += "static void cells(" + params + "int count, const ModelArgs &args) {\n";
+  for (int i = 0; i < species; i++) {
+    const std::string n = std::to_string(i);
+    s += "  const float d" + n + " = args.diffusion[" + n + "];\n";
+  }
+  for (size_t i = 0; i < _model.paramNames.size(); i++) {
+    const std::string n = std::to_string(i);
+    s += "  const float p" + n + " = args.param[" + n + "]; // " + _model.paramNames[i] + "\n";
+  }
+  s += "  const float dt = args.timeStep;\n";
+  s += "  for (int x = 0; x < count; x++) {\n";
+  for (int i = 0; i < species; i++) {
+    const std::string n = std::to_string(i);
+    s += "    const float c" + n + " = mid" + n + "[x];\n";
+  }
+  for (int i = 0; i < species; i++) {
+    s += "    const float r" + std::to_string(i) + " = " + cppExpression(*_trees[i]) + ";\n";
+  }
+  for (int i = 0; i < species; i++) {
+    const std::string n = std::to_string(i);
+    s += "    float lap" + n + " = up" + n + "[x] + down" + n + "[x] + mid" + n + "[x - 1] + mid" +
+         n + "[x + 1] - 4.0f * c" + n + ";\n";
+    s += "    float n" + n + " = c" + n + " + dt * (d" + n + " * lap" + n + " + r" + n + ");\n";
+    if (_model.clamp) {
+      s += "    n" + n + " = n" + n + " < 0.0f ? 0.0f : n" + n + " > 1.0f ? 1.0f : n" + n + ";\n";
+    }
+    s += "    out" + n + "[x] = n" + n + ";\n";
+  }
+  s += "  }\n}\n\n";
+  s += "extern \"C\" void " + std::string(kReactionSymbol) +
+       "(const ModelRow &row, int count, const ModelArgs &args) {\n";
+  s += "  cells(" + call + "count, args);\n}\n";
+  return s;
+}
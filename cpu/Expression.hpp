@@ -0,0 +1,91 @@
+#pragma once
+// Reaction rates given as expressions in the config (model "expression"),
+// e.g. for Gray-Scott with species u, v and parameters feed, kill:
+//   "reactions": ["feed * (1 - u) - u * v * v", "u * v * v - (feed + kill) * v"]
+// Expressions use + - * / ^, parentheses, numbers, the species and parameter
+// names, and exp, log, sqrt, abs, min and max. Each step is
+//   c + dt (diffusion lap + rate)
+// per species, with the 5-point laplacian, clamped to [0, 1] if asked.
+//
+// Two back ends run them: ReactionProgram, a bytecode interpreter that
+// evaluates one instruction over a block of cells at a time, and
+// compileReaction(), which generates C++ for the row kernel, builds it with
+// the installed compiler and loads the shared object.
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Config.hpp"
+#include "Kernels.hpp"
+
+// An expression model resolved from a config. A Gray-Scott config resolves
+// to the Gray-Scott reactions above, so the expression engines can be
+// checked and timed against the built-in kernels on the usual presets.
+struct ExpressionModel {
+  std::vector<std::string> species;
+  std::vector<std::string> reactions;
+  std::vector<std::string> paramNames;
+  ModelArgs args;
+  bool clamp = false;
+};
+
+// Throws std::invalid_argument for a model that is neither "expression" nor
+// Gray-Scott, or more species or parameters than ModelArgs holds.
+ExpressionModel expressionModel(const Config &config);
+
+struct ExpressionNode;
+
+class ReactionProgram {
+public:
+  // Parses the reactions; throws std::invalid_argument on a syntax error or
+  // an unknown name, with the offending expression and position.
+  explicit ReactionProgram(const ExpressionModel &model);
+  ~ReactionProgram();
+
+  // Steps `count` cells of one row. Safe to call from several threads.
+  void stepRow(const ModelRow &row, int count) const;
+
+  // The row kernel as a C++ translation unit exporting kReactionSymbol.
+  std::string source() const;
+
+  size_t instructionCount() const { return _code.size(); }
+
+private:
+  enum class Op : uint8_t { Add, Sub, Mul, Div, Neg, Exp, Log, Sqrt, Abs, Min, Max, Pow };
+
+  // dst = op(a, b) over a block. Registers: species values, then constants
+  // (parameters and literals), then temporaries.
+  struct Instruction {
+    Op op;
+    uint16_t dst, a, b;
+  };
+
+  ExpressionModel _model;
+  std::vector<std::unique_ptr<ExpressionNode>> _trees; // one per species
+  std::vector<float> _constants;
+  std::vector<float> _blocks; // each constant repeated over a block
+  std::vector<Instruction> _code;
+  std::vector<int> _results; // register holding each species' rate
+  int _temporaries = 0;
+
+  int constant(float value);
+  int emit(const ExpressionNode &node, int firstFree);
+};
+
+// Name the generated kernel exports, with the ModelKernel signature.
+constexpr const char *kReactionSymbol = "rd_reaction_row";
+
+// Outcome of compileReaction(): the loaded kernel, or nullptr and why not.
+struct CompiledReaction {
+  ModelKernel kernel = nullptr;
+  std::string library; // path of the shared object
+  bool cached = false; // loaded from an earlier build
+  double seconds = 0;  // compile time
+  std::string error;
+};
+
+// Builds the program's kernel for `isa` with $RD_JIT_CXX, $CXX or c++, and
+// caches it by a hash of the source, compiler and flags in $RD_JIT_CACHE,
+// else $XDG_CACHE_HOME/rd-cli or ~/.cache/rd-cli. The library stays loaded
+// for the life of the process.
+CompiledReaction compileReaction(const ReactionProgram &program, Isa isa);
@@ -0,0 +1,75 @@
+// Expression engines: reactions read from the config (Expression.hpp) on one
+// plane per species. "jit" compiles them into a native row kernel and falls
+// back to the interpreter when that fails, e.g. without a compiler;
+// "bytecode" always interprets. The model engine hands expression models to
+// "jit".
+//
+// Both back ends evaluate in the same order without contraction and agree
+// bit for bit, so --verify --engine jit checks one against the other. A
+// cached jit build costs nothing; the first compile takes about 0.3 s. At
+// 1024x1024 on one core, coral as expressions runs at about 1.05
+// Gcell-updates/s on jit, within noise of model and soa, and at 0.18 to 0.3
+// on bytecode, against 0.07 for the scalar engine.
+
+#include <cstdio>
+#include "Expression.hpp"
+#include "SpeciesEngine.hpp"
+
+namespace {
+
+template <class Boundary>
+class ExpressionEngine : public SpeciesEngine<Boundary> {
+public:
+  ExpressionEngine(const Config &config, const EngineOptions &options,
+                   const ExpressionModel &model, bool jit)
+      : SpeciesEngine<Boundary>(config, options, static_cast<int>(model.species.size())),
+        _program(model), _args(model.args) {
+    std::string backend = "bytecode";
+    if (jit) {
+      CompiledReaction compiled = compileReaction(_program, options.isa);
+      _kernel = compiled.kernel;
+      if (_kernel) {
+        backend = "jit";
+        char built[32];
+        snprintf(built, sizeof(built), "compiled in %.2f s", compiled.seconds);
+        _stats = "kernel " + compiled.library + " (" + (compiled.cached ? "cached" : built) + ")";
+      } else {
+        _stats = "jit unavailable, interpreting: " + compiled.error + "; ";
+      }
+    }
+    if (!_kernel) {
+      _stats += std::to_string(_program.instructionCount()) + " bytecode instructions";
+    }
+    // The interpreter runs the same code whatever the requested ISA.
+    const Isa isa = _kernel ? resolveIsa(options.isa) : Isa::Scalar;
+    this->_name = backend + "/" + Boundary::name + "/" + isaName(isa) + "/" +
+                  std::to_string(this->_pool.size()) + "t";
+  }
+
+  std::string stats() const override { return _stats; }
+
+protected:
+  void stepRow(const ModelRow &row, int count) override {
+    if (_kernel) {
+      _kernel(row, count, _args);
+    } else {
+      _program.stepRow(row, count);
+    }
+  }
+
+private:
+  ReactionProgram _program;
+  ModelArgs _args;
+  ModelKernel _kernel = nullptr;
+  std::string _stats;
+};
+
+} // namespace
+
+std::unique_ptr<Engine> makeExpressionEngine(const Config &config, const EngineOptions &options,
+                                             bool jit) {
+  const ExpressionModel model = expressionModel(config);
+  return withBoundary(config.boundary, [&](auto boundary) -> std::unique_ptr<Engine> {
+    return std::make_unique<ExpressionEngine<decltype(boundary)>>(config, options, model, jit);
+  });
+}
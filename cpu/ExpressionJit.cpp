@@ -0,0 +1,156 @@
+// Runtime compilation of reaction expressions: the generated row kernel is
+// built into a shared object with the installed C++ compiler and loaded with
+// dlopen. Builds are cached by a hash of everything that goes into them, so
+// a given set of reactions compiles once per machine.
+
+#include <dlfcn.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include "Expression.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string environment(const char *name) {
+  const char *value = getenv(name);
+  return value ? value : "";
+}
+
+std::string compilerCommand() {
+  for (const char *name : {"RD_JIT_CXX", "CXX"}) {
+    std::string value = environment(name);
+    if (!value.empty()) {
+      return value;
+    }
+  }
+  return "c++";
+}
+
+fs::path cacheDirectory() {
+  std::string dir = environment("RD_JIT_CACHE");
+  if (!dir.empty()) {
+    return dir;
+  }
+  dir = environment("XDG_CACHE_HOME");
+  if (!dir.empty()) {
+    return fs::path(dir) / "rd-cli";
+  }
+  dir = environment("HOME");
+  if (!dir.empty()) {
+    return fs::path(dir) / ".cache" / "rd-cli";
+  }
+  return fs::temp_directory_path() / "rd-cli";
+}
+
+// Flags of the kernel TUs of the same instruction set. Contraction stays off,
+// like the baseline build of the interpreter, so both round identically.
+std::string compileFlags(Isa isa) {
+  std::string flags = "-std=c++17 -O3 -ffp-contract=off -fno-math-errno -fPIC -shared";
+  switch (isa) {
+  case Isa::Avx512:
+    return flags + " -mavx512f -mavx2 -mfma";
+  case Isa::Avx2:
+    return flags + " -mavx2 -mfma";
+  default:
+    return flags;
+  }
+}
+
+// FNV-1a, 64 bits.
+uint64_t hashText(const std::string &text) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : text) {
+    hash = (hash ^ c) * 1099511628211ull;
+  }
+  return hash;
+}
+
+std::string quote(const fs::path &path) {
+  std::string quoted = "'";
+  for (char c : path.string()) {
+    quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+  }
+  return quoted + "'";
+}
+
+ModelKernel load(const fs::path &library, std::string &error) {
+  // Never closed: kernels may be called until the process exits.
+  void *handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!handle) {
+    error = dlerror();
+    return nullptr;
+  }
+  void *symbol = dlsym(handle, kReactionSymbol);
+  if (!symbol) {
+    error = dlerror();
+    return nullptr;
+  }
+  return reinterpret_cast<ModelKernel>(symbol);
+}
+
+} // namespace
+
+CompiledReaction compileReaction(const ReactionProgram &program, Isa isa) {
+  CompiledReaction result;
+  const std::string source = program.source();
+  const std::string compiler = compilerCommand();
+  const std::string flags = compileFlags(resolveIsa(isa));
+  char name[32];
+  snprintf(name, sizeof(name), "reaction-%016llx",
+           static_cast<unsigned long long>(hashText(compiler + "\n" + flags + "\n" + source)));
+  std::error_code ec;
+  const fs::path dir = cacheDirectory();
+  fs::create_directories(dir, ec);
+  if (ec) {
+    result.error = "cannot create " + dir.string() + ": " + ec.message();
+    return result;
+  }
+  const fs::path library = dir / (std::string(name) + ".so");
+  result.library = library.string();
+  if (fs::exists(library)) {
+    result.kernel = load(library, result.error);
+    result.cached = result.kernel != nullptr;
+    if (result.kernel) {
+      return result;
+    }
+  }
+  // Build under a private name and rename, so concurrent runs never load a
+  // half-written library.
+  const fs::path sourcePath = dir / (std::string(name) + ".cpp");
+  const fs::path logPath = dir / (std::string(name) + ".log");
+  const fs::path partial = dir / (std::string(name) + "." + std::to_string(getpid()) + ".so");
+  {
+    std::ofstream out(sourcePath);
+    out << source;
+    if (!out) {
+      result.error = "cannot write " + sourcePath.string();
+      return result;
+    }
+  }
+  const std::string command = compiler + " " + flags + " -o " + quote(partial) + " " +
+                              quote(sourcePath) + " > " + quote(logPath) + " 2>&1";
+  auto start = std::chrono::steady_clock::now();
+  const int status = system(command.c_str());
+  result.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (status != 0) {
+    result.error = compiler + " failed (see " + logPath.string() + ")";
+    fs::remove(partial, ec);
+    return result;
+  }
+  fs::rename(partial, library, ec);
+  if (ec) {
+    result.error = "cannot rename " + partial.string() + ": " + ec.message();
+    fs::remove(partial, ec);
+    return result;
+  }
+  fs::remove(logPath, ec);
+  result.kernel = load(library, result.error);
+  return result;
+}
@@ -0,0 +1,203 @@
+#include "Fft.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Written out: std::complex's operator* takes a slow path for NaN/infinity
+// checks unless built with -ffast-math.
+inline Complex mul(Complex a, Complex b) {
+  return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+
+// Twiddles are stored for the forward direction; the inverse uses conjugates.
+template <bool Inverse>
+inline Complex twiddle(Complex w) {
+  return Inverse ? std::conj(w) : w;
+}
+
+// a * -i forward, a * i inverse: the quarter turn of the transform's direction.
+template <bool Inverse>
+inline Complex rotate(Complex a) {
+  return Inverse ? Complex(-a.imag(), a.real()) : Complex(a.imag(), -a.real());
+}
+
+} // namespace
+
+Fft::Fft(int n) : _n(n) {
+  if (n < 1) {
+    throw std::invalid_argument("FFT length must be positive");
+  }
+  int rest = n;
+  while (rest % 4 == 0) {
+    _factors.push_back(4);
+    rest /= 4;
+  }
+  for (int p = 2; rest > 1; p++) {
+    while (rest % p == 0) {
+      _factors.push_back(p);
+      rest /= p;
+    }
+  }
+  _roots.resize(n);
+  for (int k = 0; k < n; k++) {
+    double angle = -2.0 * M_PI * k / n;
+    _roots[k] = Complex(float(std::cos(angle)), float(std::sin(angle)));
+  }
+  int length = n;
+  for (int p : _factors) {
+    const int m = length / p;
+    const int step = n / length;
+    std::vector<Complex> level(size_t(p - 1) * m);
+    for (int q = 1; q < p; q++) {
+      for (int k = 0; k < m; k++) {
+        level[size_t(q - 1) * m + k] = _roots[size_t(q) * k * step % n];
+      }
+    }
+    _twiddles.push_back(std::move(level));
+    length = m;
+  }
+}
+
+void Fft::forward(Complex *data, int batch, int stride, int batchStride,
+                  Complex *scratch) const {
+  transform<false>(data, batch, stride, batchStride, scratch);
+}
+
+void Fft::inverse(Complex *data, int batch, int stride, int batchStride,
+                  Complex *scratch) const {
+  transform<true>(data, batch, stride, batchStride, scratch);
+}
+
+template <bool Inverse>
+void Fft::transform(Complex *data, int batch, int stride, int batchStride,
+                    Complex *scratch) const {
+  pass<Inverse>(data, scratch, _n, stride, 0, batch, batchStride);
+  for (int i = 0; i < _n; i++) {
+    const Complex *src = scratch + size_t(i) * batch;
+    Complex *dst = data + size_t(i) * stride;
+    for (int j = 0; j < batch; j++) {
+      dst[size_t(j) * batchStride] = src[j];
+    }
+  }
+}
+
+// Decimation in time: the p interleaved subsequences of `in` (every p-th
+// value) are transformed into consecutive blocks of `out`, then combined by
+// radix-p butterflies. `out` is packed (value i of sequence j at
+// out[i * batch + j]); `in` is read at the caller's strides.
+template <bool Inverse>
+void Fft::pass(const Complex *in, Complex *out, int n, int inStride, int level, int batch,
+               int batchStride) const {
+  if (n == 1) {
+    for (int j = 0; j < batch; j++) {
+      out[j] = in[size_t(j) * batchStride];
+    }
+    return;
+  }
+  const int p = _factors[level];
+  const int m = n / p;
+  for (int q = 0; q < p; q++) {
+    pass<Inverse>(in + size_t(q) * inStride, out + size_t(q) * m * batch, m, inStride * p,
+                  level + 1, batch, batchStride);
+  }
+
+  const Complex *tw = _twiddles[level].data();
+  const size_t block = size_t(m) * batch;
+  for (int k = 0; k < m; k++) {
+    Complex *o = out + size_t(k) * batch;
+    if (p == 2) {
+      const Complex w = twiddle<Inverse>(tw[k]);
+      for (int j = 0; j < batch; j++) {
+        Complex t0 = o[j];
+        Complex t1 = mul(o[block + j], w);
+        o[j] = t0 + t1;
+        o[block + j] = t0 - t1;
+      }
+    } else if (p == 3) {
+      const Complex w1 = twiddle<Inverse>(tw[k]);
+      const Complex w2 = twiddle<Inverse>(tw[m + k]);
+      const float sin60 = 0.866025403784438647f;
+      for (int j = 0; j < batch; j++) {
+        Complex t0 = o[j];
+        Complex t1 = mul(o[block + j], w1);
+        Complex t2 = mul(o[2 * block + j], w2);
+        Complex sum = t1 + t2;
+        Complex mid = t0 - 0.5f * sum;
+        Complex turn = rotate<Inverse>(sin60 * (t1 - t2));
+        o[j] = t0 + sum;
+        o[block + j] = mid + turn;
+        o[2 * block + j] = mid - turn;
+      }
+    } else if (p == 4) {
+      const Complex w1 = twiddle<Inverse>(tw[k]);
+      const Complex w2 = twiddle<Inverse>(tw[m + k]);
+      const Complex w3 = twiddle<Inverse>(tw[2 * m + k]);
+      for (int j = 0; j < batch; j++) {
+        Complex t0 = o[j];
+        Complex t1 = mul(o[block + j], w1);
+        Complex t2 = mul(o[2 * block + j], w2);
+        Complex t3 = mul(o[3 * block + j], w3);
+        Complex s0 = t0 + t2;
+        Complex s1 = t0 - t2;
+        Complex s2 = t1 + t3;
+        Complex s3 = rotate<Inverse>(t1 - t3);
+        o[j] = s0 + s2;
+        o[block + j] = s1 + s3;
+        o[2 * block + j] = s0 - s2;
+        o[3 * block + j] = s1 - s3;
+      }
+    } else if (p == 5) {
+      const Complex w1 = twiddle<Inverse>(tw[k]);
+      const Complex w2 = twiddle<Inverse>(tw[m + k]);
+      const Complex w3 = twiddle<Inverse>(tw[2 * m + k]);
+      const Complex w4 = twiddle<Inverse>(tw[3 * m + k]);
+      const float c1 = 0.309016994374947424f;  // cos(2 pi / 5)
+      const float c2 = -0.809016994374947424f; // cos(4 pi / 5)
+      const float s1 = 0.951056516295153572f;  // sin(2 pi / 5)
+      const float s2 = 0.587785252292473129f;  // sin(4 pi / 5)
+      for (int j = 0; j < batch; j++) {
+        Complex t0 = o[j];
+        Complex t1 = mul(o[block + j], w1);
+        Complex t2 = mul(o[2 * block + j], w2);
+        Complex t3 = mul(o[3 * block + j], w3);
+        Complex t4 = mul(o[4 * block + j], w4);
+        Complex a1 = t1 + t4;
+        Complex a2 = t2 + t3;
+        Complex b1 = t1 - t4;
+        Complex b2 = t2 - t3;
+        Complex m1 = t0 + c1 * a1 + c2 * a2;
+        Complex m2 = t0 + c2 * a1 + c1 * a2;
+        Complex n1 = rotate<Inverse>(s1 * b1 + s2 * b2);
+        Complex n2 = rotate<Inverse>(s2 * b1 - s1 * b2);
+        o[j] = t0 + a1 + a2;
+        o[block + j] = m1 + n1;
+        o[2 * block + j] = m2 + n2;
+        o[3 * block + j] = m2 - n2;
+        o[4 * block + j] = m1 - n1;
+      }
+    } else {
+      // Plain DFT across the p blocks, for radix 7 and larger primes.
+      Complex t[64];
+      std::vector<Complex> large;
+      Complex *twiddled = t;
+      if (p > 64) {
+        large.resize(p);
+        twiddled = large.data();
+      }
+      for (int j = 0; j < batch; j++) {
+        twiddled[0] = o[j];
+        for (int q = 1; q < p; q++) {
+          twiddled[q] = mul(o[q * block + j], twiddle<Inverse>(tw[size_t(q - 1) * m + k]));
+        }
+        for (int r = 0; r < p; r++) {
+          Complex sum = twiddled[0];
+          for (int q = 1; q < p; q++) {
+            sum += mul(twiddled[q], twiddle<Inverse>(_roots[size_t(q * r % p) * (_n / p)]));
+          }
+          o[r * block + j] = sum;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,39 @@
+#pragma once
+// Mixed-radix complex FFT for the spectral engine. Any length works: lengths
+// are factored into radix-4, 2, 3 and 5 passes, with a plain DFT pass for any
+// larger prime factor, so the default 500x500 grid needs no padding.
+//
+// Transforms run over a batch of sequences: value i of sequence j is
+// data[i * stride + j * batchStride]. The butterflies always work on a packed
+// copy with the batch innermost, so both the columns of a row-major array
+// (stride = width, batchStride = 1) and a block of its rows (stride = 1,
+// batchStride = width) are transformed with contiguous inner loops.
+
+#include <complex>
+#include <vector>
+
+using Complex = std::complex<float>;
+
+class Fft {
+public:
+  explicit Fft(int n);
+
+  int size() const { return _n; }
+
+  // In-place transforms of `batch` sequences. `scratch` holds size() * batch
+  // values. Neither direction is normalised: inverse(forward(x)) = n * x.
+  void forward(Complex *data, int batch, int stride, int batchStride, Complex *scratch) const;
+  void inverse(Complex *data, int batch, int stride, int batchStride, Complex *scratch) const;
+
+private:
+  int _n;
+  std::vector<int> _factors;
+  std::vector<Complex> _roots;                 // exp(-2 pi i k / n)
+  std::vector<std::vector<Complex>> _twiddles; // per level: root(q * k * n / length)
+
+  template <bool Inverse>
+  void transform(Complex *data, int batch, int stride, int batchStride, Complex *scratch) const;
+  template <bool Inverse>
+  void pass(const Complex *in, Complex *out, int n, int inStride, int level, int batch,
+            int batchStride) const;
+};
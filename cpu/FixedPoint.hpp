@@ -0,0 +1,114 @@
+#pragma once
+// Fixed-point plane storage for the int16 engine. A and B live in [0, 1], so
+// they are stored as int16 with 1.0 = 32767: resolution 3e-5 everywhere, and
+// a saturating add clamps the top of the range for free.
+//
+// Products use the pmulhrsw rounding: mulQ15(x, c) = (x * c + 2^14) >> 15.
+// With state values scaled by 32767 and coefficients by 32768, a state times
+// a coefficient comes out in state scale; a state times a state is short by
+// a factor 32767 / 32768, well below the resolution.
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Config.hpp"
+#include "Grid.hpp"
+#include "Planes.hpp"
+
+constexpr int kFixedOne = 32767;
+
+inline int16_t floatToFixed(float value) {
+  float clamped = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+  return static_cast<int16_t>(std::lrint(clamped * kFixedOne));
+}
+
+inline float fixedToFloat(int16_t value) { return value * (1.0f / kFixedOne); }
+
+// Update coefficients in Q15 (value * 32768), with the time step folded in.
+struct FixedArgs {
+  int16_t diffA;    // dt * diffA
+  int16_t diffB;    // dt * diffB
+  int16_t reaction; // dt
+  int16_t feed;     // dt * feed
+  int16_t feedKill; // dt * (feed + kill)
+};
+
+// Throws std::invalid_argument when a coefficient is 1 or more: Q15 cannot
+// hold it, and an explicit step that large is unstable anyway.
+inline FixedArgs fixedArgs(const SimArgs &args) {
+  auto q15 = [](float value, const char *what) {
+    long scaled = std::lround(value * 32768.0f);
+    if (scaled < 0 || scaled > 32767) {
+      throw std::invalid_argument(std::string("Fixed-point engine needs 0 <= ") + what + " < 1");
+    }
+    return static_cast<int16_t>(scaled);
+  };
+  return {q15(args.timeStep * args.diffA, "time_step * diffA"),
+          q15(args.timeStep * args.diffB, "time_step * diffB"),
+          q15(args.timeStep, "time_step"), q15(args.timeStep * args.feed, "time_step * feed"),
+          q15(args.timeStep * (args.feed + args.kill), "time_step * (feed + kill)")};
+}
+
+using AlignedFixed = std::vector<int16_t, AlignedAllocator<int16_t>>;
+
+constexpr int kPlaneAlignFixed = kPlaneAlignment / sizeof(int16_t);
+
+inline int roundUpFixed(int n) {
+  return (n + kPlaneAlignFixed - 1) / kPlaneAlignFixed * kPlaneAlignFixed;
+}
+
+// Same row layout as PlaneGrid, with int16 cells.
+struct FixedPlaneGrid {
+  int width = 0;
+  int height = 0;
+  int ghost = 0;
+  int lead = 0;   // cells before interior cell 0 of a row
+  int stride = 0; // cells per row, a multiple of 32
+  AlignedFixed a;
+  AlignedFixed b;
+
+  FixedPlaneGrid() = default;
+  FixedPlaneGrid(int w, int h, int g)
+      : width(w), height(h), ghost(g), lead(roundUpFixed(g)), stride(roundUpFixed(lead + w + g)),
+        a(size_t(stride) * (h + 2 * g), 0), b(size_t(stride) * (h + 2 * g), 0) {}
+
+  int16_t *rowA(int y) { return a.data() + size_t(y + ghost) * stride + lead; }
+  int16_t *rowB(int y) { return b.data() + size_t(y + ghost) * stride + lead; }
+  const int16_t *rowA(int y) const { return a.data() + size_t(y + ghost) * stride + lead; }
+  const int16_t *rowB(int y) const { return b.data() + size_t(y + ghost) * stride + lead; }
+
+  // Same interface as HalfPlaneGrid, so the ghost fills serve both.
+  int16_t encode(float value) const { return floatToFixed(value); }
+  int16_t encodeA(float value) const { return floatToFixed(value); }
+
+  void load(const Grid &grid) {
+    for (int y = 0; y < height; y++) {
+      const float *src = grid.row(y);
+      int16_t *dstA = rowA(y);
+      int16_t *dstB = rowB(y);
+      for (int x = 0; x < width; x++) {
+        dstA[x] = floatToFixed(src[2 * x]);
+        dstB[x] = floatToFixed(src[2 * x + 1]);
+      }
+    }
+  }
+
+  void store(Grid &grid) const {
+    if (grid.width != width || grid.height != height) {
+      grid = Grid(width, height);
+    }
+    for (int y = 0; y < height; y++) {
+      const int16_t *srcA = rowA(y);
+      const int16_t *srcB = rowB(y);
+      float *dst = grid.row(y);
+      for (int x = 0; x < width; x++) {
+        dst[2 * x] = fixedToFloat(srcA[x]);
+        dst[2 * x + 1] = fixedToFloat(srcB[x]);
+      }
+    }
+  }
+
+  size_t bytes() const { return (a.size() + b.size()) * sizeof(int16_t); }
+};
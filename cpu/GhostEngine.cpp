@@ -0,0 +1,80 @@
+// Threaded engine on a ghost-padded grid. Each step first refreshes the
+// 1-cell border with an edge-copy pass, after which every tile row is a single
+// branch-free kernel call: no modulo, no wrapped edge columns. The boundary
+// condition only changes the edge-copy pass and is a template parameter.
+
+#include "Engine.hpp"
+#include "Boundary.hpp"
+#include "Kernels.hpp"
+#include "ThreadPool.hpp"
+#include "Tiling.hpp"
+
+namespace {
+
+template <class Boundary>
+class GhostEngine : public Engine {
+public:
+  GhostEngine(const Config &config, const EngineOptions &options)
+      : Engine(config), _kernel(rowKernel(options.isa)), _pool(options.threads),
+        _grids{PaddedGrid(config.width, config.height, 1),
+               PaddedGrid(config.width, config.height, 1)} {
+    int tileWidth = options.tileWidth;
+    int tileHeight = options.tileHeight;
+    autoTileSize(config.width, config.height, _pool.size(), tileWidth, tileHeight);
+    _tiles = makeTiles(config.width, config.height, tileWidth, tileHeight);
+    _name = "ghost/" + std::string(Boundary::name) + "/" + isaName(resolveIsa(options.isa)) +
+            "/" + std::to_string(_pool.size()) + "t/" + std::to_string(tileWidth) + "x" +
+            std::to_string(tileHeight);
+  }
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(const Grid &grid) override { _grids[_current].load(grid); }
+  StateView stateView() const override { return _grids[_current].view(); }
+  size_t stateBytes() const override { return _grids[0].bytes() + _grids[1].bytes(); }
+
+  void step(int steps) override {
+    const int threads = _pool.size();
+    const int tileCount = static_cast<int>(_tiles.size());
+    _pool.run([&](int thread) {
+      int begin, end, rowBegin, rowEnd;
+      splitRange(tileCount, threads, thread, begin, end);
+      splitRange(_config.height, threads, thread, rowBegin, rowEnd);
+      for (int s = 0; s < steps; s++) {
+        PaddedGrid &in = _grids[(_current + s) % 2];
+        PaddedGrid &out = _grids[(_current + s + 1) % 2];
+        fillGhostColumns<Boundary>(in, rowBegin, rowEnd);
+        if (thread == 0) {
+          fillGhostRows<Boundary>(in);
+        }
+        _pool.barrier();
+        for (int t = begin; t < end; t++) {
+          const Tile &tile = _tiles[t];
+          for (int y = tile.y0; y < tile.y1; y++) {
+            int i = 2 * tile.x0;
+            _kernel(in.row(y - 1) + i, in.row(y) + i, in.row(y + 1) + i, out.row(y) + i,
+                    tile.x1 - tile.x0, _config.simArgs);
+          }
+        }
+        _pool.barrier();
+      }
+    });
+    _current = (_current + steps) % 2;
+  }
+
+private:
+  RowKernel _kernel;
+  ThreadPool _pool;
+  PaddedGrid _grids[2];
+  int _current = 0;
+  std::vector<Tile> _tiles;
+  std::string _name;
+};
+
+} // namespace
+
+std::unique_ptr<Engine> makeGhostEngine(const Config &config, const EngineOptions &options) {
+  return withBoundary(config.boundary, [&](auto boundary) -> std::unique_ptr<Engine> {
+    return std::make_unique<GhostEngine<decltype(boundary)>>(config, options);
+  });
+}
@@ -0,0 +1,115 @@
+#pragma once
+// Simulation state for the CPU backend.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+struct Grid;
+
+// Read-only view of A/B state in any storage layout, presented cell by cell
+// in (x, y) order. Nothing is copied: exporters walk the engine's own memory.
+struct StateView {
+  int width = 0;
+  int height = 0;
+  const float *a = nullptr; // A of cell (0, 0)
+  const float *b = nullptr; // B of cell (0, 0)
+  ptrdiff_t cellStride = 0; // floats between horizontal neighbours
+  ptrdiff_t rowStride = 0;  // floats between vertical neighbours
+
+  float A(int x, int y) const { return a[y * rowStride + x * cellStride]; }
+  float B(int x, int y) const { return b[y * rowStride + x * cellStride]; }
+
+  // Writes row y interleaved (A, B, A, B, ...) into dst.
+  void copyRow(int y, float *dst) const {
+    for (int x = 0; x < width; x++) {
+      dst[2 * x] = A(x, y);
+      dst[2 * x + 1] = B(x, y);
+    }
+  }
+
+  inline void copyTo(Grid &grid) const;
+};
+
+// Interleaved A/B cells, laid out exactly like the RG32Float sim texture
+// (cells[2 * i] = A, cells[2 * i + 1] = B), so a dump can be uploaded with
+// replaceRegion or compared against a texture readback as-is.
+struct Grid {
+  int width = 0;
+  int height = 0;
+  std::vector<float> cells;
+
+  Grid() = default;
+  Grid(int w, int h) : width(w), height(h), cells(size_t(w) * h * 2, 0.0f) {}
+
+  size_t cellCount() const { return size_t(width) * height; }
+  float *row(int y) { return cells.data() + size_t(y) * width * 2; }
+  const float *row(int y) const { return cells.data() + size_t(y) * width * 2; }
+
+  size_t bytes() const { return cells.size() * sizeof(float); }
+
+  StateView view() const {
+    return {width, height, cells.data(), cells.data() + 1, 2, 2 * ptrdiff_t(width)};
+  }
+};
+
+inline void StateView::copyTo(Grid &grid) const {
+  grid = Grid(width, height);
+  for (int y = 0; y < height; y++) {
+    copyRow(y, grid.row(y));
+  }
+}
+
+// Same seeding as Renderer::buildTextures: A = 1 everywhere, B sprinkled
+// with probability `noiseDensity`. Seeded explicitly so CPU runs repeat.
+// fillNoise continues the current rand() sequence, for several grids from
+// one seed (the slices of a volume).
+inline void fillNoise(Grid &grid, float noiseDensity) {
+  for (size_t i = 0; i < grid.cells.size(); i += 2) {
+    grid.cells[i] = 1.0f;
+    float r = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+    if (r < noiseDensity) {
+      grid.cells[i + 1] = 1.0f;
+    } else {
+      grid.cells[i + 1] = 0.0f;
+    }
+  }
+}
+
+inline void seedGrid(Grid &grid, float noiseDensity, unsigned seed) {
+  srand(seed);
+  fillNoise(grid, noiseDensity);
+}
+
+// Interleaved grid with a `ghost`-cell border on every side. The border holds
+// copies of the cells a stencil reads across the edge, so the interior update
+// never wraps or branches. Coordinates are interior-based: row(y)[2 * x] is
+// cell (x, y) for x in [-ghost, width + ghost), y likewise.
+struct PaddedGrid {
+  int width = 0;
+  int height = 0;
+  int ghost = 0;
+  int stride = 0; // floats per padded row
+  std::vector<float> cells;
+
+  PaddedGrid() = default;
+  PaddedGrid(int w, int h, int g)
+      : width(w), height(h), ghost(g), stride(2 * (w + 2 * g)),
+        cells(size_t(stride) * (h + 2 * g), 0.0f) {}
+
+  float *row(int y) { return cells.data() + size_t(y + ghost) * stride + 2 * ghost; }
+  const float *row(int y) const {
+    return cells.data() + size_t(y + ghost) * stride + 2 * ghost;
+  }
+
+  void load(const Grid &grid) {
+    for (int y = 0; y < height; y++) {
+      std::copy(grid.row(y), grid.row(y) + 2 * width, row(y));
+    }
+  }
+
+  size_t bytes() const { return cells.size() * sizeof(float); }
+
+  StateView view() const { return {width, height, row(0), row(0) + 1, 2, stride}; }
+};
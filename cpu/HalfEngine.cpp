@@ -0,0 +1,134 @@
+// Threaded engine on half-precision planes. Structured like the soa engine,
+// but A and B are stored as fp16 or bf16: 4 bytes per cell instead of 8, so
+// each step moves half the memory. The update itself runs in float: every
+// thread widens a rolling window of three rows of its tile into float
+// buffers, runs the plane kernel on them and rounds the output row back.
+// Each source row is converted once per tile, not once per stencil tap.
+
+#include "Boundary.hpp"
+#include "Engine.hpp"
+#include "HalfPlanes.hpp"
+#include "Kernels.hpp"
+#include "ThreadPool.hpp"
+#include "Tiling.hpp"
+
+namespace {
+
+template <class Boundary>
+class HalfEngine : public Engine {
+public:
+  HalfEngine(const Config &config, const EngineOptions &options, HalfFormat format)
+      : Engine(config), _kernel(planeKernel(options.isa)),
+        _convert(halfConversion(options.isa, format)), _pool(options.threads),
+        _grids{HalfPlaneGrid(format, config.width, config.height, 1),
+               HalfPlaneGrid(format, config.width, config.height, 1)} {
+    int tileWidth = options.tileWidth;
+    int tileHeight = options.tileHeight;
+    autoTileSize(config.width, config.height, _pool.size(), tileWidth, tileHeight);
+    _tiles = makeTiles(config.width, config.height, tileWidth, tileHeight);
+    const int bufferLength = kPlaneAlignFloats + roundUpFloats(tileWidth + 1);
+    _scratch.resize(_pool.size());
+    for (RowBuffers &buffers : _scratch) {
+      for (int i = 0; i < 3; i++) {
+        buffers.a[i].resize(bufferLength);
+        buffers.b[i].resize(bufferLength);
+      }
+      buffers.aOut.resize(bufferLength);
+      buffers.bOut.resize(bufferLength);
+    }
+    _name = std::string(halfFormatName(format)) + "/" + Boundary::name + "/" +
+            isaName(resolveIsa(options.isa)) + "/" + std::to_string(_pool.size()) + "t/" +
+            std::to_string(tileWidth) + "x" + std::to_string(tileHeight);
+  }
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(const Grid &grid) override { _grids[_current].load(grid); }
+
+  // There is no float copy to point at, so the view is of a widened snapshot
+  // taken on request. It is not counted in stateBytes().
+  StateView stateView() const override {
+    _grids[_current].store(_snapshot);
+    return _snapshot.view();
+  }
+  size_t stateBytes() const override { return _grids[0].bytes() + _grids[1].bytes(); }
+
+  void step(int steps) override {
+    const int threads = _pool.size();
+    const int tileCount = static_cast<int>(_tiles.size());
+    _pool.run([&](int thread) {
+      int begin, end, rowBegin, rowEnd;
+      splitRange(tileCount, threads, thread, begin, end);
+      splitRange(_config.height, threads, thread, rowBegin, rowEnd);
+      for (int s = 0; s < steps; s++) {
+        HalfPlaneGrid &in = _grids[(_current + s) % 2];
+        HalfPlaneGrid &out = _grids[(_current + s + 1) % 2];
+        fillGhostColumns<Boundary>(in, rowBegin, rowEnd);
+        if (thread == 0) {
+          fillGhostRows<Boundary>(in);
+        }
+        _pool.barrier();
+        for (int t = begin; t < end; t++) {
+          stepTile(in, out, _tiles[t], _scratch[thread]);
+        }
+        _pool.barrier();
+      }
+    });
+    _current = (_current + steps) % 2;
+  }
+
+private:
+  // Float copies of three consecutive rows (cells x0 - 1 .. x1 of the tile,
+  // interior starting at kPlaneAlignFloats) and of one output row.
+  struct RowBuffers {
+    AlignedFloats a[3], b[3];
+    AlignedFloats aOut, bOut;
+  };
+
+  PlaneKernel _kernel;
+  HalfConversion _convert;
+  ThreadPool _pool;
+  HalfPlaneGrid _grids[2];
+  int _current = 0;
+  std::vector<Tile> _tiles;
+  std::vector<RowBuffers> _scratch; // one per thread
+  mutable Grid _snapshot;
+  std::string _name;
+
+  void stepTile(const HalfPlaneGrid &in, HalfPlaneGrid &out, const Tile &tile,
+                RowBuffers &buffers) {
+    const int x0 = tile.x0;
+    const int width = tile.x1 - tile.x0;
+    auto widen = [&](int y, int slot) {
+      _convert.widen(in.rowA(y) + x0 - 1, buffers.a[slot].data() + kPlaneAlignFloats - 1,
+                     width + 2, true);
+      _convert.widen(in.rowB(y) + x0 - 1, buffers.b[slot].data() + kPlaneAlignFloats - 1,
+                     width + 2, false);
+    };
+    widen(tile.y0 - 1, 0);
+    widen(tile.y0, 1);
+    for (int y = tile.y0; y < tile.y1; y++) {
+      const int up = (y - tile.y0) % 3;
+      const int mid = (up + 1) % 3;
+      const int down = (up + 2) % 3;
+      widen(y + 1, down);
+      const int i = kPlaneAlignFloats;
+      PlaneRow row = {buffers.a[up].data() + i,   buffers.a[mid].data() + i,
+                      buffers.a[down].data() + i, buffers.b[up].data() + i,
+                      buffers.b[mid].data() + i,  buffers.b[down].data() + i,
+                      buffers.aOut.data() + i,    buffers.bOut.data() + i};
+      _kernel(row, width, _config.simArgs);
+      _convert.narrow(row.aOut, out.rowA(y) + x0, width, true);
+      _convert.narrow(row.bOut, out.rowB(y) + x0, width, false);
+    }
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Engine> makeHalfEngine(const Config &config, const EngineOptions &options,
+                                       HalfFormat format) {
+  return withBoundary(config.boundary, [&](auto boundary) -> std::unique_ptr<Engine> {
+    return std::make_unique<HalfEngine<decltype(boundary)>>(config, options, format);
+  });
+}
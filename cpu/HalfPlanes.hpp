@@ -0,0 +1,143 @@
+#pragma once
+// Half-precision plane storage. A and B stay in [0, 1] (every step clamps
+// them), so 16 bits per value keep patterns intact at half the memory and
+// half the traffic of float planes. Values are widened to float for the
+// update and rounded back when stored.
+//
+// A sits near 1 wherever nothing happens, where a 16-bit float is coarse
+// (fp16 steps by 2^-11 just below 1): the small feed terms pulling A back up
+// would round away and A would stall short of 1. The A plane therefore
+// stores 1 - A, which is near 0, where the formats are finest.
+//
+//   fp16  IEEE binary16: 10-bit mantissa, ~5e-4 resolution near 1
+//   bf16  bfloat16, the top half of a float: 7-bit mantissa, ~4e-3 near 1
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Grid.hpp"
+#include "Planes.hpp"
+
+enum class HalfFormat { Fp16, Bf16 };
+
+inline const char *halfFormatName(HalfFormat format) {
+  return format == HalfFormat::Fp16 ? "fp16" : "bf16";
+}
+
+// Round to nearest even, like F16C's vcvtps2ph with _MM_FROUND_TO_NEAREST_INT,
+// so the scalar and vector kernels store the same bits.
+inline uint16_t floatToFp16(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+  uint32_t magnitude = bits & 0x7fffffff;
+  if (magnitude >= 0x47800000) { // 65536 and up, infinity or NaN
+    return sign | (magnitude > 0x7f800000 ? 0x7e00 : 0x7c00);
+  }
+  if (magnitude < 0x38800000) { // below 2^-14: subnormal, in units of 2^-24
+    return sign | static_cast<uint16_t>(std::nearbyint(std::fabs(value) * 0x1p24f));
+  }
+  uint32_t rounded = magnitude + 0xfff + ((magnitude >> 13) & 1);
+  return sign | static_cast<uint16_t>((rounded - 0x38000000) >> 13);
+}
+
+inline float fp16ToFloat(uint16_t half) {
+  uint32_t sign = uint32_t(half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+  if (exponent == 0) {
+    float value = mantissa * 0x1p-24f;
+    return sign ? -value : value;
+  }
+  uint32_t bits = exponent == 31 ? sign | 0x7f800000 | (mantissa << 13)
+                                 : sign | ((exponent + 112) << 23) | (mantissa << 13);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Round to nearest even on the dropped 16 bits. NaNs are not expected here.
+inline uint16_t floatToBf16(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return static_cast<uint16_t>((bits + 0x7fff + ((bits >> 16) & 1)) >> 16);
+}
+
+inline float bf16ToFloat(uint16_t half) {
+  uint32_t bits = uint32_t(half) << 16;
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+using AlignedHalves = std::vector<uint16_t, AlignedAllocator<uint16_t>>;
+
+constexpr int kPlaneAlignHalves = kPlaneAlignment / sizeof(uint16_t);
+
+inline int roundUpHalves(int n) {
+  return (n + kPlaneAlignHalves - 1) / kPlaneAlignHalves * kPlaneAlignHalves;
+}
+
+// Same row layout as PlaneGrid, with 16-bit cells.
+struct HalfPlaneGrid {
+  HalfFormat format = HalfFormat::Fp16;
+  int width = 0;
+  int height = 0;
+  int ghost = 0;
+  int lead = 0;   // halves before interior cell 0 of a row
+  int stride = 0; // halves per row, a multiple of 32
+  AlignedHalves a;
+  AlignedHalves b;
+
+  HalfPlaneGrid() = default;
+  HalfPlaneGrid(HalfFormat f, int w, int h, int g)
+      : format(f), width(w), height(h), ghost(g), lead(roundUpHalves(g)),
+        stride(roundUpHalves(lead + w + g)), a(size_t(stride) * (h + 2 * g), 0),
+        b(size_t(stride) * (h + 2 * g), 0) {}
+
+  // A plane rows hold 1 - A.
+  uint16_t *rowA(int y) { return a.data() + size_t(y + ghost) * stride + lead; }
+  uint16_t *rowB(int y) { return b.data() + size_t(y + ghost) * stride + lead; }
+  const uint16_t *rowA(int y) const { return a.data() + size_t(y + ghost) * stride + lead; }
+  const uint16_t *rowB(int y) const { return b.data() + size_t(y + ghost) * stride + lead; }
+
+  uint16_t encode(float value) const {
+    return format == HalfFormat::Fp16 ? floatToFp16(value) : floatToBf16(value);
+  }
+  float decode(uint16_t value) const {
+    return format == HalfFormat::Fp16 ? fp16ToFloat(value) : bf16ToFloat(value);
+  }
+  uint16_t encodeA(float a) const { return encode(1.0f - a); }
+  float decodeA(uint16_t value) const { return 1.0f - decode(value); }
+
+  void load(const Grid &grid) {
+    for (int y = 0; y < height; y++) {
+      const float *src = grid.row(y);
+      uint16_t *dstA = rowA(y);
+      uint16_t *dstB = rowB(y);
+      for (int x = 0; x < width; x++) {
+        dstA[x] = encodeA(src[2 * x]);
+        dstB[x] = encode(src[2 * x + 1]);
+      }
+    }
+  }
+
+  // Widens the interior into an interleaved float grid.
+  void store(Grid &grid) const {
+    if (grid.width != width || grid.height != height) {
+      grid = Grid(width, height);
+    }
+    for (int y = 0; y < height; y++) {
+      const uint16_t *srcA = rowA(y);
+      const uint16_t *srcB = rowB(y);
+      float *dst = grid.row(y);
+      for (int x = 0; x < width; x++) {
+        dst[2 * x] = decodeA(srcA[x]);
+        dst[2 * x + 1] = decode(srcB[x]);
+      }
+    }
+  }
+
+  size_t bytes() const { return (a.size() + b.size()) * sizeof(uint16_t); }
+};
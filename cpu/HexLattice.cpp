@@ -0,0 +1,72 @@
+#include "HexLattice.hpp"
+#include <algorithm>
+#include <cmath>
+
+void hexSquareSize(int width, int height, int &squareWidth, int &squareHeight) {
+  squareWidth = std::max(1, static_cast<int>(std::lround(width * double(kHexSpacing))));
+  squareHeight = std::max(1, static_cast<int>(std::lround(height * double(kHexRowPitch))));
+}
+
+namespace {
+
+struct Corner {
+  float a, b;
+};
+
+} // namespace
+
+// Cell (x, y) is centred at ((x + parity / 2 + 1/4) d, (y + 1/2) r), which
+// puts the lattice's extent at [0, width d) x [0, height r). Shearing the
+// strip between two rows by the half-cell offset turns its triangles into
+// unit squares cut along one diagonal, the one that depends on which of the
+// two rows is shifted right.
+void resampleHex(const StateView &hex, bool periodic, Grid &square) {
+  const int w = hex.width;
+  const int h = hex.height;
+  auto cell = [&](int x, int y) -> Corner {
+    if (periodic) {
+      y = ((y % h) + h) % h;
+      x = ((x % w) + w) % w;
+    } else {
+      y = std::clamp(y, 0, h - 1);
+      x = std::clamp(x, 0, w - 1);
+    }
+    return {hex.A(x, y), hex.B(x, y)};
+  };
+  const double scaleX = double(w) / square.width;
+  const double scaleY = double(h) / square.height;
+  for (int py = 0; py < square.height; py++) {
+    const double row = (py + 0.5) * scaleY - 0.5;
+    const int y0 = static_cast<int>(std::floor(row));
+    const double ft = row - y0;
+    const double offset0 = 0.5 * hexRowParity(y0);
+    const double shift = 0.5 * hexRowParity(y0 + 1) - offset0;
+    float *dst = square.row(py);
+    for (int px = 0; px < square.width; px++) {
+      const double q = (px + 0.5) * scaleX - 0.25 - offset0 - ft * shift;
+      const int x0 = static_cast<int>(std::floor(q));
+      const double fx = q - x0;
+      const Corner c00 = cell(x0, y0), c10 = cell(x0 + 1, y0);
+      const Corner c01 = cell(x0, y0 + 1), c11 = cell(x0 + 1, y0 + 1);
+      double w00, w10, w01, w11;
+      if (shift > 0.0) {
+        // Diagonal from (1, 0) to (0, 1).
+        if (fx + ft <= 1.0) {
+          w00 = 1.0 - fx - ft, w10 = fx, w01 = ft, w11 = 0.0;
+        } else {
+          w00 = 0.0, w10 = 1.0 - ft, w01 = 1.0 - fx, w11 = fx + ft - 1.0;
+        }
+      } else {
+        // Diagonal from (0, 0) to (1, 1).
+        if (fx >= ft) {
+          w00 = 1.0 - fx, w10 = fx - ft, w01 = 0.0, w11 = ft;
+        } else {
+          w00 = 1.0 - ft, w10 = 0.0, w01 = ft - fx, w11 = fx;
+        }
+      }
+      dst[2 * px] = static_cast<float>(w00 * c00.a + w10 * c10.a + w01 * c01.a + w11 * c11.a);
+      dst[2 * px + 1] =
+          static_cast<float>(w00 * c00.b + w10 * c10.b + w01 * c01.b + w11 * c11.b);
+    }
+  }
+}
@@ -0,0 +1,38 @@
+#pragma once
+// Hexagonal lattice of the hex engine. Cells are stored as offset rows: a
+// width x height grid whose odd rows sit half a cell to the right, so every
+// cell has six equidistant neighbours, two in its own row and two in each of
+// the rows above and below:
+//
+//   row y - 1 (odd):     . o o .          even rows: x - 1 and x above/below
+//   row y     (even):   . o C o .         odd rows:  x and x + 1
+//   row y + 1 (odd):     . o o .
+//
+// The 6-neighbour laplacian (2 / 3d^2) * (sum of neighbours - 6 * centre) is
+// isotropic to second order, where the 5-point one has a fourth-order error
+// that favours the axes. The spacing d is chosen so each cell covers one unit
+// of area, like a square grid cell, which makes SimArgs carry over unchanged
+// and the sum's weight 1 / sqrt(3). Periodic wrapping needs an even height so
+// the row parity repeats.
+
+#include "Grid.hpp"
+
+// Centre-to-centre distance of neighbours, sqrt(2 / sqrt(3)).
+constexpr float kHexSpacing = 1.07456993f;
+// Distance between rows, kHexSpacing * sqrt(3) / 2.
+constexpr float kHexRowPitch = 0.930604859f;
+// Weight of the neighbour sum in the laplacian, 1 / sqrt(3).
+constexpr float kHexWeight = 0.577350269f;
+
+// Offset of row y in cells: 0 for even rows, 1/2 for odd ones.
+inline int hexRowParity(int y) { return y & 1; }
+
+// Size of the square grid with one cell per unit area that covers the same
+// extent as a width x height lattice.
+void hexSquareSize(int width, int height, int &squareWidth, int &squareHeight);
+
+// Resamples a lattice state onto `square`, whose size the caller sets, by
+// linear interpolation over the triangles between neighbouring cells. The
+// square grid spans the lattice's whole extent; `periodic` wraps samples
+// beyond the outermost cell centres around, otherwise they are clamped.
+void resampleHex(const StateView &hex, bool periodic, Grid &square);
@@ -0,0 +1,151 @@
+// Single-buffer engine: one set of SoA planes updated in place, instead of the
+// two full-size grids every other engine ping-pongs between (notes.txt muses
+// about dropping the second texture for the same reason).
+//
+// Each thread owns a strip of rows and walks it top to bottom. Before a row is
+// overwritten its old values are saved into a rolling buffer, which serves as
+// the "up" neighbour of the next row. The rows on either side of a strip are
+// needed by the neighbouring threads after they may have been overwritten, so
+// every thread saves its first and last row before anyone starts writing. That
+// is four saved rows per thread, i.e. about 1x the grid instead of 2x, and the
+// kernel sees exactly the inputs a ping-pong step would give it.
+
+#include <algorithm>
+#include "Boundary.hpp"
+#include "Engine.hpp"
+#include "Kernels.hpp"
+#include "Planes.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+// Copy of one plane row including its ghost cells, aligned like the grid.
+struct SavedRow {
+  AlignedFloats a;
+  AlignedFloats b;
+  int lead = 0;
+
+  void resize(const PlaneGrid &grid) {
+    lead = grid.lead;
+    a.assign(grid.stride, 0.0f);
+    b.assign(grid.stride, 0.0f);
+  }
+  const float *rowA() const { return a.data() + lead; }
+  const float *rowB() const { return b.data() + lead; }
+
+  void save(const PlaneGrid &grid, int y) {
+    const int g = grid.ghost;
+    std::copy(grid.rowA(y) - g, grid.rowA(y) + grid.width + g, a.data() + lead - g);
+    std::copy(grid.rowB(y) - g, grid.rowB(y) + grid.width + g, b.data() + lead - g);
+  }
+};
+
+struct StripBuffers {
+  SavedRow top;    // old first row of the strip, read by the thread above
+  SavedRow bottom; // old last row of the strip, read by the thread below
+  SavedRow rolling[2];
+};
+
+template <class Boundary>
+class InPlaceEngine : public Engine {
+public:
+  InPlaceEngine(const Config &config, const EngineOptions &options)
+      : Engine(config), _kernel(planeKernel(options.isa)), _pool(options.threads),
+        _grid(config.width, config.height, 1) {
+    // Strips of at least one row; extra threads only join the barriers.
+    _strips = std::min(_pool.size(), config.height);
+    _buffers.resize(_strips);
+    for (StripBuffers &buffers : _buffers) {
+      buffers.top.resize(_grid);
+      buffers.bottom.resize(_grid);
+      buffers.rolling[0].resize(_grid);
+      buffers.rolling[1].resize(_grid);
+    }
+    _name = "inplace/" + std::string(Boundary::name) + "/" +
+            isaName(resolveIsa(options.isa)) + "/" + std::to_string(_pool.size()) + "t";
+  }
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(const Grid &grid) override { _grid.load(grid); }
+  StateView stateView() const override { return _grid.view(); }
+
+  size_t stateBytes() const override {
+    return _grid.bytes() + _buffers.size() * 4 * (_grid.stride * 2 * sizeof(float));
+  }
+
+  void step(int steps) override {
+    _pool.run([&](int thread) {
+      for (int s = 0; s < steps; s++) {
+        int y0 = 0, y1 = 0;
+        if (thread < _strips) {
+          splitRange(_config.height, _strips, thread, y0, y1);
+          // Save the strip's edge rows (ghosts included) while all rows are old.
+          fillGhostColumns<Boundary>(_grid, y0, y0 + 1);
+          fillGhostColumns<Boundary>(_grid, y1 - 1, y1);
+          _buffers[thread].top.save(_grid, y0);
+          _buffers[thread].bottom.save(_grid, y1 - 1);
+          if (thread == 0) {
+            fillGhostRows<Boundary>(_grid);
+          }
+        }
+        _pool.barrier();
+        if (thread < _strips) {
+          stepStrip(thread, y0, y1);
+        }
+        _pool.barrier();
+      }
+    });
+  }
+
+private:
+  PlaneKernel _kernel;
+  ThreadPool _pool;
+  PlaneGrid _grid;
+  int _strips;
+  std::vector<StripBuffers> _buffers;
+  std::string _name;
+
+  void stepStrip(int strip, int y0, int y1) {
+    const int h = _config.height;
+    StripBuffers &buffers = _buffers[strip];
+    // Old row y0 - 1: the ghost row at the top edge, else the strip above's save.
+    const float *upA = strip == 0 ? _grid.rowA(-1) : _buffers[strip - 1].bottom.rowA();
+    const float *upB = strip == 0 ? _grid.rowB(-1) : _buffers[strip - 1].bottom.rowB();
+    int next = 0;
+    for (int y = y0; y < y1; y++) {
+      const float *downA, *downB;
+      if (y + 1 < y1) {
+        fillGhostColumns<Boundary>(_grid, y + 1, y + 2);
+        downA = _grid.rowA(y + 1);
+        downB = _grid.rowB(y + 1);
+      } else if (y + 1 == h) {
+        downA = _grid.rowA(h);
+        downB = _grid.rowB(h);
+      } else {
+        downA = _buffers[strip + 1].top.rowA();
+        downB = _buffers[strip + 1].top.rowB();
+      }
+      // The centre row is read from a saved copy; the grid row is the output.
+      const SavedRow *mid = &buffers.top;
+      if (y != y0) {
+        buffers.rolling[next].save(_grid, y);
+        mid = &buffers.rolling[next];
+        next = 1 - next;
+      }
+      PlaneRow row = {upA,          mid->rowA(), downA,         upB,
+                      mid->rowB(),  downB,       _grid.rowA(y), _grid.rowB(y)};
+      _kernel(row, _config.width, _config.simArgs);
+      upA = mid->rowA();
+      upB = mid->rowB();
+    }
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Engine> makeInPlaceEngine(const Config &config, const EngineOptions &options) {
+  return withBoundary(config.boundary, [&](auto boundary) -> std::unique_ptr<Engine> {
+    return std::make_unique<InPlaceEngine<decltype(boundary)>>(config, options);
+  });
+}
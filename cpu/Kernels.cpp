@@ -0,0 +1,553 @@
+#include "Kernels.hpp"
+#include "ModelKernels.hpp"
+#include "StencilKernels.hpp"
+
+void stepRowScalar(const float *up, const float *mid, const float *down, float *out,
+                   int count, const SimArgs &args) {
+  for (int x = 0; x < count; x++) {
+    int i = 2 * x;
+    float a = mid[i];
+    float b = mid[i + 1];
+    float lapA = up[i] + down[i] + mid[i - 2] + mid[i + 2] - 4.0f * a;
+    float lapB = up[i + 1] + down[i + 1] + mid[i - 1] + mid[i + 3] - 4.0f * b;
+    grayScottCell(a, b, lapA, lapB, args, out[i], out[i + 1]);
+  }
+}
+
+namespace {
+
+// Outputs never alias inputs (ping-pong); restrict-qualified parameters are
+// the form GCC and Clang reliably honour, and let the loop vectorise.
+void stepPlaneCells(const float *__restrict aUp, const float *__restrict aMid,
+                    const float *__restrict aDown, const float *__restrict bUp,
+                    const float *__restrict bMid, const float *__restrict bDown,
+                    float *__restrict aOut, float *__restrict bOut, int count,
+                    const SimArgs params) {
+  for (int x = 0; x < count; x++) {
+    float a = aMid[x];
+    float b = bMid[x];
+    float lapA = aUp[x] + aDown[x] + aMid[x - 1] + aMid[x + 1] - 4.0f * a;
+    float lapB = bUp[x] + bDown[x] + bMid[x - 1] + bMid[x + 1] - 4.0f * b;
+    float aNew, bNew;
+    grayScottCell(a, b, lapA, lapB, params, aNew, bNew);
+    aOut[x] = aNew;
+    bOut[x] = bNew;
+  }
+}
+
+} // namespace
+
+void stepPlaneRowScalar(const PlaneRow &row, int count, const SimArgs &args) {
+  stepPlaneCells(row.aUp, row.aMid, row.aDown, row.bUp, row.bMid, row.bDown, row.aOut,
+                 row.bOut, count, args);
+}
+
+namespace {
+
+void rateCells(const float *__restrict aUp, const float *__restrict aMid,
+               const float *__restrict aDown, const float *__restrict bUp,
+               const float *__restrict bMid, const float *__restrict bDown,
+               float *__restrict aOut, float *__restrict bOut, int count, const SimArgs params) {
+  for (int x = 0; x < count; x++) {
+    float a = aMid[x];
+    float b = bMid[x];
+    float lapA = aUp[x] + aDown[x] + aMid[x - 1] + aMid[x + 1] - 4.0f * a;
+    float lapB = bUp[x] + bDown[x] + bMid[x - 1] + bMid[x + 1] - 4.0f * b;
+    float rateA, rateB;
+    grayScottRate(a, b, lapA, lapB, params, rateA, rateB);
+    aOut[x] = rateA;
+    bOut[x] = rateB;
+  }
+}
+
+} // namespace
+
+void ratePlaneRowScalar(const PlaneRow &row, int count, const SimArgs &args) {
+  rateCells(row.aUp, row.aMid, row.aDown, row.bUp, row.bMid, row.bDown, row.aOut, row.bOut,
+            count, args);
+}
+
+namespace {
+
+template <bool FeedField, bool KillField>
+void stepFieldCells(const float *__restrict aUp, const float *__restrict aMid,
+                    const float *__restrict aDown, const float *__restrict bUp,
+                    const float *__restrict bMid, const float *__restrict bDown,
+                    float *__restrict aOut, float *__restrict bOut,
+                    const float *__restrict feed, const float *__restrict kill, int count,
+                    const SimArgs params) {
+  for (int x = 0; x < count; x++) {
+    float a = aMid[x];
+    float b = bMid[x];
+    float lapA = aUp[x] + aDown[x] + aMid[x - 1] + aMid[x + 1] - 4.0f * a;
+    float lapB = bUp[x] + bDown[x] + bMid[x - 1] + bMid[x + 1] - 4.0f * b;
+    SimArgs cell = params;
+    if constexpr (FeedField) {
+      cell.feed = feed[x];
+    }
+    if constexpr (KillField) {
+      cell.kill = kill[x];
+    }
+    float aNew, bNew;
+    grayScottCell(a, b, lapA, lapB, cell, aNew, bNew);
+    aOut[x] = aNew;
+    bOut[x] = bNew;
+  }
+}
+
+} // namespace
+
+void stepFieldRowScalar(const PlaneRow &row, const FieldRow &field, int count,
+                        const SimArgs &args) {
+  auto run = [&](auto cells) {
+    cells(row.aUp, row.aMid, row.aDown, row.bUp, row.bMid, row.bDown, row.aOut, row.bOut,
+          field.feed, field.kill, count, args);
+  };
+  if (field.feed && field.kill) {
+    run(stepFieldCells<true, true>);
+  } else if (field.feed) {
+    run(stepFieldCells<true, false>);
+  } else if (field.kill) {
+    run(stepFieldCells<false, true>);
+  } else {
+    stepPlaneRowScalar(row, count, args);
+  }
+}
+
+namespace {
+
+void stepVolumeCells(const float *__restrict aUp, const float *__restrict aMid,
+                     const float *__restrict aDown, const float *__restrict aFront,
+                     const float *__restrict aBack, const float *__restrict bUp,
+                     const float *__restrict bMid, const float *__restrict bDown,
+                     const float *__restrict bFront, const float *__restrict bBack,
+                     float *__restrict aOut, float *__restrict bOut, int count,
+                     const SimArgs params) {
+  for (int x = 0; x < count; x++) {
+    float a = aMid[x];
+    float b = bMid[x];
+    float lapA = aUp[x] + aDown[x] + aFront[x] + aBack[x] + aMid[x - 1] + aMid[x + 1] - 6.0f * a;
+    float lapB = bUp[x] + bDown[x] + bFront[x] + bBack[x] + bMid[x - 1] + bMid[x + 1] - 6.0f * b;
+    float aNew, bNew;
+    grayScottCell(a, b, lapA, lapB, params, aNew, bNew);
+    aOut[x] = aNew;
+    bOut[x] = bNew;
+  }
+}
+
+} // namespace
+
+void stepVolumeRowScalar(const VolumeRow &row, int count, const SimArgs &args) {
+  const PlaneRow &p = row.plane;
+  stepVolumeCells(p.aUp, p.aMid, p.aDown, row.aFront, row.aBack, p.bUp, p.bMid, p.bDown,
+                  row.bFront, row.bBack, p.aOut, p.bOut, count, args);
+}
+
+namespace {
+
+void stepHexCells(const float *__restrict aUp, const float *__restrict aMid,
+                  const float *__restrict aDown, const float *__restrict bUp,
+                  const float *__restrict bMid, const float *__restrict bDown,
+                  float *__restrict aOut, float *__restrict bOut, int count,
+                  const SimArgs params) {
+  for (int x = 0; x < count; x++) {
+    float a = aMid[x];
+    float b = bMid[x];
+    float lapA = aMid[x - 1] + aMid[x + 1] + aUp[x] + aUp[x + 1] + aDown[x] + aDown[x + 1] -
+                 6.0f * a;
+    float lapB = bMid[x - 1] + bMid[x + 1] + bUp[x] + bUp[x + 1] + bDown[x] + bDown[x + 1] -
+                 6.0f * b;
+    float aNew, bNew;
+    grayScottCell(a, b, lapA, lapB, params, aNew, bNew);
+    aOut[x] = aNew;
+    bOut[x] = bNew;
+  }
+}
+
+} // namespace
+
+void stepHexRowScalar(const PlaneRow &row, int count, const SimArgs &args) {
+  stepHexCells(row.aUp, row.aMid, row.aDown, row.bUp, row.bMid, row.bDown, row.aOut, row.bOut,
+               count, args);
+}
+
+void stepMeshRowsScalar(const MeshRows &rows, int first, int count, const SimArgs &args) {
+  for (int v = first; v < first + count; v++) {
+    float a = rows.a[v];
+    float b = rows.b[v];
+    float lapA = 0.0f;
+    float lapB = 0.0f;
+    for (int k = rows.start[v]; k < rows.start[v + 1]; k++) {
+      const int u = rows.column[k];
+      lapA += rows.weight[k] * (rows.a[u] - a);
+      lapB += rows.weight[k] * (rows.b[u] - b);
+    }
+    float aNew, bNew;
+    grayScottCell(a, b, lapA, lapB, args, aNew, bNew);
+    rows.aOut[v] = aNew;
+    rows.bOut[v] = bNew;
+  }
+}
+
+namespace {
+
+// One cell per step: the vector type of the generic model kernel.
+struct Lane1 {
+  static constexpr int width = 1;
+  float v;
+
+  Lane1() = default;
+  Lane1(float x) : v(x) {}
+  static Lane1 load(const float *p) { return *p; }
+  void store(float *p) const { *p = v; }
+};
+
+inline Lane1 operator+(Lane1 a, Lane1 b) { return a.v + b.v; }
+inline Lane1 operator-(Lane1 a, Lane1 b) { return a.v - b.v; }
+inline Lane1 operator*(Lane1 a, Lane1 b) { return a.v * b.v; }
+inline Lane1 madd(Lane1 a, Lane1 b, Lane1 c) { return a.v * b.v + c.v; }
+inline Lane1 vmin(Lane1 a, Lane1 b) { return a.v < b.v ? a.v : b.v; }
+inline Lane1 vmax(Lane1 a, Lane1 b) { return a.v > b.v ? a.v : b.v; }
+
+template <class Model>
+void stepModelRowScalar(const ModelRow &row, int count, const ModelArgs &args) {
+  stepModelCells<Model, Lane1>(row, 0, count, args);
+}
+
+} // namespace
+
+ModelKernel modelKernelScalar(ReactionModel model) {
+  switch (model) {
+  case ReactionModel::GrayScott:
+    return stepModelRowScalar<GrayScottModel>;
+  case ReactionModel::Brusselator:
+    return stepModelRowScalar<BrusselatorModel>;
+  case ReactionModel::Schnakenberg:
+    return stepModelRowScalar<SchnakenbergModel>;
+  case ReactionModel::FitzHughNagumo:
+    return stepModelRowScalar<FitzHughNagumoModel>;
+  default:
+    return stepModelRowScalar<MayLeonardModel>;
+  }
+}
+
+namespace {
+
+template <class S>
+void stepStencilRowScalar(const StencilRow &row, int count, const SimArgs &args) {
+  stepStencilCells<S, Lane1>(row, 0, count, args);
+}
+
+} // namespace
+
+StencilKernel stencilKernelScalar(Stencil stencil) {
+  switch (stencil) {
+  case Stencil::NinePoint:
+    return stepStencilRowScalar<NinePointStencil>;
+  case Stencil::FourthOrder:
+    return stepStencilRowScalar<FourthOrderStencil>;
+  default:
+    return stepStencilRowScalar<FivePointStencil>;
+  }
+}
+
+void combineRowScalar(float *dst, const float *const *src, const float *weight, int terms,
+                      int count) {
+  for (int x = 0; x < count; x++) {
+    dst[x] = weight[0] * src[0][x];
+  }
+  for (int i = 1; i < terms; i++) {
+    for (int x = 0; x < count; x++) {
+      dst[x] += weight[i] * src[i][x];
+    }
+  }
+}
+
+void stepBatchRowScalar(const PlaneRow &row, int count, const BatchArgs &args) {
+  const int lanes = args.lanes;
+  for (int x = 0; x < count; x++) {
+    for (int l = 0; l < lanes; l++) {
+      const int i = x * lanes + l;
+      float a = row.aMid[i];
+      float b = row.bMid[i];
+      float lapA = row.aUp[i] + row.aDown[i] + row.aMid[i - lanes] + row.aMid[i + lanes] - 4.0f * a;
+      float lapB = row.bUp[i] + row.bDown[i] + row.bMid[i - lanes] + row.bMid[i + lanes] - 4.0f * b;
+      grayScottCell(a, b, lapA, lapB, args.lane[l], row.aOut[i], row.bOut[i]);
+    }
+  }
+}
+
+void widenFp16Scalar(const uint16_t *src, float *dst, int count, bool complement) {
+  for (int x = 0; x < count; x++) {
+    float value = fp16ToFloat(src[x]);
+    dst[x] = complement ? 1.0f - value : value;
+  }
+}
+
+void narrowFp16Scalar(const float *src, uint16_t *dst, int count, bool complement) {
+  for (int x = 0; x < count; x++) {
+    dst[x] = floatToFp16(complement ? 1.0f - src[x] : src[x]);
+  }
+}
+
+void widenBf16Scalar(const uint16_t *src, float *dst, int count, bool complement) {
+  for (int x = 0; x < count; x++) {
+    float value = bf16ToFloat(src[x]);
+    dst[x] = complement ? 1.0f - value : value;
+  }
+}
+
+void narrowBf16Scalar(const float *src, uint16_t *dst, int count, bool complement) {
+  for (int x = 0; x < count; x++) {
+    dst[x] = floatToBf16(complement ? 1.0f - src[x] : src[x]);
+  }
+}
+
+namespace {
+
+// pmulhrsw: (x * c + 2^14) >> 15.
+inline int mulQ15(int x, int c) { return (x * c + 0x4000) >> 15; }
+
+// paddsw / psubsw.
+inline int addSat(int x, int y) {
+  int sum = x + y;
+  return sum > 32767 ? 32767 : sum < -32768 ? -32768 : sum;
+}
+
+} // namespace
+
+void stepFixedRowScalar(const FixedPlaneRow &row, int count, const FixedArgs &k) {
+  for (int x = 0; x < count; x++) {
+    int a = row.aMid[x];
+    int b = row.bMid[x];
+    // Neighbour differences fit int16 where their sum would not.
+    int lapA = addSat(addSat(addSat(mulQ15(row.aUp[x] - a, k.diffA),
+                                    mulQ15(row.aDown[x] - a, k.diffA)),
+                             mulQ15(row.aMid[x - 1] - a, k.diffA)),
+                      mulQ15(row.aMid[x + 1] - a, k.diffA));
+    int lapB = addSat(addSat(addSat(mulQ15(row.bUp[x] - b, k.diffB),
+                                    mulQ15(row.bDown[x] - b, k.diffB)),
+                             mulQ15(row.bMid[x - 1] - b, k.diffB)),
+                      mulQ15(row.bMid[x + 1] - b, k.diffB));
+    int reaction = mulQ15(mulQ15(a, mulQ15(b, b)), k.reaction);
+    int deltaA = addSat(addSat(lapA, mulQ15(kFixedOne - a, k.feed)), -reaction);
+    int deltaB = addSat(addSat(lapB, reaction), -mulQ15(b, k.feedKill));
+    int aNew = addSat(a, deltaA);
+    int bNew = addSat(b, deltaB);
+    row.aOut[x] = static_cast<int16_t>(aNew < 0 ? 0 : aNew);
+    row.bOut[x] = static_cast<int16_t>(bNew < 0 ? 0 : bNew);
+  }
+}
+
+Isa detectIsa() {
+#ifdef RD_HAVE_AVX_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return Isa::Avx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+      __builtin_cpu_supports("f16c")) {
+    return Isa::Avx2;
+  }
+#endif
+  return Isa::Scalar;
+}
+
+const char *isaName(Isa isa) {
+  switch (isa) {
+  case Isa::Avx512:
+    return "avx512";
+  case Isa::Avx2:
+    return "avx2";
+  default:
+    return "scalar";
+  }
+}
+
+bool parseIsa(const std::string &name, Isa &isa) {
+  if (name == "auto") {
+    isa = detectIsa();
+  } else if (name == "scalar") {
+    isa = Isa::Scalar;
+  } else if (name == "avx2") {
+    isa = Isa::Avx2;
+  } else if (name == "avx512") {
+    isa = Isa::Avx512;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+Isa resolveIsa(Isa requested) {
+  Isa best = detectIsa();
+  return static_cast<int>(requested) > static_cast<int>(best) ? best : requested;
+}
+
+RowKernel rowKernel(Isa isa) {
+  switch (resolveIsa(isa)) {
+#ifdef RD_HAVE_AVX_KERNELS
+  case Isa::Avx512:
+    return stepRowAvx512;
+  case Isa::Avx2:
+    return stepRowAvx2;
+#endif
+  default:
+    return stepRowScalar;
+  }
+}
+
+PlaneKernel planeKernel(Isa isa) {
+  switch (resolveIsa(isa)) {
+#ifdef RD_HAVE_AVX_KERNELS
+  case Isa::Avx512:
+    return stepPlaneRowAvx512;
+  case Isa::Avx2:
+    return stepPlaneRowAvx2;
+#endif
+  default:
+    return stepPlaneRowScalar;
+  }
+}
+
+PlaneKernel rateKernel(Isa isa) {
+  switch (resolveIsa(isa)) {
+#ifdef RD_HAVE_AVX_KERNELS
+  case Isa::Avx512:
+    return ratePlaneRowAvx512;
+  case Isa::Avx2:
+    return ratePlaneRowAvx2;
+#endif
+  default:
+    return ratePlaneRowScalar;
+  }
+}
+
+FieldKernel fieldKernel(Isa isa) {
+  switch (resolveIsa(isa)) {
+#ifdef RD_HAVE_AVX_KERNELS
+  case Isa::Avx512:
+    return stepFieldRowAvx512;
+  case Isa::Avx2:
+    return stepFieldRowAvx2;
+#endif
+  default:
+    return stepFieldRowScalar;
+  }
+}
+
+VolumeKernel volumeKernel(Isa isa) {
+  switch (resolveIsa(isa)) {
+#ifdef RD_HAVE_AVX_KERNELS
+  case Isa::Avx512:
+    return stepVolumeRowAvx512;
+  case Isa::Avx2:
+    return stepVolumeRowAvx2;
+#endif
+  default:
+    return stepVolumeRowScalar;
+  }
+}
+
+PlaneKernel hexKernel(Isa isa) {
+  switch (resolveIsa(isa)) {
+#ifdef RD_HAVE_AVX_KERNELS
+  case Isa::Avx512:
+    return stepHexRowAvx512;
+  case Isa::Avx2:
+    return stepHexRowAvx2;
+#endif
+  default:
+    return stepHexRowScalar;
+  }
+}
+
+MeshKernel meshKernel(Isa isa) {
+  switch (resolveIsa(isa)) {
+#ifdef RD_HAVE_AVX_KERNELS
+  case Isa::Avx512:
+    return stepMeshRowsAvx512;
+  case Isa::Avx2:
+    return stepMeshRowsAvx2;
+#endif
+  default:
+    return stepMeshRowsScalar;
+  }
+}
+
+ModelKernel modelKernel(Isa isa, ReactionModel model) {
+  switch (resolveIsa(isa)) {
+#ifdef RD_HAVE_AVX_KERNELS
+  case Isa::Avx512:
+    return modelKernelAvx512(model);
+  case Isa::Avx2:
+    return modelKernelAvx2(model);
+#endif
+  default:
+    return modelKernelScalar(model);
+  }
+}
+
+StencilKernel stencilKernel(Isa isa, Stencil stencil) {
+  switch (resolveIsa(isa)) {
+#ifdef RD_HAVE_AVX_KERNELS
+  case Isa::Avx512:
+    return stencilKernelAvx512(stencil);
+  case Isa::Avx2:
+    return stencilKernelAvx2(stencil);
+#endif
+  default:
+    return stencilKernelScalar(stencil);
+  }
+}
+
+CombineKernel combineKernel(Isa isa) {
+  switch (resolveIsa(isa)) {
+#ifdef RD_HAVE_AVX_KERNELS
+  case Isa::Avx512:
+    return combineRowAvx512;
+  case Isa::Avx2:
+    return combineRowAvx2;
+#endif
+  default:
+    return combineRowScalar;
+  }
+}
+
+int batchLanes(Isa isa) {
+  return resolveIsa(isa) == Isa::Avx512 ? 16 : 8;
+}
+
+BatchKernel batchKernel(Isa isa) {
+  switch (resolveIsa(isa)) {
+#ifdef RD_HAVE_AVX_KERNELS
+  case Isa::Avx512:
+    return stepBatchRowAvx512;
+  case Isa::Avx2:
+    return stepBatchRowAvx2;
+#endif
+  default:
+    return stepBatchRowScalar;
+  }
+}
+
+HalfConversion halfConversion(Isa isa, HalfFormat format) {
+  const bool fp16 = format == HalfFormat::Fp16;
+#ifdef RD_HAVE_AVX_KERNELS
+  if (resolveIsa(isa) != Isa::Scalar) {
+    return fp16 ? HalfConversion{widenFp16Avx2, narrowFp16Avx2}
+                : HalfConversion{widenBf16Avx2, narrowBf16Avx2};
+  }
+#endif
+  return fp16 ? HalfConversion{widenFp16Scalar, narrowFp16Scalar}
+              : HalfConversion{widenBf16Scalar, narrowBf16Scalar};
+}
+
+FixedKernel fixedKernel(Isa isa) {
+#ifdef RD_HAVE_AVX_KERNELS
+  if (resolveIsa(isa) != Isa::Scalar) {
+    return stepFixedRowAvx2;
+  }
+#endif
+  return stepFixedRowScalar;
+}
@@ -0,0 +1,362 @@
+#pragma once
+// Gray-Scott update shared by the CPU engines. Mirrors sim_main in Shaders.metal.
+
+#include <algorithm>
+#include <string>
+#include "Config.hpp"
+#include "FixedPoint.hpp"
+#include "Grid.hpp"
+#include "HalfPlanes.hpp"
+#include "Models.hpp"
+#include "Stencils.hpp"
+
+// One cell update given the centre values and the 5-point laplacian
+//   [ 0  1  0
+//     1 -4  1
+//     0  1  0]
+// of A and B.
+inline void grayScottCell(float a, float b, float lapA, float lapB,
+                          const SimArgs &args, float &aNew, float &bNew) {
+  float reaction = a * b * b; // a * b^2
+  float deltaA = (args.diffA * lapA - reaction + args.feed * (1.0f - a));
+  float deltaB = (args.diffB * lapB + reaction - (args.feed + args.kill) * b);
+  aNew = std::clamp(a + args.timeStep * deltaA, 0.0f, 1.0f);
+  bNew = std::clamp(b + args.timeStep * deltaB, 0.0f, 1.0f);
+}
+
+// Time derivatives of one cell, without the step and the clamp.
+inline void grayScottRate(float a, float b, float lapA, float lapB, const SimArgs &args,
+                          float &rateA, float &rateB) {
+  float reaction = a * b * b;
+  rateA = args.diffA * lapA - reaction + args.feed * (1.0f - a);
+  rateB = args.diffB * lapB + reaction - (args.feed + args.kill) * b;
+}
+
+// Largest stable time step of an explicit method on the 5-point laplacian,
+// whose eigenvalues reach down to -8 * diff (-12 * diff for the 7-point one
+// of `dimensions` = 3). `stabilityRadius` is where the method's stability
+// region crosses the negative real axis: 2 for forward Euler (the limit
+// 0.25 / diff), about 2.51 for 3-stage third-order Runge-Kutta. The reaction
+// terms are slow in comparison and ignored.
+inline float explicitStepLimit(const SimArgs &args, float stabilityRadius, int dimensions = 2) {
+  return stabilityRadius / (4.0f * dimensions * std::max(args.diffA, args.diffB));
+}
+
+// Largest step at which forward Euler on the reaction terms alone does not
+// overshoot. Over A and B in [0, 1] the eigenvalues of the reaction jacobian
+// reach down to -(1 + feed), at A = 0 and B = 1, and a step h keeps
+// 1 + h lambda >= 0 up to 1 / (1 + feed). It bounds the engines that take
+// diffusion implicitly but the reaction explicitly.
+inline float reactionStepLimit(const SimArgs &args) { return 1.0f / (1.0f + args.feed); }
+
+// --- Row kernels ---
+// Update `count` consecutive cells of one interleaved row. `up`, `mid` and
+// `down` point at the first cell of the rows above, at and below; the left
+// and right neighbours of the span (mid[-2..-1] and mid[2 * count..]) must be
+// readable. Wrapping is left to the caller, which keeps the loop branch-free.
+// The AVX kernels round every cell the same way (FMA, fixed operation order)
+// whatever the span, so splitting a row differently never changes results.
+using RowKernel = void (*)(const float *up, const float *mid, const float *down,
+                           float *out, int count, const SimArgs &args);
+
+void stepRowScalar(const float *up, const float *mid, const float *down, float *out,
+                   int count, const SimArgs &args);
+#ifdef RD_HAVE_AVX_KERNELS
+void stepRowAvx2(const float *up, const float *mid, const float *down, float *out,
+                 int count, const SimArgs &args);
+void stepRowAvx512(const float *up, const float *mid, const float *down, float *out,
+                   int count, const SimArgs &args);
+#endif
+
+// Same update on structure-of-arrays storage: separate A and B planes, no
+// shuffling. Each pointer addresses the first cell of the span in its row;
+// the cells left and right of the span must be readable.
+struct PlaneRow {
+  const float *aUp, *aMid, *aDown;
+  const float *bUp, *bMid, *bDown;
+  float *aOut, *bOut;
+
+  PlaneRow at(int x) const {
+    return {aUp + x, aMid + x, aDown + x, bUp + x, bMid + x, bDown + x, aOut + x, bOut + x};
+  }
+};
+
+using PlaneKernel = void (*)(const PlaneRow &row, int count, const SimArgs &args);
+
+void stepPlaneRowScalar(const PlaneRow &row, int count, const SimArgs &args);
+#ifdef RD_HAVE_AVX_KERNELS
+void stepPlaneRowAvx2(const PlaneRow &row, int count, const SimArgs &args);
+void stepPlaneRowAvx512(const PlaneRow &row, int count, const SimArgs &args);
+#endif
+
+// Rate kernels: same stencil on planes, but aOut and bOut receive dA/dt and
+// dB/dt, unclamped, for integrators that combine several rates per step.
+// args.timeStep is ignored.
+void ratePlaneRowScalar(const PlaneRow &row, int count, const SimArgs &args);
+#ifdef RD_HAVE_AVX_KERNELS
+void ratePlaneRowAvx2(const PlaneRow &row, int count, const SimArgs &args);
+void ratePlaneRowAvx512(const PlaneRow &row, int count, const SimArgs &args);
+#endif
+
+// Field kernels: the plane update with feed and kill read per cell where the
+// pointers are set (aligned with the span, like the PlaneRow pointers) and
+// taken from args where they are null. With both null this is the plane
+// kernel. A separable (F, k) map passes the same feed array on every row and
+// its kill through args, so it streams no more memory than the plane kernel.
+struct FieldRow {
+  const float *feed;
+  const float *kill;
+};
+
+using FieldKernel = void (*)(const PlaneRow &row, const FieldRow &field, int count,
+                             const SimArgs &args);
+
+void stepFieldRowScalar(const PlaneRow &row, const FieldRow &field, int count,
+                        const SimArgs &args);
+#ifdef RD_HAVE_AVX_KERNELS
+void stepFieldRowAvx2(const PlaneRow &row, const FieldRow &field, int count,
+                      const SimArgs &args);
+void stepFieldRowAvx512(const PlaneRow &row, const FieldRow &field, int count,
+                        const SimArgs &args);
+#endif
+
+// Volume kernels: the 7-point laplacian
+//   front + back + up + down + left + right - 6 * centre
+// on a stack of planes. `plane` addresses the row in its own slice, the
+// other four pointers the same row of the slices in front and behind.
+struct VolumeRow {
+  PlaneRow plane;
+  const float *aFront, *aBack;
+  const float *bFront, *bBack;
+};
+
+using VolumeKernel = void (*)(const VolumeRow &row, int count, const SimArgs &args);
+
+void stepVolumeRowScalar(const VolumeRow &row, int count, const SimArgs &args);
+#ifdef RD_HAVE_AVX_KERNELS
+void stepVolumeRowAvx2(const VolumeRow &row, int count, const SimArgs &args);
+void stepVolumeRowAvx512(const VolumeRow &row, int count, const SimArgs &args);
+#endif
+
+// Stencil kernels: the plane update with the laplacian of any stencil of
+// Stencils.hpp, each stencil its own instantiation of the generic kernel in
+// StencilKernels.hpp. a[kMaxStencilRadius + dy] and b[...] address the
+// first cell of the span in row dy relative to it (rows beyond the
+// stencil's radius may be null), and the kMaxStencilRadius cells either side
+// of the span must be readable. The 5-point AVX kernels round exactly like
+// the plane kernels of their instruction set.
+struct StencilRow {
+  const float *a[2 * kMaxStencilRadius + 1];
+  const float *b[2 * kMaxStencilRadius + 1];
+  float *aOut, *bOut;
+};
+
+using StencilKernel = void (*)(const StencilRow &row, int count, const SimArgs &args);
+
+StencilKernel stencilKernelScalar(Stencil stencil);
+#ifdef RD_HAVE_AVX_KERNELS
+StencilKernel stencilKernelAvx2(Stencil stencil);
+StencilKernel stencilKernelAvx512(Stencil stencil);
+#endif
+
+// Hex kernels: the 6-neighbour sum
+//   left + right + upLeft + upRight + downLeft + downRight - 6 * centre
+// of a hexagonal lattice stored as offset rows (HexLattice.hpp). Same
+// PlaneRow as the plane kernels, but aUp/bUp and aDown/bDown address the
+// left one of the two neighbours in the row above and below, so the kernel
+// reads up[x] and up[x + 1] whatever the parity of the row. The lattice
+// weight of the sum is folded into args.diffA and args.diffB by the caller.
+void stepHexRowScalar(const PlaneRow &row, int count, const SimArgs &args);
+#ifdef RD_HAVE_AVX_KERNELS
+void stepHexRowAvx2(const PlaneRow &row, int count, const SimArgs &args);
+void stepHexRowAvx512(const PlaneRow &row, int count, const SimArgs &args);
+#endif
+
+// Mesh kernels: the update on vertices [first, first + count) of a triangle
+// mesh (Mesh.hpp), with the laplacian of v read from row v of a CSR matrix:
+//   lap(v) = sum over k in [start[v], start[v + 1]) of
+//            weight[k] * (u[column[k]] - u[v]),
+// summed in storage order. The AVX kernels take a vector of rows at a time,
+// gathering one entry of each row per iteration, and round every vertex like
+// their scalar tail, so the split into vertex ranges never changes results.
+struct MeshRows {
+  const int *start;
+  const int *column;
+  const float *weight;
+  const float *a, *b;
+  float *aOut, *bOut;
+};
+
+using MeshKernel = void (*)(const MeshRows &rows, int first, int count, const SimArgs &args);
+
+void stepMeshRowsScalar(const MeshRows &rows, int first, int count, const SimArgs &args);
+#ifdef RD_HAVE_AVX_KERNELS
+void stepMeshRowsAvx2(const MeshRows &rows, int first, int count, const SimArgs &args);
+void stepMeshRowsAvx512(const MeshRows &rows, int first, int count, const SimArgs &args);
+#endif
+
+// Reaction model kernels: the plane update for any model of Models.hpp, one
+// plane per species. Each model is its own instantiation of the generic
+// kernel in ModelKernels.hpp, with the species loop and the reaction unrolled
+// at compile time; the selectors return the instantiation for a model.
+struct ModelRow {
+  const float *up[kMaxSpecies], *mid[kMaxSpecies], *down[kMaxSpecies];
+  float *out[kMaxSpecies];
+};
+
+using ModelKernel = void (*)(const ModelRow &row, int count, const ModelArgs &args);
+
+ModelKernel modelKernelScalar(ReactionModel model);
+#ifdef RD_HAVE_AVX_KERNELS
+ModelKernel modelKernelAvx2(ReactionModel model);
+ModelKernel modelKernelAvx512(ReactionModel model);
+#endif
+
+// Weighted sums of rows for integrators that combine stages:
+// dst[x] = sum of weight[i] * src[i][x] over i < terms. The sum is built one
+// term at a time over the whole row (which stays in L1), so consecutive
+// vectors are independent instead of waiting on one chain of FMAs. dst must
+// not be one of the sources.
+using CombineKernel = void (*)(float *dst, const float *const *src, const float *weight,
+                               int terms, int count);
+
+void combineRowScalar(float *dst, const float *const *src, const float *weight, int terms,
+                      int count);
+#ifdef RD_HAVE_AVX_KERNELS
+void combineRowAvx2(float *dst, const float *const *src, const float *weight, int terms,
+                    int count);
+void combineRowAvx512(float *dst, const float *const *src, const float *weight, int terms,
+                      int count);
+#endif
+
+// Parameter sweep kernels: a batch of grids interleaved lane by lane, cell x
+// of the batch's grid l at [x * lanes + l] of each plane row, so one vector
+// holds the same cell of every configuration. Each lane has its own SimArgs;
+// horizontal neighbours are `lanes` floats apart. Rows are addressed with
+// PlaneRow as on plain planes, `count` is in cells, and the `lanes` floats
+// either side of the span must be readable. Same arithmetic per lane as the
+// plane kernel of the same instruction set.
+constexpr int kMaxBatchLanes = 16;
+
+struct BatchArgs {
+  int lanes = 0;
+  SimArgs lane[kMaxBatchLanes];
+};
+
+using BatchKernel = void (*)(const PlaneRow &row, int count, const BatchArgs &args);
+
+// Any lane count up to kMaxBatchLanes.
+void stepBatchRowScalar(const PlaneRow &row, int count, const BatchArgs &args);
+#ifdef RD_HAVE_AVX_KERNELS
+// One cell of the batch per iteration: 8 lanes for AVX2, 16 for AVX-512.
+void stepBatchRowAvx2(const PlaneRow &row, int count, const BatchArgs &args);
+void stepBatchRowAvx512(const PlaneRow &row, int count, const BatchArgs &args);
+#endif
+
+// Conversions between half-precision plane rows and float rows. The half
+// engines widen rows into float buffers, run the plane kernel on those and
+// round the results back, so the arithmetic is exactly that of the soa engine.
+// With `complement` set the stored values are 1 - x (the A plane).
+using WidenKernel = void (*)(const uint16_t *src, float *dst, int count, bool complement);
+using NarrowKernel = void (*)(const float *src, uint16_t *dst, int count, bool complement);
+
+struct HalfConversion {
+  WidenKernel widen;
+  NarrowKernel narrow;
+};
+
+void widenFp16Scalar(const uint16_t *src, float *dst, int count, bool complement);
+void narrowFp16Scalar(const float *src, uint16_t *dst, int count, bool complement);
+void widenBf16Scalar(const uint16_t *src, float *dst, int count, bool complement);
+void narrowBf16Scalar(const float *src, uint16_t *dst, int count, bool complement);
+#ifdef RD_HAVE_AVX_KERNELS
+// F16C for fp16, integer shifts for bf16.
+void widenFp16Avx2(const uint16_t *src, float *dst, int count, bool complement);
+void narrowFp16Avx2(const float *src, uint16_t *dst, int count, bool complement);
+void widenBf16Avx2(const uint16_t *src, float *dst, int count, bool complement);
+void narrowBf16Avx2(const float *src, uint16_t *dst, int count, bool complement);
+#endif
+
+// Fixed-point update on int16 planes (see FixedPoint.hpp). Integer math
+// only: pmulhrsw-style products, saturating adds, and a saturating final add
+// in place of the clamp to 1. The scalar and AVX2 kernels give identical
+// results.
+struct FixedPlaneRow {
+  const int16_t *aUp, *aMid, *aDown;
+  const int16_t *bUp, *bMid, *bDown;
+  int16_t *aOut, *bOut;
+};
+
+using FixedKernel = void (*)(const FixedPlaneRow &row, int count, const FixedArgs &args);
+
+void stepFixedRowScalar(const FixedPlaneRow &row, int count, const FixedArgs &args);
+#ifdef RD_HAVE_AVX_KERNELS
+// 16 cells per iteration, twice the lanes of the float kernel.
+void stepFixedRowAvx2(const FixedPlaneRow &row, int count, const FixedArgs &args);
+#endif
+
+// Instruction sets a kernel can be built for, narrowest first.
+enum class Isa { Scalar, Avx2, Avx512 };
+
+// Widest instruction set this CPU (and build) supports.
+Isa detectIsa();
+const char *isaName(Isa isa);
+// Parses "scalar", "avx2", "avx512" or "auto". Returns false on anything else.
+bool parseIsa(const std::string &name, Isa &isa);
+// Clamps a requested instruction set to what is actually available.
+Isa resolveIsa(Isa requested);
+RowKernel rowKernel(Isa isa);
+PlaneKernel planeKernel(Isa isa);
+PlaneKernel rateKernel(Isa isa);
+FieldKernel fieldKernel(Isa isa);
+VolumeKernel volumeKernel(Isa isa);
+PlaneKernel hexKernel(Isa isa);
+MeshKernel meshKernel(Isa isa);
+ModelKernel modelKernel(Isa isa, ReactionModel model);
+StencilKernel stencilKernel(Isa isa, Stencil stencil);
+CombineKernel combineKernel(Isa isa);
+// Lanes of the batch kernel: the vector width in floats, 8 for scalar.
+int batchLanes(Isa isa);
+BatchKernel batchKernel(Isa isa);
+// The AVX-512 level uses the AVX2 conversions.
+HalfConversion halfConversion(Isa isa, HalfFormat format);
+// The AVX-512 level uses the AVX2 kernel: 16-bit lanes on zmm need AVX-512BW.
+FixedKernel fixedKernel(Isa isa);
+
+// Steps the cells [x0, x1) x [y0, y1) of `in` into `out` with periodic
+// wrapping. Only the first and last column of the grid need wrapped
+// neighbours; everything else is handed to `kernel` row by row.
+inline void stepRegionPeriodic(const Grid &in, Grid &out, int x0, int x1, int y0, int y1,
+                               RowKernel kernel, const SimArgs &args) {
+  const int w = in.width;
+  const int h = in.height;
+  for (int y = y0; y < y1; y++) {
+    const float *up = in.row((y + h - 1) % h);
+    const float *mid = in.row(y);
+    const float *down = in.row((y + 1) % h);
+    float *dst = out.row(y);
+    int first = x0;
+    int last = x1;
+    // The two wrapped columns gather their neighbours into a small buffer and
+    // go through the same kernel, so every cell is rounded identically.
+    auto wrappedCell = [&](int x) {
+      int left = (x + w - 1) % w;
+      int right = (x + 1) % w;
+      float cells[6] = {mid[2 * left], mid[2 * left + 1], mid[2 * x],
+                        mid[2 * x + 1], mid[2 * right], mid[2 * right + 1]};
+      kernel(up + 2 * x, cells + 2, down + 2 * x, dst + 2 * x, 1, args);
+    };
+    if (first == 0) {
+      wrappedCell(0);
+      first = 1;
+    }
+    if (last == w && last > first) {
+      wrappedCell(w - 1);
+      last = w - 1;
+    }
+    if (last > first) {
+      int i = 2 * first;
+      kernel(up + i, mid + i, down + i, dst + i, last - first, args);
+    }
+  }
+}
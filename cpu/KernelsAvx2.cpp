@@ -0,0 +1,636 @@
+// AVX2 + FMA row kernels, 8 cells per iteration, plus F16C conversions for the
+// half-precision planes. Built with -mavx2 -mfma -mf16c and only called after
+// detectIsa() confirms support.
+
+#include <immintrin.h>
+#include <math.h>
+#include <string.h>
+#include "Kernels.hpp"
+#include "ModelKernels.hpp"
+#include "StencilKernels.hpp"
+
+namespace {
+
+struct Constants {
+  __m256 zero, one, four, diffA, diffB, feed, feedKill, dt;
+
+  explicit Constants(const SimArgs &args)
+      : zero(_mm256_setzero_ps()), one(_mm256_set1_ps(1.0f)), four(_mm256_set1_ps(4.0f)),
+        diffA(_mm256_set1_ps(args.diffA)), diffB(_mm256_set1_ps(args.diffB)),
+        feed(_mm256_set1_ps(args.feed)), feedKill(_mm256_set1_ps(args.feed + args.kill)),
+        dt(_mm256_set1_ps(args.timeStep)) {}
+
+  // Per-lane parameters of a sweep batch, one configuration per lane.
+  explicit Constants(const BatchArgs &args)
+      : zero(_mm256_setzero_ps()), one(_mm256_set1_ps(1.0f)), four(_mm256_set1_ps(4.0f)),
+        diffA(perLane(args, &SimArgs::diffA)), diffB(perLane(args, &SimArgs::diffB)),
+        feed(perLane(args, &SimArgs::feed)),
+        feedKill(_mm256_add_ps(feed, perLane(args, &SimArgs::kill))),
+        dt(perLane(args, &SimArgs::timeStep)) {}
+
+  static __m256 perLane(const BatchArgs &args, float SimArgs::*field) {
+    float values[8];
+    for (int l = 0; l < 8; l++) {
+      values[l] = args.lane[l].*field;
+    }
+    return _mm256_loadu_ps(values);
+  }
+};
+
+// Gray-Scott update of 8 cells given the centre values and their laplacians.
+inline void react(const Constants &k, __m256 a, __m256 b, __m256 lapA, __m256 lapB,
+                  __m256 &aNew, __m256 &bNew) {
+  __m256 reaction = _mm256_mul_ps(a, _mm256_mul_ps(b, b));
+  __m256 deltaA = _mm256_fmadd_ps(
+      k.diffA, lapA, _mm256_fmsub_ps(k.feed, _mm256_sub_ps(k.one, a), reaction));
+  __m256 deltaB = _mm256_fmadd_ps(k.diffB, lapB, _mm256_fnmadd_ps(k.feedKill, b, reaction));
+  aNew = _mm256_min_ps(_mm256_max_ps(_mm256_fmadd_ps(k.dt, deltaA, a), k.zero), k.one);
+  bNew = _mm256_min_ps(_mm256_max_ps(_mm256_fmadd_ps(k.dt, deltaB, b), k.zero), k.one);
+}
+
+// Gray-Scott update of 8 cells given the centre values and the sums of their
+// vertical and horizontal neighbours.
+inline void update(const Constants &k, __m256 a, __m256 b, __m256 vertA, __m256 horzA,
+                   __m256 vertB, __m256 horzB, __m256 &aNew, __m256 &bNew) {
+  react(k, a, b, _mm256_fnmadd_ps(k.four, a, _mm256_add_ps(vertA, horzA)),
+        _mm256_fnmadd_ps(k.four, b, _mm256_add_ps(vertB, horzB)), aNew, bNew);
+}
+
+// update() without the step and the clamp: the time derivatives.
+inline void rate(const Constants &k, __m256 a, __m256 b, __m256 vertA, __m256 horzA,
+                 __m256 vertB, __m256 horzB, __m256 &rateA, __m256 &rateB) {
+  __m256 lapA = _mm256_fnmadd_ps(k.four, a, _mm256_add_ps(vertA, horzA));
+  __m256 lapB = _mm256_fnmadd_ps(k.four, b, _mm256_add_ps(vertB, horzB));
+  __m256 reaction = _mm256_mul_ps(a, _mm256_mul_ps(b, b));
+  rateA = _mm256_fmadd_ps(k.diffA, lapA,
+                          _mm256_fmsub_ps(k.feed, _mm256_sub_ps(k.one, a), reaction));
+  rateB = _mm256_fmadd_ps(k.diffB, lapB, _mm256_fnmadd_ps(k.feedKill, b, reaction));
+}
+
+// Scalar versions of react() and update() with the exact same operation
+// order, for the remainder of a row, so a cell's result does not depend on
+// whether it landed in the tail. Sticks to C functions and plain expressions: an inline C++
+// template instantiated in this AVX2-compiled file could be picked by the
+// linker for baseline callers.
+inline void reactCell(const SimArgs &args, float a, float b, float lapA, float lapB,
+                      float &aOut, float &bOut) {
+  float reaction = a * (b * b);
+  float deltaA = fmaf(args.diffA, lapA, fmaf(args.feed, 1.0f - a, -reaction));
+  float deltaB = fmaf(args.diffB, lapB, fmaf(-(args.feed + args.kill), b, reaction));
+  float aNew = fmaf(args.timeStep, deltaA, a);
+  float bNew = fmaf(args.timeStep, deltaB, b);
+  aOut = aNew < 0.0f ? 0.0f : aNew > 1.0f ? 1.0f : aNew;
+  bOut = bNew < 0.0f ? 0.0f : bNew > 1.0f ? 1.0f : bNew;
+}
+
+inline void updateCell(const SimArgs &args, float a, float b, float vertA, float horzA,
+                       float vertB, float horzB, float &aOut, float &bOut) {
+  reactCell(args, a, b, fmaf(-4.0f, a, vertA + horzA), fmaf(-4.0f, b, vertB + horzB), aOut,
+            bOut);
+}
+
+// Splits 8 interleaved cells into A and B vectors. The cell order inside the
+// vectors is permuted (0 1 4 5 | 2 3 6 7), which is harmless for element-wise
+// math as long as every operand is split the same way and interleave() undoes it.
+inline void deinterleave(const float *p, __m256 &a, __m256 &b) {
+  __m256 lo = _mm256_loadu_ps(p);
+  __m256 hi = _mm256_loadu_ps(p + 8);
+  a = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+  b = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+inline void interleave(float *p, __m256 a, __m256 b) {
+  _mm256_storeu_ps(p, _mm256_unpacklo_ps(a, b));
+  _mm256_storeu_ps(p + 8, _mm256_unpackhi_ps(a, b));
+}
+
+} // namespace
+
+void stepRowAvx2(const float *up, const float *mid, const float *down, float *out,
+                 int count, const SimArgs &args) {
+  const Constants k(args);
+  int x = 0;
+  for (; x + 8 <= count; x += 8) {
+    int i = 2 * x;
+    __m256 a, b, upA, upB, downA, downB, leftA, leftB, rightA, rightB, aNew, bNew;
+    deinterleave(mid + i, a, b);
+    deinterleave(up + i, upA, upB);
+    deinterleave(down + i, downA, downB);
+    deinterleave(mid + i - 2, leftA, leftB);
+    deinterleave(mid + i + 2, rightA, rightB);
+    update(k, a, b, _mm256_add_ps(upA, downA), _mm256_add_ps(leftA, rightA),
+           _mm256_add_ps(upB, downB), _mm256_add_ps(leftB, rightB), aNew, bNew);
+    interleave(out + i, aNew, bNew);
+  }
+  for (; x < count; x++) {
+    int i = 2 * x;
+    updateCell(args, mid[i], mid[i + 1], up[i] + down[i], mid[i - 2] + mid[i + 2],
+               up[i + 1] + down[i + 1], mid[i - 1] + mid[i + 3], out[i], out[i + 1]);
+  }
+}
+
+void stepPlaneRowAvx2(const PlaneRow &row, int count, const SimArgs &args) {
+  const Constants k(args);
+  int x = 0;
+  for (; x + 8 <= count; x += 8) {
+    __m256 aNew, bNew;
+    update(k, _mm256_loadu_ps(row.aMid + x), _mm256_loadu_ps(row.bMid + x),
+           _mm256_add_ps(_mm256_loadu_ps(row.aUp + x), _mm256_loadu_ps(row.aDown + x)),
+           _mm256_add_ps(_mm256_loadu_ps(row.aMid + x - 1), _mm256_loadu_ps(row.aMid + x + 1)),
+           _mm256_add_ps(_mm256_loadu_ps(row.bUp + x), _mm256_loadu_ps(row.bDown + x)),
+           _mm256_add_ps(_mm256_loadu_ps(row.bMid + x - 1), _mm256_loadu_ps(row.bMid + x + 1)),
+           aNew, bNew);
+    _mm256_storeu_ps(row.aOut + x, aNew);
+    _mm256_storeu_ps(row.bOut + x, bNew);
+  }
+  for (; x < count; x++) {
+    updateCell(args, row.aMid[x], row.bMid[x], row.aUp[x] + row.aDown[x],
+               row.aMid[x - 1] + row.aMid[x + 1], row.bUp[x] + row.bDown[x],
+               row.bMid[x - 1] + row.bMid[x + 1], row.aOut[x], row.bOut[x]);
+  }
+}
+
+void ratePlaneRowAvx2(const PlaneRow &row, int count, const SimArgs &args) {
+  const Constants k(args);
+  int x = 0;
+  for (; x + 8 <= count; x += 8) {
+    __m256 rateA, rateB;
+    rate(k, _mm256_loadu_ps(row.aMid + x), _mm256_loadu_ps(row.bMid + x),
+         _mm256_add_ps(_mm256_loadu_ps(row.aUp + x), _mm256_loadu_ps(row.aDown + x)),
+         _mm256_add_ps(_mm256_loadu_ps(row.aMid + x - 1), _mm256_loadu_ps(row.aMid + x + 1)),
+         _mm256_add_ps(_mm256_loadu_ps(row.bUp + x), _mm256_loadu_ps(row.bDown + x)),
+         _mm256_add_ps(_mm256_loadu_ps(row.bMid + x - 1), _mm256_loadu_ps(row.bMid + x + 1)),
+         rateA, rateB);
+    _mm256_storeu_ps(row.aOut + x, rateA);
+    _mm256_storeu_ps(row.bOut + x, rateB);
+  }
+  for (; x < count; x++) {
+    float a = row.aMid[x];
+    float b = row.bMid[x];
+    float lapA = fmaf(-4.0f, a, (row.aUp[x] + row.aDown[x]) + (row.aMid[x - 1] + row.aMid[x + 1]));
+    float lapB = fmaf(-4.0f, b, (row.bUp[x] + row.bDown[x]) + (row.bMid[x - 1] + row.bMid[x + 1]));
+    float reaction = a * (b * b);
+    row.aOut[x] = fmaf(args.diffA, lapA, fmaf(args.feed, 1.0f - a, -reaction));
+    row.bOut[x] = fmaf(args.diffB, lapB, fmaf(-(args.feed + args.kill), b, reaction));
+  }
+}
+
+namespace {
+
+// stepPlaneRowAvx2 with feed and/or kill loaded per cell. feedKill is summed
+// in the same order as Constants does, so uniform fields round like the
+// plane kernel.
+template <bool FeedField, bool KillField>
+void stepFieldCells(const PlaneRow &row, const FieldRow &field, int count, const SimArgs &args) {
+  Constants k(args);
+  const __m256 kill = _mm256_set1_ps(args.kill);
+  int x = 0;
+  for (; x + 8 <= count; x += 8) {
+    if (FeedField) {
+      k.feed = _mm256_loadu_ps(field.feed + x);
+    }
+    k.feedKill = _mm256_add_ps(k.feed, KillField ? _mm256_loadu_ps(field.kill + x) : kill);
+    __m256 aNew, bNew;
+    update(k, _mm256_loadu_ps(row.aMid + x), _mm256_loadu_ps(row.bMid + x),
+           _mm256_add_ps(_mm256_loadu_ps(row.aUp + x), _mm256_loadu_ps(row.aDown + x)),
+           _mm256_add_ps(_mm256_loadu_ps(row.aMid + x - 1), _mm256_loadu_ps(row.aMid + x + 1)),
+           _mm256_add_ps(_mm256_loadu_ps(row.bUp + x), _mm256_loadu_ps(row.bDown + x)),
+           _mm256_add_ps(_mm256_loadu_ps(row.bMid + x - 1), _mm256_loadu_ps(row.bMid + x + 1)),
+           aNew, bNew);
+    _mm256_storeu_ps(row.aOut + x, aNew);
+    _mm256_storeu_ps(row.bOut + x, bNew);
+  }
+  SimArgs cell = args;
+  for (; x < count; x++) {
+    if (FeedField) {
+      cell.feed = field.feed[x];
+    }
+    if (KillField) {
+      cell.kill = field.kill[x];
+    }
+    updateCell(cell, row.aMid[x], row.bMid[x], row.aUp[x] + row.aDown[x],
+               row.aMid[x - 1] + row.aMid[x + 1], row.bUp[x] + row.bDown[x],
+               row.bMid[x - 1] + row.bMid[x + 1], row.aOut[x], row.bOut[x]);
+  }
+}
+
+} // namespace
+
+void stepFieldRowAvx2(const PlaneRow &row, const FieldRow &field, int count,
+                      const SimArgs &args) {
+  if (field.feed && field.kill) {
+    stepFieldCells<true, true>(row, field, count, args);
+  } else if (field.feed) {
+    stepFieldCells<true, false>(row, field, count, args);
+  } else if (field.kill) {
+    stepFieldCells<false, true>(row, field, count, args);
+  } else {
+    stepPlaneRowAvx2(row, count, args);
+  }
+}
+
+void stepVolumeRowAvx2(const VolumeRow &row, int count, const SimArgs &args) {
+  const Constants k(args);
+  const __m256 six = _mm256_set1_ps(6.0f);
+  const PlaneRow &p = row.plane;
+  int x = 0;
+  for (; x + 8 <= count; x += 8) {
+    __m256 a = _mm256_loadu_ps(p.aMid + x);
+    __m256 b = _mm256_loadu_ps(p.bMid + x);
+    __m256 sumA = _mm256_add_ps(
+        _mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(p.aUp + x), _mm256_loadu_ps(p.aDown + x)),
+                      _mm256_add_ps(_mm256_loadu_ps(row.aFront + x),
+                                    _mm256_loadu_ps(row.aBack + x))),
+        _mm256_add_ps(_mm256_loadu_ps(p.aMid + x - 1), _mm256_loadu_ps(p.aMid + x + 1)));
+    __m256 sumB = _mm256_add_ps(
+        _mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(p.bUp + x), _mm256_loadu_ps(p.bDown + x)),
+                      _mm256_add_ps(_mm256_loadu_ps(row.bFront + x),
+                                    _mm256_loadu_ps(row.bBack + x))),
+        _mm256_add_ps(_mm256_loadu_ps(p.bMid + x - 1), _mm256_loadu_ps(p.bMid + x + 1)));
+    __m256 aNew, bNew;
+    react(k, a, b, _mm256_fnmadd_ps(six, a, sumA), _mm256_fnmadd_ps(six, b, sumB), aNew, bNew);
+    _mm256_storeu_ps(p.aOut + x, aNew);
+    _mm256_storeu_ps(p.bOut + x, bNew);
+  }
+  for (; x < count; x++) {
+    float a = p.aMid[x];
+    float b = p.bMid[x];
+    float sumA = ((p.aUp[x] + p.aDown[x]) + (row.aFront[x] + row.aBack[x])) +
+                 (p.aMid[x - 1] + p.aMid[x + 1]);
+    float sumB = ((p.bUp[x] + p.bDown[x]) + (row.bFront[x] + row.bBack[x])) +
+                 (p.bMid[x - 1] + p.bMid[x + 1]);
+    reactCell(args, a, b, fmaf(-6.0f, a, sumA), fmaf(-6.0f, b, sumB), p.aOut[x], p.bOut[x]);
+  }
+}
+
+void stepHexRowAvx2(const PlaneRow &row, int count, const SimArgs &args) {
+  const Constants k(args);
+  const __m256 six = _mm256_set1_ps(6.0f);
+  int x = 0;
+  for (; x + 8 <= count; x += 8) {
+    __m256 a = _mm256_loadu_ps(row.aMid + x);
+    __m256 b = _mm256_loadu_ps(row.bMid + x);
+    __m256 sumA = _mm256_add_ps(
+        _mm256_add_ps(_mm256_loadu_ps(row.aMid + x - 1), _mm256_loadu_ps(row.aMid + x + 1)),
+        _mm256_add_ps(_mm256_loadu_ps(row.aUp + x), _mm256_loadu_ps(row.aUp + x + 1)));
+    sumA = _mm256_add_ps(
+        sumA, _mm256_add_ps(_mm256_loadu_ps(row.aDown + x), _mm256_loadu_ps(row.aDown + x + 1)));
+    __m256 sumB = _mm256_add_ps(
+        _mm256_add_ps(_mm256_loadu_ps(row.bMid + x - 1), _mm256_loadu_ps(row.bMid + x + 1)),
+        _mm256_add_ps(_mm256_loadu_ps(row.bUp + x), _mm256_loadu_ps(row.bUp + x + 1)));
+    sumB = _mm256_add_ps(
+        sumB, _mm256_add_ps(_mm256_loadu_ps(row.bDown + x), _mm256_loadu_ps(row.bDown + x + 1)));
+    __m256 aNew, bNew;
+    react(k, a, b, _mm256_fnmadd_ps(six, a, sumA), _mm256_fnmadd_ps(six, b, sumB), aNew, bNew);
+    _mm256_storeu_ps(row.aOut + x, aNew);
+    _mm256_storeu_ps(row.bOut + x, bNew);
+  }
+  for (; x < count; x++) {
+    float a = row.aMid[x];
+    float b = row.bMid[x];
+    float sumA = ((row.aMid[x - 1] + row.aMid[x + 1]) + (row.aUp[x] + row.aUp[x + 1])) +
+                 (row.aDown[x] + row.aDown[x + 1]);
+    float sumB = ((row.bMid[x - 1] + row.bMid[x + 1]) + (row.bUp[x] + row.bUp[x + 1])) +
+                 (row.bDown[x] + row.bDown[x + 1]);
+    reactCell(args, a, b, fmaf(-6.0f, a, sumA), fmaf(-6.0f, b, sumB), row.aOut[x],
+              row.bOut[x]);
+  }
+}
+
+void stepMeshRowsAvx2(const MeshRows &rows, int first, int count, const SimArgs &args) {
+  const Constants k(args);
+  const __m256i step = _mm256_set1_epi32(1);
+  const int end = first + count;
+  int v = first;
+  for (; v + 8 <= end; v += 8) {
+    __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows.start + v));
+    const __m256i stop = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows.start + v + 1));
+    alignas(32) int length[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(length), _mm256_sub_epi32(stop, index));
+    int longest = 0;
+    for (int lane = 0; lane < 8; lane++) {
+      longest = length[lane] > longest ? length[lane] : longest;
+    }
+    const __m256 a = _mm256_loadu_ps(rows.a + v);
+    const __m256 b = _mm256_loadu_ps(rows.b + v);
+    __m256 lapA = k.zero;
+    __m256 lapB = k.zero;
+    // Lanes past the end of their row gather weight 0 and their own value,
+    // which adds exactly nothing.
+    for (int i = 0; i < longest; i++) {
+      const __m256i live = _mm256_cmpgt_epi32(stop, index);
+      const __m256 liveMask = _mm256_castsi256_ps(live);
+      const __m256i u = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), rows.column, index,
+                                                    live, 4);
+      const __m256 w = _mm256_mask_i32gather_ps(k.zero, rows.weight, index, liveMask, 4);
+      const __m256 au = _mm256_mask_i32gather_ps(a, rows.a, u, liveMask, 4);
+      const __m256 bu = _mm256_mask_i32gather_ps(b, rows.b, u, liveMask, 4);
+      lapA = _mm256_fmadd_ps(w, _mm256_sub_ps(au, a), lapA);
+      lapB = _mm256_fmadd_ps(w, _mm256_sub_ps(bu, b), lapB);
+      index = _mm256_add_epi32(index, step);
+    }
+    __m256 aNew, bNew;
+    react(k, a, b, lapA, lapB, aNew, bNew);
+    _mm256_storeu_ps(rows.aOut + v, aNew);
+    _mm256_storeu_ps(rows.bOut + v, bNew);
+  }
+  for (; v < end; v++) {
+    float a = rows.a[v];
+    float b = rows.b[v];
+    float lapA = 0.0f;
+    float lapB = 0.0f;
+    for (int i = rows.start[v]; i < rows.start[v + 1]; i++) {
+      const int u = rows.column[i];
+      lapA = fmaf(rows.weight[i], rows.a[u] - a, lapA);
+      lapB = fmaf(rows.weight[i], rows.b[u] - b, lapB);
+    }
+    reactCell(args, a, b, lapA, lapB, rows.aOut[v], rows.bOut[v]);
+  }
+}
+
+void combineRowAvx2(float *dst, const float *const *src, const float *weight, int terms,
+                    int count) {
+  const int vectorEnd = count - count % 8;
+  for (int i = 0; i < terms; i++) {
+    const __m256 w = _mm256_set1_ps(weight[i]);
+    const float *in = src[i];
+    if (i == 0) {
+      for (int x = 0; x < vectorEnd; x += 8) {
+        _mm256_storeu_ps(dst + x, _mm256_mul_ps(w, _mm256_loadu_ps(in + x)));
+      }
+      for (int x = vectorEnd; x < count; x++) {
+        dst[x] = weight[i] * in[x];
+      }
+    } else {
+      for (int x = 0; x < vectorEnd; x += 8) {
+        _mm256_storeu_ps(dst + x,
+                         _mm256_fmadd_ps(w, _mm256_loadu_ps(in + x), _mm256_loadu_ps(dst + x)));
+      }
+      for (int x = vectorEnd; x < count; x++) {
+        dst[x] = fmaf(weight[i], in[x], dst[x]);
+      }
+    }
+  }
+}
+
+namespace {
+
+// Widening loads and rounding stores for 8 half-precision cells.
+struct Fp16Lanes {
+  static __m256 load(const uint16_t *p) {
+    return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+  }
+  static void store(uint16_t *p, __m256 v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p),
+                     _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+};
+
+struct Bf16Lanes {
+  static __m256 load(const uint16_t *p) {
+    __m256i wide = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(wide, 16));
+  }
+  // Round to nearest even on the dropped bits, as floatToBf16 does.
+  static void store(uint16_t *p, __m256 v) {
+    __m256i bits = _mm256_castps_si256(v);
+    __m256i odd = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+    __m256i rounded = _mm256_add_epi32(bits, _mm256_add_epi32(_mm256_set1_epi32(0x7fff), odd));
+    __m256i top = _mm256_srli_epi32(rounded, 16);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p),
+                     _mm_packus_epi32(_mm256_castsi256_si128(top),
+                                      _mm256_extracti128_si256(top, 1)));
+  }
+};
+
+// 1 - v when complementing, v otherwise: (v xor sign) + one, or v + 0.
+struct Complement {
+  __m256 sign, offset;
+
+  explicit Complement(bool complement)
+      : sign(_mm256_set1_ps(complement ? -0.0f : 0.0f)),
+        offset(_mm256_set1_ps(complement ? 1.0f : 0.0f)) {}
+
+  __m256 apply(__m256 v) const { return _mm256_add_ps(_mm256_xor_ps(v, sign), offset); }
+};
+
+template <class Lanes>
+void widenRow(const uint16_t *src, float *dst, int count, bool complement) {
+  const Complement c(complement);
+  int x = 0;
+  for (; x + 8 <= count; x += 8) {
+    _mm256_storeu_ps(dst + x, c.apply(Lanes::load(src + x)));
+  }
+  if (x < count) {
+    // Through a zero-padded buffer, so the tail uses the same conversion.
+    uint16_t in[8] = {};
+    float out[8];
+    memcpy(in, src + x, (count - x) * sizeof(uint16_t));
+    _mm256_storeu_ps(out, c.apply(Lanes::load(in)));
+    memcpy(dst + x, out, (count - x) * sizeof(float));
+  }
+}
+
+template <class Lanes>
+void narrowRow(const float *src, uint16_t *dst, int count, bool complement) {
+  const Complement c(complement);
+  int x = 0;
+  for (; x + 8 <= count; x += 8) {
+    Lanes::store(dst + x, c.apply(_mm256_loadu_ps(src + x)));
+  }
+  if (x < count) {
+    float in[8] = {};
+    uint16_t out[8];
+    memcpy(in, src + x, (count - x) * sizeof(float));
+    Lanes::store(out, c.apply(_mm256_loadu_ps(in)));
+    memcpy(dst + x, out, (count - x) * sizeof(uint16_t));
+  }
+}
+
+} // namespace
+
+void widenFp16Avx2(const uint16_t *src, float *dst, int count, bool complement) {
+  widenRow<Fp16Lanes>(src, dst, count, complement);
+}
+
+void narrowFp16Avx2(const float *src, uint16_t *dst, int count, bool complement) {
+  narrowRow<Fp16Lanes>(src, dst, count, complement);
+}
+
+void widenBf16Avx2(const uint16_t *src, float *dst, int count, bool complement) {
+  widenRow<Bf16Lanes>(src, dst, count, complement);
+}
+
+void narrowBf16Avx2(const float *src, uint16_t *dst, int count, bool complement) {
+  narrowRow<Bf16Lanes>(src, dst, count, complement);
+}
+
+namespace {
+
+struct FixedConstants {
+  __m256i zero, one, diffA, diffB, reaction, feed, feedKill;
+
+  explicit FixedConstants(const FixedArgs &args)
+      : zero(_mm256_setzero_si256()), one(_mm256_set1_epi16(32767)),
+        diffA(_mm256_set1_epi16(args.diffA)), diffB(_mm256_set1_epi16(args.diffB)),
+        reaction(_mm256_set1_epi16(args.reaction)), feed(_mm256_set1_epi16(args.feed)),
+        feedKill(_mm256_set1_epi16(args.feedKill)) {}
+};
+
+inline __m256i load16(const int16_t *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+// Diffusion term c * laplacian, as the sum of c * (neighbour - centre).
+inline __m256i diffusion(__m256i c, __m256i mid, const int16_t *up, const int16_t *centre,
+                         const int16_t *down) {
+  __m256i sum = _mm256_adds_epi16(_mm256_mulhrs_epi16(_mm256_sub_epi16(load16(up), mid), c),
+                                  _mm256_mulhrs_epi16(_mm256_sub_epi16(load16(down), mid), c));
+  sum = _mm256_adds_epi16(sum,
+                          _mm256_mulhrs_epi16(_mm256_sub_epi16(load16(centre - 1), mid), c));
+  return _mm256_adds_epi16(sum,
+                           _mm256_mulhrs_epi16(_mm256_sub_epi16(load16(centre + 1), mid), c));
+}
+
+// Same operations in the same order as stepFixedRowScalar.
+inline void stepFixedCells16(const FixedConstants &k, const FixedPlaneRow &row, int x) {
+  __m256i a = load16(row.aMid + x);
+  __m256i b = load16(row.bMid + x);
+  __m256i lapA = diffusion(k.diffA, a, row.aUp + x, row.aMid + x, row.aDown + x);
+  __m256i lapB = diffusion(k.diffB, b, row.bUp + x, row.bMid + x, row.bDown + x);
+  __m256i reaction = _mm256_mulhrs_epi16(
+      _mm256_mulhrs_epi16(a, _mm256_mulhrs_epi16(b, b)), k.reaction);
+  __m256i deltaA = _mm256_subs_epi16(
+      _mm256_adds_epi16(lapA, _mm256_mulhrs_epi16(_mm256_sub_epi16(k.one, a), k.feed)),
+      reaction);
+  __m256i deltaB = _mm256_subs_epi16(_mm256_adds_epi16(lapB, reaction),
+                                     _mm256_mulhrs_epi16(b, k.feedKill));
+  __m256i aNew = _mm256_max_epi16(_mm256_adds_epi16(a, deltaA), k.zero);
+  __m256i bNew = _mm256_max_epi16(_mm256_adds_epi16(b, deltaB), k.zero);
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(row.aOut + x), aNew);
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(row.bOut + x), bNew);
+}
+
+} // namespace
+
+void stepFixedRowAvx2(const FixedPlaneRow &row, int count, const FixedArgs &args) {
+  const FixedConstants k(args);
+  int x = 0;
+  for (; x + 16 <= count; x += 16) {
+    stepFixedCells16(k, row, x);
+  }
+  if (x < count) {
+    // Zero-padded copies of the last few cells go through the vector code.
+    const int n = count - x;
+    int16_t aUp[16] = {}, aMid[18] = {}, aDown[16] = {}, aOut[16];
+    int16_t bUp[16] = {}, bMid[18] = {}, bDown[16] = {}, bOut[16];
+    memcpy(aUp, row.aUp + x, n * sizeof(int16_t));
+    memcpy(aDown, row.aDown + x, n * sizeof(int16_t));
+    memcpy(aMid, row.aMid + x - 1, (n + 2) * sizeof(int16_t));
+    memcpy(bUp, row.bUp + x, n * sizeof(int16_t));
+    memcpy(bDown, row.bDown + x, n * sizeof(int16_t));
+    memcpy(bMid, row.bMid + x - 1, (n + 2) * sizeof(int16_t));
+    FixedPlaneRow tail = {aUp, aMid + 1, aDown, bUp, bMid + 1, bDown, aOut, bOut};
+    stepFixedCells16(k, tail, 0);
+    memcpy(row.aOut + x, aOut, n * sizeof(int16_t));
+    memcpy(row.bOut + x, bOut, n * sizeof(int16_t));
+  }
+}
+
+void stepBatchRowAvx2(const PlaneRow &row, int count, const BatchArgs &args) {
+  const Constants k(args);
+  for (int i = 0; i < count * 8; i += 8) {
+    __m256 aNew, bNew;
+    update(k, _mm256_loadu_ps(row.aMid + i), _mm256_loadu_ps(row.bMid + i),
+           _mm256_add_ps(_mm256_loadu_ps(row.aUp + i), _mm256_loadu_ps(row.aDown + i)),
+           _mm256_add_ps(_mm256_loadu_ps(row.aMid + i - 8), _mm256_loadu_ps(row.aMid + i + 8)),
+           _mm256_add_ps(_mm256_loadu_ps(row.bUp + i), _mm256_loadu_ps(row.bDown + i)),
+           _mm256_add_ps(_mm256_loadu_ps(row.bMid + i - 8), _mm256_loadu_ps(row.bMid + i + 8)),
+           aNew, bNew);
+    _mm256_storeu_ps(row.aOut + i, aNew);
+    _mm256_storeu_ps(row.bOut + i, bNew);
+  }
+}
+
+namespace {
+
+// Vector types of the generic model kernel: 8 cells, and one cell with the
+// same fused multiply-adds for the remainder of a row.
+struct Vec8 {
+  static constexpr int width = 8;
+  __m256 v;
+
+  Vec8() = default;
+  Vec8(__m256 x) : v(x) {}
+  Vec8(float x) : v(_mm256_set1_ps(x)) {}
+  static Vec8 load(const float *p) { return _mm256_loadu_ps(p); }
+  void store(float *p) const { _mm256_storeu_ps(p, v); }
+};
+
+inline Vec8 operator+(Vec8 a, Vec8 b) { return _mm256_add_ps(a.v, b.v); }
+inline Vec8 operator-(Vec8 a, Vec8 b) { return _mm256_sub_ps(a.v, b.v); }
+inline Vec8 operator*(Vec8 a, Vec8 b) { return _mm256_mul_ps(a.v, b.v); }
+inline Vec8 madd(Vec8 a, Vec8 b, Vec8 c) { return _mm256_fmadd_ps(a.v, b.v, c.v); }
+inline Vec8 vmin(Vec8 a, Vec8 b) { return _mm256_min_ps(a.v, b.v); }
+inline Vec8 vmax(Vec8 a, Vec8 b) { return _mm256_max_ps(a.v, b.v); }
+
+struct Cell {
+  static constexpr int width = 1;
+  float v;
+
+  Cell() = default;
+  Cell(float x) : v(x) {}
+  static Cell load(const float *p) { return *p; }
+  void store(float *p) const { *p = v; }
+};
+
+inline Cell operator+(Cell a, Cell b) { return a.v + b.v; }
+inline Cell operator-(Cell a, Cell b) { return a.v - b.v; }
+inline Cell operator*(Cell a, Cell b) { return a.v * b.v; }
+inline Cell madd(Cell a, Cell b, Cell c) { return fmaf(a.v, b.v, c.v); }
+inline Cell vmin(Cell a, Cell b) { return b.v < a.v ? b.v : a.v; }
+inline Cell vmax(Cell a, Cell b) { return b.v > a.v ? b.v : a.v; }
+
+template <class Model>
+void stepModelRowAvx2(const ModelRow &row, int count, const ModelArgs &args) {
+  int x = stepModelCells<Model, Vec8>(row, 0, count, args);
+  stepModelCells<Model, Cell>(row, x, count, args);
+}
+
+} // namespace
+
+ModelKernel modelKernelAvx2(ReactionModel model) {
+  switch (model) {
+  case ReactionModel::GrayScott:
+    return stepModelRowAvx2<GrayScottModel>;
+  case ReactionModel::Brusselator:
+    return stepModelRowAvx2<BrusselatorModel>;
+  case ReactionModel::Schnakenberg:
+    return stepModelRowAvx2<SchnakenbergModel>;
+  case ReactionModel::FitzHughNagumo:
+    return stepModelRowAvx2<FitzHughNagumoModel>;
+  default:
+    return stepModelRowAvx2<MayLeonardModel>;
+  }
+}
+
+namespace {
+
+template <class S>
+void stepStencilRowAvx2(const StencilRow &row, int count, const SimArgs &args) {
+  int x = stepStencilCells<S, Vec8>(row, 0, count, args);
+  stepStencilCells<S, Cell>(row, x, count, args);
+}
+
+} // namespace
+
+StencilKernel stencilKernelAvx2(Stencil stencil) {
+  switch (stencil) {
+  case Stencil::NinePoint:
+    return stepStencilRowAvx2<NinePointStencil>;
+  case Stencil::FourthOrder:
+    return stepStencilRowAvx2<FourthOrderStencil>;
+  default:
+    return stepStencilRowAvx2<FivePointStencil>;
+  }
+}
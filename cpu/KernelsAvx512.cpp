@@ -0,0 +1,425 @@
+// AVX-512F row kernels, 16 cells per iteration. Built with -mavx512f -mfma and
+// only called after detectIsa() confirms support. Remainders go to the AVX2
+// kernels, which round identically.
+
+#include <immintrin.h>
+#include "Kernels.hpp"
+#include "ModelKernels.hpp"
+#include "StencilKernels.hpp"
+
+namespace {
+
+struct Constants {
+  __m512 zero, one, four, diffA, diffB, feed, feedKill, dt;
+
+  explicit Constants(const SimArgs &args)
+      : zero(_mm512_setzero_ps()), one(_mm512_set1_ps(1.0f)), four(_mm512_set1_ps(4.0f)),
+        diffA(_mm512_set1_ps(args.diffA)), diffB(_mm512_set1_ps(args.diffB)),
+        feed(_mm512_set1_ps(args.feed)), feedKill(_mm512_set1_ps(args.feed + args.kill)),
+        dt(_mm512_set1_ps(args.timeStep)) {}
+
+  // Per-lane parameters of a sweep batch, one configuration per lane.
+  explicit Constants(const BatchArgs &args)
+      : zero(_mm512_setzero_ps()), one(_mm512_set1_ps(1.0f)), four(_mm512_set1_ps(4.0f)),
+        diffA(perLane(args, &SimArgs::diffA)), diffB(perLane(args, &SimArgs::diffB)),
+        feed(perLane(args, &SimArgs::feed)),
+        feedKill(_mm512_add_ps(feed, perLane(args, &SimArgs::kill))),
+        dt(perLane(args, &SimArgs::timeStep)) {}
+
+  static __m512 perLane(const BatchArgs &args, float SimArgs::*field) {
+    float values[16];
+    for (int l = 0; l < 16; l++) {
+      values[l] = args.lane[l].*field;
+    }
+    return _mm512_loadu_ps(values);
+  }
+};
+
+// Same operation order as react() and update() in KernelsAvx2.cpp.
+inline void react(const Constants &k, __m512 a, __m512 b, __m512 lapA, __m512 lapB,
+                  __m512 &aNew, __m512 &bNew) {
+  __m512 reaction = _mm512_mul_ps(a, _mm512_mul_ps(b, b));
+  __m512 deltaA = _mm512_fmadd_ps(
+      k.diffA, lapA, _mm512_fmsub_ps(k.feed, _mm512_sub_ps(k.one, a), reaction));
+  __m512 deltaB = _mm512_fmadd_ps(k.diffB, lapB, _mm512_fnmadd_ps(k.feedKill, b, reaction));
+  aNew = _mm512_min_ps(_mm512_max_ps(_mm512_fmadd_ps(k.dt, deltaA, a), k.zero), k.one);
+  bNew = _mm512_min_ps(_mm512_max_ps(_mm512_fmadd_ps(k.dt, deltaB, b), k.zero), k.one);
+}
+
+inline void update(const Constants &k, __m512 a, __m512 b, __m512 vertA, __m512 horzA,
+                   __m512 vertB, __m512 horzB, __m512 &aNew, __m512 &bNew) {
+  react(k, a, b, _mm512_fnmadd_ps(k.four, a, _mm512_add_ps(vertA, horzA)),
+        _mm512_fnmadd_ps(k.four, b, _mm512_add_ps(vertB, horzB)), aNew, bNew);
+}
+
+// update() without the step and the clamp, like rate() in KernelsAvx2.cpp.
+inline void rate(const Constants &k, __m512 a, __m512 b, __m512 vertA, __m512 horzA,
+                 __m512 vertB, __m512 horzB, __m512 &rateA, __m512 &rateB) {
+  __m512 lapA = _mm512_fnmadd_ps(k.four, a, _mm512_add_ps(vertA, horzA));
+  __m512 lapB = _mm512_fnmadd_ps(k.four, b, _mm512_add_ps(vertB, horzB));
+  __m512 reaction = _mm512_mul_ps(a, _mm512_mul_ps(b, b));
+  rateA = _mm512_fmadd_ps(k.diffA, lapA,
+                          _mm512_fmsub_ps(k.feed, _mm512_sub_ps(k.one, a), reaction));
+  rateB = _mm512_fmadd_ps(k.diffB, lapB, _mm512_fnmadd_ps(k.feedKill, b, reaction));
+}
+
+// Lane shuffles between 16 interleaved cells and separate A/B registers.
+// Built per call rather than as globals: a static initialiser in this file
+// would execute AVX-512 code at startup on CPUs without it.
+struct Shuffles {
+  __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+  __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+  __m512i lo = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+  __m512i hi = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+};
+
+inline void deinterleave(const Shuffles &s, const float *p, __m512 &a, __m512 &b) {
+  __m512 lo = _mm512_loadu_ps(p);
+  __m512 hi = _mm512_loadu_ps(p + 16);
+  a = _mm512_permutex2var_ps(lo, s.even, hi);
+  b = _mm512_permutex2var_ps(lo, s.odd, hi);
+}
+
+inline void interleave(const Shuffles &s, float *p, __m512 a, __m512 b) {
+  _mm512_storeu_ps(p, _mm512_permutex2var_ps(a, s.lo, b));
+  _mm512_storeu_ps(p + 16, _mm512_permutex2var_ps(a, s.hi, b));
+}
+
+} // namespace
+
+void stepRowAvx512(const float *up, const float *mid, const float *down, float *out,
+                   int count, const SimArgs &args) {
+  const Constants k(args);
+  const Shuffles s;
+  int x = 0;
+  for (; x + 16 <= count; x += 16) {
+    int i = 2 * x;
+    __m512 a, b, upA, upB, downA, downB, leftA, leftB, rightA, rightB, aNew, bNew;
+    deinterleave(s, mid + i, a, b);
+    deinterleave(s, up + i, upA, upB);
+    deinterleave(s, down + i, downA, downB);
+    deinterleave(s, mid + i - 2, leftA, leftB);
+    deinterleave(s, mid + i + 2, rightA, rightB);
+    update(k, a, b, _mm512_add_ps(upA, downA), _mm512_add_ps(leftA, rightA),
+           _mm512_add_ps(upB, downB), _mm512_add_ps(leftB, rightB), aNew, bNew);
+    interleave(s, out + i, aNew, bNew);
+  }
+  if (x < count) {
+    stepRowAvx2(up + 2 * x, mid + 2 * x, down + 2 * x, out + 2 * x, count - x, args);
+  }
+}
+
+void stepPlaneRowAvx512(const PlaneRow &row, int count, const SimArgs &args) {
+  const Constants k(args);
+  int x = 0;
+  for (; x + 16 <= count; x += 16) {
+    __m512 aNew, bNew;
+    update(k, _mm512_loadu_ps(row.aMid + x), _mm512_loadu_ps(row.bMid + x),
+           _mm512_add_ps(_mm512_loadu_ps(row.aUp + x), _mm512_loadu_ps(row.aDown + x)),
+           _mm512_add_ps(_mm512_loadu_ps(row.aMid + x - 1), _mm512_loadu_ps(row.aMid + x + 1)),
+           _mm512_add_ps(_mm512_loadu_ps(row.bUp + x), _mm512_loadu_ps(row.bDown + x)),
+           _mm512_add_ps(_mm512_loadu_ps(row.bMid + x - 1), _mm512_loadu_ps(row.bMid + x + 1)),
+           aNew, bNew);
+    _mm512_storeu_ps(row.aOut + x, aNew);
+    _mm512_storeu_ps(row.bOut + x, bNew);
+  }
+  if (x < count) {
+    // Not PlaneRow::at(): header inline functions must not be emitted with
+    // AVX-512 code generation.
+    PlaneRow rest = {row.aUp + x, row.aMid + x, row.aDown + x, row.bUp + x,
+                     row.bMid + x, row.bDown + x, row.aOut + x, row.bOut + x};
+    stepPlaneRowAvx2(rest, count - x, args);
+  }
+}
+
+void ratePlaneRowAvx512(const PlaneRow &row, int count, const SimArgs &args) {
+  const Constants k(args);
+  int x = 0;
+  for (; x + 16 <= count; x += 16) {
+    __m512 rateA, rateB;
+    rate(k, _mm512_loadu_ps(row.aMid + x), _mm512_loadu_ps(row.bMid + x),
+         _mm512_add_ps(_mm512_loadu_ps(row.aUp + x), _mm512_loadu_ps(row.aDown + x)),
+         _mm512_add_ps(_mm512_loadu_ps(row.aMid + x - 1), _mm512_loadu_ps(row.aMid + x + 1)),
+         _mm512_add_ps(_mm512_loadu_ps(row.bUp + x), _mm512_loadu_ps(row.bDown + x)),
+         _mm512_add_ps(_mm512_loadu_ps(row.bMid + x - 1), _mm512_loadu_ps(row.bMid + x + 1)),
+         rateA, rateB);
+    _mm512_storeu_ps(row.aOut + x, rateA);
+    _mm512_storeu_ps(row.bOut + x, rateB);
+  }
+  if (x < count) {
+    PlaneRow rest = {row.aUp + x, row.aMid + x, row.aDown + x, row.bUp + x,
+                     row.bMid + x, row.bDown + x, row.aOut + x, row.bOut + x};
+    ratePlaneRowAvx2(rest, count - x, args);
+  }
+}
+
+namespace {
+
+// stepPlaneRowAvx512 with feed and/or kill loaded per cell, as in
+// KernelsAvx2.cpp.
+template <bool FeedField, bool KillField>
+void stepFieldCells(const PlaneRow &row, const FieldRow &field, int count, const SimArgs &args) {
+  Constants k(args);
+  const __m512 kill = _mm512_set1_ps(args.kill);
+  int x = 0;
+  for (; x + 16 <= count; x += 16) {
+    if (FeedField) {
+      k.feed = _mm512_loadu_ps(field.feed + x);
+    }
+    k.feedKill = _mm512_add_ps(k.feed, KillField ? _mm512_loadu_ps(field.kill + x) : kill);
+    __m512 aNew, bNew;
+    update(k, _mm512_loadu_ps(row.aMid + x), _mm512_loadu_ps(row.bMid + x),
+           _mm512_add_ps(_mm512_loadu_ps(row.aUp + x), _mm512_loadu_ps(row.aDown + x)),
+           _mm512_add_ps(_mm512_loadu_ps(row.aMid + x - 1), _mm512_loadu_ps(row.aMid + x + 1)),
+           _mm512_add_ps(_mm512_loadu_ps(row.bUp + x), _mm512_loadu_ps(row.bDown + x)),
+           _mm512_add_ps(_mm512_loadu_ps(row.bMid + x - 1), _mm512_loadu_ps(row.bMid + x + 1)),
+           aNew, bNew);
+    _mm512_storeu_ps(row.aOut + x, aNew);
+    _mm512_storeu_ps(row.bOut + x, bNew);
+  }
+  if (x < count) {
+    PlaneRow rest = {row.aUp + x, row.aMid + x, row.aDown + x, row.bUp + x,
+                     row.bMid + x, row.bDown + x, row.aOut + x, row.bOut + x};
+    FieldRow restField = {FeedField ? field.feed + x : nullptr,
+                          KillField ? field.kill + x : nullptr};
+    stepFieldRowAvx2(rest, restField, count - x, args);
+  }
+}
+
+} // namespace
+
+void stepFieldRowAvx512(const PlaneRow &row, const FieldRow &field, int count,
+                        const SimArgs &args) {
+  if (field.feed && field.kill) {
+    stepFieldCells<true, true>(row, field, count, args);
+  } else if (field.feed) {
+    stepFieldCells<true, false>(row, field, count, args);
+  } else if (field.kill) {
+    stepFieldCells<false, true>(row, field, count, args);
+  } else {
+    stepPlaneRowAvx512(row, count, args);
+  }
+}
+
+void stepVolumeRowAvx512(const VolumeRow &row, int count, const SimArgs &args) {
+  const Constants k(args);
+  const __m512 six = _mm512_set1_ps(6.0f);
+  const PlaneRow &p = row.plane;
+  int x = 0;
+  for (; x + 16 <= count; x += 16) {
+    __m512 a = _mm512_loadu_ps(p.aMid + x);
+    __m512 b = _mm512_loadu_ps(p.bMid + x);
+    __m512 sumA = _mm512_add_ps(
+        _mm512_add_ps(_mm512_add_ps(_mm512_loadu_ps(p.aUp + x), _mm512_loadu_ps(p.aDown + x)),
+                      _mm512_add_ps(_mm512_loadu_ps(row.aFront + x),
+                                    _mm512_loadu_ps(row.aBack + x))),
+        _mm512_add_ps(_mm512_loadu_ps(p.aMid + x - 1), _mm512_loadu_ps(p.aMid + x + 1)));
+    __m512 sumB = _mm512_add_ps(
+        _mm512_add_ps(_mm512_add_ps(_mm512_loadu_ps(p.bUp + x), _mm512_loadu_ps(p.bDown + x)),
+                      _mm512_add_ps(_mm512_loadu_ps(row.bFront + x),
+                                    _mm512_loadu_ps(row.bBack + x))),
+        _mm512_add_ps(_mm512_loadu_ps(p.bMid + x - 1), _mm512_loadu_ps(p.bMid + x + 1)));
+    __m512 aNew, bNew;
+    react(k, a, b, _mm512_fnmadd_ps(six, a, sumA), _mm512_fnmadd_ps(six, b, sumB), aNew, bNew);
+    _mm512_storeu_ps(p.aOut + x, aNew);
+    _mm512_storeu_ps(p.bOut + x, bNew);
+  }
+  if (x < count) {
+    VolumeRow rest = {{p.aUp + x, p.aMid + x, p.aDown + x, p.bUp + x, p.bMid + x, p.bDown + x,
+                       p.aOut + x, p.bOut + x},
+                      row.aFront + x,
+                      row.aBack + x,
+                      row.bFront + x,
+                      row.bBack + x};
+    stepVolumeRowAvx2(rest, count - x, args);
+  }
+}
+
+void stepHexRowAvx512(const PlaneRow &row, int count, const SimArgs &args) {
+  const Constants k(args);
+  const __m512 six = _mm512_set1_ps(6.0f);
+  int x = 0;
+  for (; x + 16 <= count; x += 16) {
+    __m512 a = _mm512_loadu_ps(row.aMid + x);
+    __m512 b = _mm512_loadu_ps(row.bMid + x);
+    __m512 sumA = _mm512_add_ps(
+        _mm512_add_ps(_mm512_loadu_ps(row.aMid + x - 1), _mm512_loadu_ps(row.aMid + x + 1)),
+        _mm512_add_ps(_mm512_loadu_ps(row.aUp + x), _mm512_loadu_ps(row.aUp + x + 1)));
+    sumA = _mm512_add_ps(
+        sumA, _mm512_add_ps(_mm512_loadu_ps(row.aDown + x), _mm512_loadu_ps(row.aDown + x + 1)));
+    __m512 sumB = _mm512_add_ps(
+        _mm512_add_ps(_mm512_loadu_ps(row.bMid + x - 1), _mm512_loadu_ps(row.bMid + x + 1)),
+        _mm512_add_ps(_mm512_loadu_ps(row.bUp + x), _mm512_loadu_ps(row.bUp + x + 1)));
+    sumB = _mm512_add_ps(
+        sumB, _mm512_add_ps(_mm512_loadu_ps(row.bDown + x), _mm512_loadu_ps(row.bDown + x + 1)));
+    __m512 aNew, bNew;
+    react(k, a, b, _mm512_fnmadd_ps(six, a, sumA), _mm512_fnmadd_ps(six, b, sumB), aNew, bNew);
+    _mm512_storeu_ps(row.aOut + x, aNew);
+    _mm512_storeu_ps(row.bOut + x, bNew);
+  }
+  if (x < count) {
+    PlaneRow rest = {row.aUp + x, row.aMid + x, row.aDown + x, row.bUp + x,
+                     row.bMid + x, row.bDown + x, row.aOut + x, row.bOut + x};
+    stepHexRowAvx2(rest, count - x, args);
+  }
+}
+
+void stepMeshRowsAvx512(const MeshRows &rows, int first, int count, const SimArgs &args) {
+  const Constants k(args);
+  const __m512i step = _mm512_set1_epi32(1);
+  const int end = first + count;
+  int v = first;
+  for (; v + 16 <= end; v += 16) {
+    __m512i index = _mm512_loadu_si512(rows.start + v);
+    const __m512i stop = _mm512_loadu_si512(rows.start + v + 1);
+    const int longest = _mm512_reduce_max_epi32(_mm512_sub_epi32(stop, index));
+    const __m512 a = _mm512_loadu_ps(rows.a + v);
+    const __m512 b = _mm512_loadu_ps(rows.b + v);
+    __m512 lapA = k.zero;
+    __m512 lapB = k.zero;
+    // Same masking as stepMeshRowsAvx2.
+    for (int i = 0; i < longest; i++) {
+      const __mmask16 live = _mm512_cmpgt_epi32_mask(stop, index);
+      const __m512i u =
+          _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), live, index, rows.column, 4);
+      const __m512 w = _mm512_mask_i32gather_ps(k.zero, live, index, rows.weight, 4);
+      const __m512 au = _mm512_mask_i32gather_ps(a, live, u, rows.a, 4);
+      const __m512 bu = _mm512_mask_i32gather_ps(b, live, u, rows.b, 4);
+      lapA = _mm512_fmadd_ps(w, _mm512_sub_ps(au, a), lapA);
+      lapB = _mm512_fmadd_ps(w, _mm512_sub_ps(bu, b), lapB);
+      index = _mm512_add_epi32(index, step);
+    }
+    __m512 aNew, bNew;
+    react(k, a, b, lapA, lapB, aNew, bNew);
+    _mm512_storeu_ps(rows.aOut + v, aNew);
+    _mm512_storeu_ps(rows.bOut + v, bNew);
+  }
+  if (v < end) {
+    stepMeshRowsAvx2(rows, v, end - v, args);
+  }
+}
+
+void combineRowAvx512(float *dst, const float *const *src, const float *weight, int terms,
+                      int count) {
+  const int vectorEnd = count - count % 16;
+  // Masked loads and stores cover the last partial vector.
+  const __mmask16 tail = __mmask16((1u << (count % 16)) - 1);
+  for (int i = 0; i < terms; i++) {
+    const __m512 w = _mm512_set1_ps(weight[i]);
+    const float *in = src[i];
+    if (i == 0) {
+      for (int x = 0; x < vectorEnd; x += 16) {
+        _mm512_storeu_ps(dst + x, _mm512_mul_ps(w, _mm512_loadu_ps(in + x)));
+      }
+      _mm512_mask_storeu_ps(dst + vectorEnd, tail,
+                            _mm512_mul_ps(w, _mm512_maskz_loadu_ps(tail, in + vectorEnd)));
+    } else {
+      for (int x = 0; x < vectorEnd; x += 16) {
+        _mm512_storeu_ps(dst + x,
+                         _mm512_fmadd_ps(w, _mm512_loadu_ps(in + x), _mm512_loadu_ps(dst + x)));
+      }
+      _mm512_mask_storeu_ps(dst + vectorEnd, tail,
+                            _mm512_fmadd_ps(w, _mm512_maskz_loadu_ps(tail, in + vectorEnd),
+                                            _mm512_maskz_loadu_ps(tail, dst + vectorEnd)));
+    }
+  }
+}
+
+void stepBatchRowAvx512(const PlaneRow &row, int count, const BatchArgs &args) {
+  const Constants k(args);
+  for (int i = 0; i < count * 16; i += 16) {
+    __m512 aNew, bNew;
+    update(k, _mm512_loadu_ps(row.aMid + i), _mm512_loadu_ps(row.bMid + i),
+           _mm512_add_ps(_mm512_loadu_ps(row.aUp + i), _mm512_loadu_ps(row.aDown + i)),
+           _mm512_add_ps(_mm512_loadu_ps(row.aMid + i - 16), _mm512_loadu_ps(row.aMid + i + 16)),
+           _mm512_add_ps(_mm512_loadu_ps(row.bUp + i), _mm512_loadu_ps(row.bDown + i)),
+           _mm512_add_ps(_mm512_loadu_ps(row.bMid + i - 16), _mm512_loadu_ps(row.bMid + i + 16)),
+           aNew, bNew);
+    _mm512_storeu_ps(row.aOut + i, aNew);
+    _mm512_storeu_ps(row.bOut + i, bNew);
+  }
+}
+
+namespace {
+
+// Vector type of the generic model kernel. The remainder goes to the AVX2
+// instantiation of the same model.
+struct Vec16 {
+  static constexpr int width = 16;
+  __m512 v;
+
+  Vec16() = default;
+  Vec16(__m512 x) : v(x) {}
+  Vec16(float x) : v(_mm512_set1_ps(x)) {}
+  static Vec16 load(const float *p) { return _mm512_loadu_ps(p); }
+  void store(float *p) const { _mm512_storeu_ps(p, v); }
+};
+
+inline Vec16 operator+(Vec16 a, Vec16 b) { return _mm512_add_ps(a.v, b.v); }
+inline Vec16 operator-(Vec16 a, Vec16 b) { return _mm512_sub_ps(a.v, b.v); }
+inline Vec16 operator*(Vec16 a, Vec16 b) { return _mm512_mul_ps(a.v, b.v); }
+inline Vec16 madd(Vec16 a, Vec16 b, Vec16 c) { return _mm512_fmadd_ps(a.v, b.v, c.v); }
+inline Vec16 vmin(Vec16 a, Vec16 b) { return _mm512_min_ps(a.v, b.v); }
+inline Vec16 vmax(Vec16 a, Vec16 b) { return _mm512_max_ps(a.v, b.v); }
+
+template <class Model, ReactionModel id>
+void stepModelRowAvx512(const ModelRow &row, int count, const ModelArgs &args) {
+  const int x = stepModelCells<Model, Vec16>(row, 0, count, args);
+  if (x < count) {
+    ModelRow rest;
+    for (int s = 0; s < Model::species; s++) {
+      rest.up[s] = row.up[s] + x;
+      rest.mid[s] = row.mid[s] + x;
+      rest.down[s] = row.down[s] + x;
+      rest.out[s] = row.out[s] + x;
+    }
+    modelKernelAvx2(id)(rest, count - x, args);
+  }
+}
+
+} // namespace
+
+ModelKernel modelKernelAvx512(ReactionModel model) {
+  switch (model) {
+  case ReactionModel::GrayScott:
+    return stepModelRowAvx512<GrayScottModel, ReactionModel::GrayScott>;
+  case ReactionModel::Brusselator:
+    return stepModelRowAvx512<BrusselatorModel, ReactionModel::Brusselator>;
+  case ReactionModel::Schnakenberg:
+    return stepModelRowAvx512<SchnakenbergModel, ReactionModel::Schnakenberg>;
+  case ReactionModel::FitzHughNagumo:
+    return stepModelRowAvx512<FitzHughNagumoModel, ReactionModel::FitzHughNagumo>;
+  default:
+    return stepModelRowAvx512<MayLeonardModel, ReactionModel::MayLeonard>;
+  }
+}
+
+namespace {
+
+template <class S, Stencil id>
+void stepStencilRowAvx512(const StencilRow &row, int count, const SimArgs &args) {
+  const int x = stepStencilCells<S, Vec16>(row, 0, count, args);
+  if (x < count) {
+    StencilRow rest = row;
+    for (int i = 0; i < 2 * kMaxStencilRadius + 1; i++) {
+      rest.a[i] = row.a[i] ? row.a[i] + x : nullptr;
+      rest.b[i] = row.b[i] ? row.b[i] + x : nullptr;
+    }
+    rest.aOut = row.aOut + x;
+    rest.bOut = row.bOut + x;
+    stencilKernelAvx2(id)(rest, count - x, args);
+  }
+}
+
+} // namespace
+
+StencilKernel stencilKernelAvx512(Stencil stencil) {
+  switch (stencil) {
+  case Stencil::NinePoint:
+    return stepStencilRowAvx512<NinePointStencil, Stencil::NinePoint>;
+  case Stencil::FourthOrder:
+    return stepStencilRowAvx512<FourthOrderStencil, Stencil::FourthOrder>;
+  default:
+    return stepStencilRowAvx512<FivePointStencil, Stencil::FivePoint>;
+  }
+}
@@ -0,0 +1,713 @@
+#include "Mesh.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+bool endsWith(std::string text, const std::string &suffix) {
+  std::transform(text.begin(), text.end(), text.begin(),
+                 [](unsigned char c) { return static_cast<char>(tolower(c)); });
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Appends polygon `corners` as a fan of triangles, dropping degenerate ones.
+void addPolygon(Mesh &mesh, const std::vector<int> &corners, const std::string &source) {
+  const int n = mesh.vertexCount();
+  for (int corner : corners) {
+    if (corner < 0 || corner >= n) {
+      throw std::runtime_error(source + ": face references vertex " + std::to_string(corner) +
+                               " of " + std::to_string(n));
+    }
+  }
+  for (size_t i = 2; i < corners.size(); i++) {
+    const int a = corners[0], b = corners[i - 1], c = corners[i];
+    if (a != b && b != c && a != c) {
+      mesh.triangles.insert(mesh.triangles.end(), {a, b, c});
+    }
+  }
+}
+
+// --- OBJ ---
+
+// "v x y z" and "f a b c ..." lines; face corners may carry /texture/normal
+// indices, and negative indices count back from the last vertex.
+Mesh loadObj(const std::string &path) {
+  std::ifstream f(path);
+  if (!f) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+  Mesh mesh;
+  std::string line;
+  std::vector<int> corners;
+  for (int number = 1; std::getline(f, line); number++) {
+    const char *p = line.c_str();
+    while (*p == ' ' || *p == '\t') {
+      p++;
+    }
+    if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+      char *end = const_cast<char *>(p + 1);
+      for (int i = 0; i < 3; i++) {
+        const char *begin = end;
+        mesh.positions.push_back(strtof(begin, &end));
+        if (end == begin) {
+          throw std::runtime_error(path + ":" + std::to_string(number) + ": bad vertex");
+        }
+      }
+    } else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+      corners.clear();
+      char *end = const_cast<char *>(p + 1);
+      while (true) {
+        const char *begin = end;
+        long index = strtol(begin, &end, 10);
+        if (end == begin) {
+          break;
+        }
+        const long corner = index < 0 ? mesh.vertexCount() + index : index - 1;
+        if (corner < 0 || corner >= mesh.vertexCount()) {
+          // The index as written: 1-based, or negative counting back.
+          throw std::runtime_error(path + ":" + std::to_string(number) +
+                                   ": face references vertex " + std::to_string(index) + " of " +
+                                   std::to_string(mesh.vertexCount()));
+        }
+        corners.push_back(static_cast<int>(corner));
+        while (*end && *end != ' ' && *end != '\t' && *end != '\r') {
+          end++; // texture and normal indices
+        }
+      }
+      if (corners.size() < 3) {
+        throw std::runtime_error(path + ":" + std::to_string(number) + ": bad face");
+      }
+      addPolygon(mesh, corners, path);
+    }
+  }
+  return mesh;
+}
+
+// --- PLY ---
+
+enum class PlyType { Int8, Uint8, Int16, Uint16, Int32, Uint32, Float32, Float64 };
+
+PlyType plyType(const std::string &name, const std::string &path) {
+  static const std::pair<const char *, PlyType> kNames[] = {
+      {"char", PlyType::Int8},     {"int8", PlyType::Int8},       {"uchar", PlyType::Uint8},
+      {"uint8", PlyType::Uint8},   {"short", PlyType::Int16},     {"int16", PlyType::Int16},
+      {"ushort", PlyType::Uint16}, {"uint16", PlyType::Uint16},   {"int", PlyType::Int32},
+      {"int32", PlyType::Int32},   {"uint", PlyType::Uint32},     {"uint32", PlyType::Uint32},
+      {"float", PlyType::Float32}, {"float32", PlyType::Float32}, {"double", PlyType::Float64},
+      {"float64", PlyType::Float64}};
+  for (const auto &[text, type] : kNames) {
+    if (name == text) {
+      return type;
+    }
+  }
+  throw std::runtime_error(path + ": unknown PLY type " + name);
+}
+
+size_t plySize(PlyType type) {
+  switch (type) {
+  case PlyType::Int8:
+  case PlyType::Uint8:
+    return 1;
+  case PlyType::Int16:
+  case PlyType::Uint16:
+    return 2;
+  case PlyType::Float64:
+    return 8;
+  default:
+    return 4;
+  }
+}
+
+struct PlyProperty {
+  std::string name;
+  PlyType type;
+  bool list = false;
+  PlyType countType = PlyType::Uint8;
+};
+
+struct PlyElement {
+  std::string name;
+  size_t count = 0;
+  std::vector<PlyProperty> properties;
+};
+
+// Values of the body, in the file's format.
+class PlyReader {
+public:
+  PlyReader(std::istream &in, bool ascii, bool bigEndian, const std::string &path)
+      : _in(in), _ascii(ascii), _path(path) {
+    const uint16_t probe = 1;
+    uint8_t first;
+    memcpy(&first, &probe, 1);
+    _swap = bigEndian == (first == 1);
+  }
+
+  double next(PlyType type) {
+    if (_ascii) {
+      double value;
+      if (!(_in >> value)) {
+        fail();
+      }
+      return value;
+    }
+    unsigned char bytes[8];
+    const size_t size = plySize(type);
+    if (!_in.read(reinterpret_cast<char *>(bytes), size)) {
+      fail();
+    }
+    if (_swap) {
+      std::reverse(bytes, bytes + size);
+    }
+    switch (type) {
+    case PlyType::Int8:
+      return static_cast<int8_t>(bytes[0]);
+    case PlyType::Uint8:
+      return bytes[0];
+    case PlyType::Int16:
+      return get<int16_t>(bytes);
+    case PlyType::Uint16:
+      return get<uint16_t>(bytes);
+    case PlyType::Int32:
+      return get<int32_t>(bytes);
+    case PlyType::Uint32:
+      return get<uint32_t>(bytes);
+    case PlyType::Float32:
+      return get<float>(bytes);
+    default:
+      return get<double>(bytes);
+    }
+  }
+
+private:
+  std::istream &_in;
+  bool _ascii;
+  bool _swap;
+  const std::string &_path;
+
+  template <class T>
+  static T get(const unsigned char *bytes) {
+    T value;
+    memcpy(&value, bytes, sizeof(T));
+    return value;
+  }
+
+  [[noreturn]] void fail() { throw std::runtime_error(_path + ": PLY data ends early"); }
+};
+
+// Vertex x, y, z and face vertex_indices (or vertex_index); other elements
+// and properties are read past.
+Mesh loadPly(const std::string &path) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+  std::string line;
+  if (!std::getline(f, line) || line.compare(0, 3, "ply") != 0) {
+    throw std::runtime_error(path + ": not a PLY file");
+  }
+  std::string format;
+  std::vector<PlyElement> elements;
+  while (std::getline(f, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    std::istringstream words(line);
+    std::string keyword;
+    words >> keyword;
+    if (keyword == "end_header") {
+      break;
+    } else if (keyword == "format") {
+      words >> format;
+    } else if (keyword == "element") {
+      PlyElement element;
+      words >> element.name >> element.count;
+      elements.push_back(element);
+    } else if (keyword == "property") {
+      if (elements.empty()) {
+        throw std::runtime_error(path + ": PLY property outside an element");
+      }
+      PlyProperty property;
+      std::string type;
+      words >> type;
+      if (type == "list") {
+        std::string countType;
+        words >> countType >> type;
+        property.list = true;
+        property.countType = plyType(countType, path);
+      }
+      property.type = plyType(type, path);
+      words >> property.name;
+      elements.back().properties.push_back(property);
+    }
+  }
+  if (format != "ascii" && format != "binary_little_endian" && format != "binary_big_endian") {
+    throw std::runtime_error(path + ": unknown PLY format " + format);
+  }
+
+  Mesh mesh;
+  PlyReader reader(f, format == "ascii", format == "binary_big_endian", path);
+  std::vector<int> corners;
+  for (const PlyElement &element : elements) {
+    const bool vertices = element.name == "vertex";
+    const bool faces = element.name == "face";
+    int axis[3] = {-1, -1, -1};
+    for (size_t p = 0; p < element.properties.size(); p++) {
+      const std::string &name = element.properties[p].name;
+      if (vertices && name.size() == 1 && name[0] >= 'x' && name[0] <= 'z') {
+        axis[name[0] - 'x'] = static_cast<int>(p);
+      }
+    }
+    if (vertices && (axis[0] < 0 || axis[1] < 0 || axis[2] < 0)) {
+      throw std::runtime_error(path + ": PLY vertices without x, y and z");
+    }
+    for (size_t i = 0; i < element.count; i++) {
+      float position[3] = {0.0f, 0.0f, 0.0f};
+      for (size_t p = 0; p < element.properties.size(); p++) {
+        const PlyProperty &property = element.properties[p];
+        if (!property.list) {
+          const double value = reader.next(property.type);
+          for (int k = 0; k < 3; k++) {
+            if (vertices && axis[k] == static_cast<int>(p)) {
+              position[k] = static_cast<float>(value);
+            }
+          }
+          continue;
+        }
+        const size_t count = static_cast<size_t>(reader.next(property.countType));
+        const bool indices =
+            faces && (property.name == "vertex_indices" || property.name == "vertex_index");
+        corners.clear();
+        for (size_t k = 0; k < count; k++) {
+          const double value = reader.next(property.type);
+          if (indices) {
+            corners.push_back(static_cast<int>(value));
+          }
+        }
+        if (indices) {
+          addPolygon(mesh, corners, path);
+        }
+      }
+      if (vertices) {
+        mesh.positions.insert(mesh.positions.end(), position, position + 3);
+      }
+    }
+    if (vertices && !mesh.triangles.empty()) {
+      throw std::runtime_error(path + ": PLY faces before vertices");
+    }
+  }
+  return mesh;
+}
+
+// --- Generated surfaces ---
+
+// Icosahedron, each face split into four `levels` times, on the unit sphere.
+// Midpoints are numbered through a sorted edge list, so the vertex order is
+// deterministic.
+Mesh icosphere(int levels) {
+  if (levels < 0 || levels > 10) {
+    throw std::runtime_error("Icosphere level must be 0 to 10");
+  }
+  const double t = (1.0 + std::sqrt(5.0)) / 2.0;
+  std::vector<double> points = {-1, t,  0, 1, t,  0, -1, -t, 0, 1, -t, 0,
+                                0,  -1, t, 0, 1,  t, 0,  -1, -t, 0, 1,  -t,
+                                t,  0,  -1, t, 0, 1,  -t, 0,  -1, -t, 0,  1};
+  std::vector<int> faces = {0, 11, 5,  0, 5,  1, 0, 1, 7, 0, 7,  10, 0, 10, 11,
+                            1, 5,  9,  5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+                            3, 9,  4,  3, 4,  2, 3, 2, 6, 3, 6,  8,  3, 8,  9,
+                            4, 9,  5,  2, 4,  11, 6, 2, 10, 8, 6, 7, 9, 8,  1};
+  auto project = [&](size_t v) {
+    double *p = &points[3 * v];
+    const double length = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+    p[0] /= length;
+    p[1] /= length;
+    p[2] /= length;
+  };
+  for (size_t v = 0; v < points.size() / 3; v++) {
+    project(v);
+  }
+  for (int level = 0; level < levels; level++) {
+    // Edge e of face f is slot 3 f + e, from corner e to corner e + 1.
+    std::vector<std::pair<uint64_t, int>> edges(faces.size());
+    for (size_t slot = 0; slot < faces.size(); slot++) {
+      const uint64_t a = faces[slot], b = faces[slot - slot % 3 + (slot + 1) % 3];
+      edges[slot] = {std::min(a, b) << 32 | std::max(a, b), static_cast<int>(slot)};
+    }
+    std::sort(edges.begin(), edges.end());
+    std::vector<int> midpoint(faces.size());
+    for (size_t i = 0; i < edges.size(); i++) {
+      if (i == 0 || edges[i].first != edges[i - 1].first) {
+        const size_t a = edges[i].first >> 32, b = edges[i].first & 0xffffffffu;
+        for (int k = 0; k < 3; k++) {
+          points.push_back((points[3 * a + k] + points[3 * b + k]) / 2.0);
+        }
+        project(points.size() / 3 - 1);
+      }
+      midpoint[edges[i].second] = static_cast<int>(points.size() / 3 - 1);
+    }
+    std::vector<int> split;
+    split.reserve(faces.size() * 4);
+    for (size_t f = 0; f < faces.size(); f += 3) {
+      const int a = faces[f], b = faces[f + 1], c = faces[f + 2];
+      const int ab = midpoint[f], bc = midpoint[f + 1], ca = midpoint[f + 2];
+      split.insert(split.end(), {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
+    }
+    faces.swap(split);
+  }
+  Mesh mesh;
+  mesh.positions.assign(points.begin(), points.end());
+  mesh.triangles = std::move(faces);
+  return mesh;
+}
+
+// Torus with radii chosen so that its edges are about one unit long around
+// both circles; each quad of the parameter grid is split along a diagonal.
+Mesh torus(int ring, int tube) {
+  if (tube < 3 || ring <= tube) {
+    throw std::runtime_error("Torus needs U > V >= 3 vertices");
+  }
+  const double pi = 3.14159265358979323846;
+  const double major = ring / (2.0 * pi), minor = tube / (2.0 * pi);
+  Mesh mesh;
+  mesh.positions.reserve(size_t(ring) * tube * 3);
+  for (int i = 0; i < ring; i++) {
+    const double theta = 2.0 * pi * i / ring;
+    for (int j = 0; j < tube; j++) {
+      const double phi = 2.0 * pi * j / tube;
+      const double r = major + minor * std::cos(phi);
+      mesh.positions.insert(mesh.positions.end(),
+                            {static_cast<float>(r * std::cos(theta)),
+                             static_cast<float>(r * std::sin(theta)),
+                             static_cast<float>(minor * std::sin(phi))});
+    }
+  }
+  mesh.triangles.reserve(size_t(ring) * tube * 6);
+  for (int i = 0; i < ring; i++) {
+    for (int j = 0; j < tube; j++) {
+      const int a = i * tube + j, b = (i + 1) % ring * tube + j;
+      const int c = (i + 1) % ring * tube + (j + 1) % tube, d = i * tube + (j + 1) % tube;
+      mesh.triangles.insert(mesh.triangles.end(), {a, b, c, a, c, d});
+    }
+  }
+  return mesh;
+}
+
+// --- Orderings ---
+
+int degree(const CsrLaplacian &graph, int v) { return graph.start[v + 1] - graph.start[v]; }
+
+// Breadth-first search from `root` over vertices not yet placed. Returns the
+// depth reached and leaves the last level in `last`.
+int lastLevel(const CsrLaplacian &graph, int root, const std::vector<char> &placed,
+              std::vector<int> &mark, int stamp, std::vector<int> &queue, std::vector<int> &last) {
+  queue.assign(1, root);
+  mark[root] = stamp;
+  int depth = 0;
+  size_t levelBegin = 0;
+  while (true) {
+    const size_t levelEnd = queue.size();
+    for (size_t i = levelBegin; i < levelEnd; i++) {
+      const int v = queue[i];
+      for (int k = graph.start[v]; k < graph.start[v + 1]; k++) {
+        const int u = graph.column[k];
+        if (!placed[u] && mark[u] != stamp) {
+          mark[u] = stamp;
+          queue.push_back(u);
+        }
+      }
+    }
+    if (queue.size() == levelEnd) {
+      last.assign(queue.begin() + levelBegin, queue.end());
+      return depth;
+    }
+    levelBegin = levelEnd;
+    depth++;
+  }
+}
+
+// Reverse Cuthill-McKee, one connected component at a time. Each component
+// starts from a pseudo-peripheral vertex (George and Liu): the lowest-degree
+// vertex of the last BFS level, for as long as that makes the BFS deeper.
+std::vector<int> rcmOrder(const CsrLaplacian &graph) {
+  const int n = graph.rows();
+  std::vector<int> order;
+  order.reserve(n);
+  std::vector<char> placed(n, 0);
+  std::vector<int> mark(n, -1), queue, last, neighbours;
+  int stamp = 0;
+  for (int seed = 0; seed < n; seed++) {
+    if (placed[seed]) {
+      continue;
+    }
+    int root = seed;
+    int depth = lastLevel(graph, root, placed, mark, stamp++, queue, last);
+    for (int tries = 0; tries < 8; tries++) {
+      const int candidate = *std::min_element(last.begin(), last.end(), [&](int a, int b) {
+        return degree(graph, a) < degree(graph, b);
+      });
+      std::vector<int> candidateLast;
+      const int candidateDepth =
+          lastLevel(graph, candidate, placed, mark, stamp++, queue, candidateLast);
+      if (candidateDepth <= depth) {
+        break;
+      }
+      root = candidate;
+      depth = candidateDepth;
+      last.swap(candidateLast);
+    }
+    size_t head = order.size();
+    order.push_back(root);
+    placed[root] = 1;
+    while (head < order.size()) {
+      const int v = order[head++];
+      neighbours.clear();
+      for (int k = graph.start[v]; k < graph.start[v + 1]; k++) {
+        const int u = graph.column[k];
+        if (!placed[u]) {
+          placed[u] = 1;
+          neighbours.push_back(u);
+        }
+      }
+      std::sort(neighbours.begin(), neighbours.end(), [&](int a, int b) {
+        const int da = degree(graph, a), db = degree(graph, b);
+        return da != db ? da < db : a < b;
+      });
+      order.insert(order.end(), neighbours.begin(), neighbours.end());
+    }
+  }
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+// 21 bits of each coordinate, interleaved.
+uint64_t spreadBits(uint64_t x) {
+  x &= 0x1fffff;
+  x = (x | x << 32) & 0x1f00000000ffffull;
+  x = (x | x << 16) & 0x1f0000ff0000ffull;
+  x = (x | x << 8) & 0x100f00f00f00f00full;
+  x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+  x = (x | x << 2) & 0x1249249249249249ull;
+  return x;
+}
+
+std::vector<int> mortonOrder(const Mesh &mesh) {
+  const int n = mesh.vertexCount();
+  float low[3] = {INFINITY, INFINITY, INFINITY}, high[3] = {-INFINITY, -INFINITY, -INFINITY};
+  for (int v = 0; v < n; v++) {
+    for (int k = 0; k < 3; k++) {
+      low[k] = std::min(low[k], mesh.positions[3 * v + k]);
+      high[k] = std::max(high[k], mesh.positions[3 * v + k]);
+    }
+  }
+  const float extent = std::max({high[0] - low[0], high[1] - low[1], high[2] - low[2], 1e-30f});
+  std::vector<std::pair<uint64_t, int>> keys(n);
+  for (int v = 0; v < n; v++) {
+    uint64_t code = 0;
+    for (int k = 0; k < 3; k++) {
+      const double unit = (mesh.positions[3 * v + k] - low[k]) / extent;
+      code |= spreadBits(static_cast<uint64_t>(unit * 0x1fffff)) << k;
+    }
+    keys[v] = {code, v};
+  }
+  std::sort(keys.begin(), keys.end());
+  std::vector<int> order(n);
+  for (int i = 0; i < n; i++) {
+    order[i] = keys[i].second;
+  }
+  return order;
+}
+
+} // namespace
+
+Mesh loadMesh(const std::string &source) {
+  Mesh mesh;
+  int ring, tube, levels;
+  if (sscanf(source.c_str(), "sphere:%d", &levels) == 1) {
+    mesh = icosphere(levels);
+  } else if (sscanf(source.c_str(), "torus:%dx%d", &ring, &tube) == 2) {
+    mesh = torus(ring, tube);
+  } else if (endsWith(source, ".obj")) {
+    mesh = loadObj(source);
+  } else if (endsWith(source, ".ply")) {
+    mesh = loadPly(source);
+  } else {
+    throw std::runtime_error("Meshes are .obj or .ply files, sphere:L or torus:UxV, not " +
+                             source);
+  }
+  if (mesh.triangles.empty()) {
+    throw std::runtime_error(source + " has no triangles");
+  }
+  mesh.name = source;
+  return mesh;
+}
+
+CsrLaplacian cotangentLaplacian(const Mesh &mesh) {
+  const int n = mesh.vertexCount();
+  const size_t triangles = mesh.triangleCount();
+  auto point = [&](int v, double p[3]) {
+    for (int k = 0; k < 3; k++) {
+      p[k] = mesh.positions[3 * size_t(v) + k];
+    }
+  };
+  // Half cotangents of each corner go to the two directed entries of the
+  // opposite edge; entries are bucketed by row, then merged per row.
+  std::vector<int> start(n + 1, 0);
+  for (int v : mesh.triangles) {
+    start[v + 1] += 2;
+  }
+  for (int v = 0; v < n; v++) {
+    start[v + 1] += start[v];
+  }
+  std::vector<int> fill(start.begin(), start.end() - 1);
+  std::vector<int> column(start[n]);
+  std::vector<float> halfCot(start[n]);
+  std::vector<double> area(n, 0.0);
+  for (size_t t = 0; t < triangles; t++) {
+    const int *corner = &mesh.triangles[3 * t];
+    double p[3][3];
+    for (int c = 0; c < 3; c++) {
+      point(corner[c], p[c]);
+    }
+    for (int c = 0; c < 3; c++) {
+      // Angle at corner c, opposite the edge from i to j.
+      const int i = (c + 1) % 3, j = (c + 2) % 3;
+      double u[3], w[3];
+      for (int k = 0; k < 3; k++) {
+        u[k] = p[i][k] - p[c][k];
+        w[k] = p[j][k] - p[c][k];
+      }
+      const double dot = u[0] * w[0] + u[1] * w[1] + u[2] * w[2];
+      const double cross[3] = {u[1] * w[2] - u[2] * w[1], u[2] * w[0] - u[0] * w[2],
+                               u[0] * w[1] - u[1] * w[0]};
+      const double twiceArea =
+          std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+      const float value = twiceArea > 0.0 ? static_cast<float>(0.5 * dot / twiceArea) : 0.0f;
+      column[fill[corner[i]]] = corner[j];
+      halfCot[fill[corner[i]]++] = value;
+      column[fill[corner[j]]] = corner[i];
+      halfCot[fill[corner[j]]++] = value;
+      if (c == 0) {
+        for (int v = 0; v < 3; v++) {
+          area[corner[v]] += twiceArea / 6.0;
+        }
+      }
+    }
+  }
+  double totalArea = 0.0;
+  int covered = 0;
+  for (int v = 0; v < n; v++) {
+    totalArea += area[v];
+    covered += area[v] > 0.0;
+  }
+  const double meanArea = covered > 0 ? totalArea / covered : 1.0;
+
+  CsrLaplacian laplacian;
+  laplacian.start.assign(n + 1, 0);
+  laplacian.column.reserve(start[n] / 2 + n);
+  laplacian.weight.reserve(start[n] / 2 + n);
+  std::vector<std::pair<int, float>> row;
+  for (int v = 0; v < n; v++) {
+    row.clear();
+    for (int k = start[v]; k < start[v + 1]; k++) {
+      row.push_back({column[k], halfCot[k]});
+    }
+    std::sort(row.begin(), row.end());
+    // Scaled to a mean vertex area of one: the weights go as 1 / length^2.
+    const double scale = area[v] > 0.0 ? meanArea / area[v] : 0.0;
+    double sum = 0.0;
+    for (size_t k = 0; k < row.size();) {
+      double cot = 0.0;
+      const int u = row[k].first;
+      for (; k < row.size() && row[k].first == u; k++) {
+        cot += row[k].second;
+      }
+      const float weight = static_cast<float>(cot * scale);
+      if (weight != 0.0f) {
+        laplacian.column.push_back(u);
+        laplacian.weight.push_back(weight);
+        sum += std::fabs(weight);
+      }
+    }
+    laplacian.start[v + 1] = static_cast<int>(laplacian.column.size());
+    laplacian.maxWeightSum = std::max(laplacian.maxWeightSum, static_cast<float>(sum));
+  }
+  return laplacian;
+}
+
+const char *meshOrderName(MeshOrder order) {
+  switch (order) {
+  case MeshOrder::Rcm:
+    return "rcm";
+  case MeshOrder::Morton:
+    return "morton";
+  default:
+    return "input";
+  }
+}
+
+bool parseMeshOrder(const std::string &name, MeshOrder &order) {
+  for (MeshOrder candidate : {MeshOrder::Input, MeshOrder::Rcm, MeshOrder::Morton}) {
+    if (name == meshOrderName(candidate)) {
+      order = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<int> vertexOrder(const Mesh &mesh, const CsrLaplacian &laplacian, MeshOrder order) {
+  switch (order) {
+  case MeshOrder::Rcm:
+    return rcmOrder(laplacian);
+  case MeshOrder::Morton:
+    return mortonOrder(mesh);
+  default: {
+    std::vector<int> identity(mesh.vertexCount());
+    for (int v = 0; v < mesh.vertexCount(); v++) {
+      identity[v] = v;
+    }
+    return identity;
+  }
+  }
+}
+
+CsrLaplacian reorder(const CsrLaplacian &laplacian, const std::vector<int> &order) {
+  const int n = laplacian.rows();
+  std::vector<int> position(n);
+  for (int i = 0; i < n; i++) {
+    position[order[i]] = i;
+  }
+  CsrLaplacian result;
+  result.maxWeightSum = laplacian.maxWeightSum;
+  result.start.assign(n + 1, 0);
+  result.column.reserve(laplacian.nonZeros());
+  result.weight.reserve(laplacian.nonZeros());
+  // Entries keep their order within the row, so every order sums the same
+  // terms in the same sequence and gives bit-identical results.
+  for (int i = 0; i < n; i++) {
+    const int v = order[i];
+    for (int k = laplacian.start[v]; k < laplacian.start[v + 1]; k++) {
+      result.column.push_back(position[laplacian.column[k]]);
+      result.weight.push_back(laplacian.weight[k]);
+    }
+    result.start[i + 1] = static_cast<int>(result.column.size());
+  }
+  return result;
+}
+
+int bandwidth(const CsrLaplacian &laplacian) {
+  int width = 0;
+  for (int v = 0; v < laplacian.rows(); v++) {
+    for (int k = laplacian.start[v]; k < laplacian.start[v + 1]; k++) {
+      width = std::max(width, std::abs(laplacian.column[k] - v));
+    }
+  }
+  return width;
+}
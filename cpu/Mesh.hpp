@@ -0,0 +1,68 @@
+#pragma once
+// Triangle meshes for the mesh engine: loading, generated test surfaces, the
+// cotangent laplacian in CSR form and vertex orderings for locality.
+
+#include <string>
+#include <vector>
+
+struct Mesh {
+  std::string name;
+  std::vector<float> positions; // x, y, z of each vertex
+  std::vector<int> triangles;   // three vertex indices per face
+
+  int vertexCount() const { return static_cast<int>(positions.size() / 3); }
+  size_t triangleCount() const { return triangles.size() / 3; }
+};
+
+// Reads an OBJ or PLY file (ascii or binary PLY), chosen by extension.
+// Polygons are split into triangle fans and degenerate faces dropped.
+// "sphere:L" generates an icosphere subdivided L times (10 * 4^L + 2
+// vertices) and "torus:UxV" a torus of U x V vertices, U around the ring and
+// V around the tube. Throws std::runtime_error on unreadable or malformed
+// input.
+Mesh loadMesh(const std::string &source);
+
+// Cotangent laplacian with lumped (barycentric) vertex areas. Row v holds the
+// neighbours of v and their weights
+//   w_vj = (cot alpha_vj + cot beta_vj) / (2 area_v),
+// the angles being those opposite edge vj, so that the laplacian of u at v is
+// the sum of w_vj (u_j - u_v) over the row. Lengths are scaled so that the
+// mean vertex area is one, one vertex per unit area as the grid has one cell,
+// so SimArgs carry over unchanged: a flat right-triangulated grid gives the
+// 5-point stencil in its interior, up to the smaller border vertices' share
+// of the mean. Open borders are zero-flux.
+struct CsrLaplacian {
+  std::vector<int> start; // rows + 1 offsets into column and weight
+  std::vector<int> column;
+  std::vector<float> weight;
+  // Largest sum of |w_vj| over a row. Every eigenvalue of the laplacian lies
+  // within twice this of zero, so forward Euler is stable for
+  // timeStep * diffusion <= 1 / maxWeightSum.
+  float maxWeightSum = 0.0f;
+
+  int rows() const { return static_cast<int>(start.size()) - 1; }
+  size_t nonZeros() const { return column.size(); }
+  size_t bytes() const {
+    return start.size() * sizeof(int) + column.size() * sizeof(int) +
+           weight.size() * sizeof(float);
+  }
+};
+
+CsrLaplacian cotangentLaplacian(const Mesh &mesh);
+
+// Vertex orderings. Rcm is reverse Cuthill-McKee on the mesh graph, which
+// keeps the neighbours of a vertex close to it in memory; Morton sorts the
+// vertices along a Z-order curve through their positions.
+enum class MeshOrder { Input, Rcm, Morton };
+
+const char *meshOrderName(MeshOrder order);
+bool parseMeshOrder(const std::string &name, MeshOrder &order);
+
+// order[n] is the input index of the vertex stored n-th.
+std::vector<int> vertexOrder(const Mesh &mesh, const CsrLaplacian &laplacian, MeshOrder order);
+
+// The laplacian with rows and columns renumbered by `order`.
+CsrLaplacian reorder(const CsrLaplacian &laplacian, const std::vector<int> &order);
+
+// Largest |row - column| over the stored entries.
+int bandwidth(const CsrLaplacian &laplacian);
@@ -0,0 +1,134 @@
+#include "MeshEngine.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include "Planes.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+class CsrMeshEngine : public MeshEngine {
+public:
+  CsrMeshEngine(const Config &config, const Mesh &mesh, const EngineOptions &options)
+      : MeshEngine(config), _kernel(meshKernel(options.isa)), _pool(options.threads) {
+    auto start = std::chrono::steady_clock::now();
+    CsrLaplacian laplacian = cotangentLaplacian(mesh);
+    const double buildSeconds = secondsSince(start);
+    const int inputBandwidth = bandwidth(laplacian);
+    start = std::chrono::steady_clock::now();
+    _order = vertexOrder(mesh, laplacian, options.meshOrder);
+    if (options.meshOrder != MeshOrder::Input) {
+      _laplacian = reorder(laplacian, _order);
+    } else {
+      _laplacian = std::move(laplacian);
+    }
+    const double orderSeconds = secondsSince(start);
+    const size_t n = _order.size();
+    for (AlignedFloats &plane : _planes) {
+      plane.assign(n, 0.0f);
+    }
+    char stats[256];
+    snprintf(stats, sizeof(stats),
+             "%zu vertices, %zu triangles, %.2f neighbours/vertex; laplacian in %.2f s, "
+             "%s order in %.2f s, bandwidth %d (%d as loaded)",
+             n, mesh.triangleCount(), double(_laplacian.nonZeros()) / n, buildSeconds,
+             meshOrderName(options.meshOrder), orderSeconds, bandwidth(_laplacian),
+             inputBandwidth);
+    _stats = stats;
+    _name = "mesh/" + std::string(meshOrderName(options.meshOrder)) + "/" +
+            isaName(resolveIsa(options.isa)) + "/" + std::to_string(_pool.size()) + "t";
+  }
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(const Grid &grid) override {
+    float *a = _planes[2 * _current].data();
+    float *b = _planes[2 * _current + 1].data();
+    for (size_t i = 0; i < _order.size(); i++) {
+      a[i] = grid.cells[2 * size_t(_order[i])];
+      b[i] = grid.cells[2 * size_t(_order[i]) + 1];
+    }
+  }
+
+  void getState(Grid &grid) const override {
+    grid = Grid(static_cast<int>(_order.size()), 1);
+    const float *a = _planes[2 * _current].data();
+    const float *b = _planes[2 * _current + 1].data();
+    for (size_t i = 0; i < _order.size(); i++) {
+      grid.cells[2 * size_t(_order[i])] = a[i];
+      grid.cells[2 * size_t(_order[i]) + 1] = b[i];
+    }
+  }
+
+  size_t stateBytes() const override {
+    return 4 * _order.size() * sizeof(float) + _laplacian.bytes() + _order.size() * sizeof(int);
+  }
+
+  std::string stats() const override { return _stats; }
+
+  float stepLimit() const override {
+    const SimArgs &args = _config.simArgs;
+    return 1.0f / (_laplacian.maxWeightSum * std::max(args.diffA, args.diffB));
+  }
+
+  void step(int steps) override {
+    const int n = static_cast<int>(_order.size());
+    _pool.run([&](int thread) {
+      int v0, v1;
+      splitRange(n, _pool.size(), thread, v0, v1);
+      for (int s = 0; s < steps; s++) {
+        const int in = (_current + s) % 2;
+        const int out = 1 - in;
+        MeshRows rows = {_laplacian.start.data(), _laplacian.column.data(),
+                         _laplacian.weight.data(), _planes[2 * in].data(),
+                         _planes[2 * in + 1].data(), _planes[2 * out].data(),
+                         _planes[2 * out + 1].data()};
+        _kernel(rows, v0, v1 - v0, _config.simArgs);
+        _pool.barrier();
+      }
+    });
+    _current = (_current + steps) % 2;
+  }
+
+private:
+  MeshKernel _kernel;
+  ThreadPool _pool;
+  CsrLaplacian _laplacian;
+  std::vector<int> _order; // input index of each stored vertex
+  AlignedFloats _planes[4]; // A and B of the two time levels
+  int _current = 0;
+  std::string _stats;
+  std::string _name;
+};
+
+} // namespace
+
+std::unique_ptr<MeshEngine> makeSeededMeshEngine(const Config &config, const Mesh &mesh,
+                                                 const EngineOptions &options) {
+  if (config.rates.active()) {
+    throw std::invalid_argument("The mesh engine only supports uniform feed and kill rates, " +
+                                config.name + " varies them over the grid");
+  }
+  if (!config.model.grayScott()) {
+    throw std::invalid_argument("The mesh engine only runs the Gray-Scott model, " +
+                                config.name + " uses " + config.model.name);
+  }
+  if (config.stencil != "5-point") {
+    throw std::invalid_argument("The mesh engine uses the cotangent laplacian, " + config.name +
+                                " asks for the " + config.stencil + " stencil");
+  }
+  if (config.boundary == "dirichlet") {
+    throw std::invalid_argument("The mesh engine has no Dirichlet walls: open mesh borders "
+                                "are zero-flux");
+  }
+  auto engine = std::make_unique<CsrMeshEngine>(config, mesh, options);
+  Grid vertices(mesh.vertexCount(), 1);
+  seedGrid(vertices, config.noiseDensity, options.seed);
+  engine->setState(vertices);
+  return engine;
+}
@@ -0,0 +1,63 @@
+#pragma once
+// Generic model kernel, included by the kernel translation units only. Each of
+// them instantiates it with its own vector type, which must be declared in an
+// anonymous namespace: that gives every instantiation (and the model's
+// react<V>) internal linkage, so code built for one instruction set is never
+// picked by the linker for another.
+//
+// A vector type V provides
+//   V::width                      floats per vector
+//   V(float)                      broadcast
+//   V::load(p), v.store(p)        unaligned load and store
+//   + - *, madd(a, b, c) = a * b + c, vmin, vmax
+
+#include "Kernels.hpp"
+
+// Steps cells [x, count) of `row` in whole vectors and returns the first cell
+// left over (fewer than V::width of them). Per species: the 5-point laplacian
+// (up + down) + (left + right) - 4 c, then c + dt (diffusion lap + rate),
+// clamped to [0, 1] if the model asks for it.
+template <class Model, class V>
+int stepModelCells(const ModelRow &row, int x, int count, const ModelArgs &args) {
+  constexpr int n = Model::species;
+  V diffusion[n];
+  for (int s = 0; s < n; s++) {
+    diffusion[s] = V(args.diffusion[s]);
+  }
+  V k[kMaxModelParams];
+  for (int i = 0; i < kMaxModelParams; i++) {
+    k[i] = V(args.param[i]);
+  }
+  const V dt(args.timeStep);
+  const V minusFour(-4.0f);
+  const V zero(0.0f);
+  const V one(1.0f);
+  // Row pointers in locals, which the compiler keeps in registers across the
+  // stores.
+  const float *up[n], *mid[n], *down[n];
+  float *out[n];
+  for (int s = 0; s < n; s++) {
+    up[s] = row.up[s];
+    mid[s] = row.mid[s];
+    down[s] = row.down[s];
+    out[s] = row.out[s];
+  }
+  for (; x + V::width <= count; x += V::width) {
+    V c[n], lap[n], rate[n];
+    for (int s = 0; s < n; s++) {
+      c[s] = V::load(mid[s] + x);
+      V vert = V::load(up[s] + x) + V::load(down[s] + x);
+      V horz = V::load(mid[s] + x - 1) + V::load(mid[s] + x + 1);
+      lap[s] = madd(minusFour, c[s], vert + horz);
+    }
+    Model::react(static_cast<const V *>(c), rate, static_cast<const V *>(k));
+    for (int s = 0; s < n; s++) {
+      V next = madd(dt, madd(diffusion[s], lap[s], rate[s]), c[s]);
+      if constexpr (Model::clampUnit) {
+        next = vmin(vmax(next, zero), one);
+      }
+      next.store(out[s] + x);
+    }
+  }
+  return x;
+}
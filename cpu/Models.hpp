@@ -0,0 +1,256 @@
+#pragma once
+// Reaction models for the model engine: each is a functor type whose species
+// count and reaction are compile-time constants, so a kernel instantiated
+// for a model (ModelKernels.hpp) fuses the laplacian, the reaction and the
+// step into one loop with no dispatch inside it.
+//
+// A model provides
+//   species, name, paramNames   compile-time description
+//   react(c, rate, k)           reaction rates of one cell (or one vector of
+//                               cells): c and rate hold one value per
+//                               species, k the parameters in paramNames
+//                               order. Templated on the arithmetic type, so
+//                               the same code runs on floats and vectors.
+//   clampUnit                   clamp every species to [0, 1] after a step
+//   rest(k, c)                  the homogeneous steady state: wall values of
+//                               the Dirichlet boundary and the initial state
+//   seed(k, noise, i, c)        initial state of cell i (row-major index),
+//                               given its noise bit (0 or 1) from the usual
+//                               seed grid
+//
+// All diffusion is the 5-point laplacian with one rate per species.
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "Config.hpp"
+
+constexpr int kMaxSpecies = 4;
+constexpr int kMaxModelParams = 8;
+
+// Resolved run-time parameters of a model, in its own order.
+struct ModelArgs {
+  float diffusion[kMaxSpecies];
+  float param[kMaxModelParams];
+  float timeStep;
+};
+
+// u + v -> 2v, v -> decay, fed by u. Matches sim_main with k = {feed, kill}.
+struct GrayScottModel {
+  static constexpr int species = 2;
+  static constexpr const char *name = "gray_scott";
+  static constexpr const char *paramNames[] = {"feed", "kill"};
+  static constexpr bool clampUnit = true;
+
+  template <class T>
+  static void react(const T *c, T *rate, const T *k) {
+    T reaction = c[0] * (c[1] * c[1]);
+    rate[0] = k[0] * (T(1.0f) - c[0]) - reaction;
+    rate[1] = reaction - (k[0] + k[1]) * c[1];
+  }
+  static void rest(const float *, float *c) {
+    c[0] = 1.0f;
+    c[1] = 0.0f;
+  }
+  static void seed(const float *, float noise, size_t, float *c) {
+    c[0] = 1.0f;
+    c[1] = noise;
+  }
+};
+
+// Brusselator, k = {a, b}: spots and stripes when b is above the Turing
+// threshold (1 + a sqrt(Du / Dv))^2 but below the Hopf one, 1 + a^2.
+struct BrusselatorModel {
+  static constexpr int species = 2;
+  static constexpr const char *name = "brusselator";
+  static constexpr const char *paramNames[] = {"a", "b"};
+  static constexpr bool clampUnit = false;
+
+  template <class T>
+  static void react(const T *c, T *rate, const T *k) {
+    T uuv = c[0] * c[0] * c[1];
+    rate[0] = k[0] - (k[1] + T(1.0f)) * c[0] + uuv;
+    rate[1] = k[1] * c[0] - uuv;
+  }
+  static void rest(const float *k, float *c) {
+    c[0] = k[0];
+    c[1] = k[1] / k[0];
+  }
+  static void seed(const float *k, float noise, size_t, float *c) {
+    rest(k, c);
+    c[0] *= 1.0f + 0.2f * noise;
+  }
+};
+
+// Schnakenberg, k = {a, b, gamma}: spots for a large enough Dv / Du.
+struct SchnakenbergModel {
+  static constexpr int species = 2;
+  static constexpr const char *name = "schnakenberg";
+  static constexpr const char *paramNames[] = {"a", "b", "gamma"};
+  static constexpr bool clampUnit = false;
+
+  template <class T>
+  static void react(const T *c, T *rate, const T *k) {
+    T uuv = c[0] * c[0] * c[1];
+    rate[0] = k[2] * (k[0] - c[0] + uuv);
+    rate[1] = k[2] * (k[1] - uuv);
+  }
+  static void rest(const float *k, float *c) {
+    c[0] = k[0] + k[1];
+    c[1] = k[1] / (c[0] * c[0]);
+  }
+  static void seed(const float *k, float noise, size_t, float *c) {
+    rest(k, c);
+    c[0] *= 1.0f + 0.2f * noise;
+  }
+};
+
+// FitzHugh-Nagumo in its Turing form, k = {a0, a1, epsilon}:
+//   du = u - u^3 - v,  dv = epsilon (u - a1 v - a0)
+// Labyrinths where the rest state is stable without diffusion (epsilon a1 > 1,
+// a1 < 1) and the inhibitor v diffuses much faster than u.
+struct FitzHughNagumoModel {
+  static constexpr int species = 2;
+  static constexpr const char *name = "fitzhugh_nagumo";
+  static constexpr const char *paramNames[] = {"a0", "a1", "epsilon"};
+  static constexpr bool clampUnit = false;
+
+  template <class T>
+  static void react(const T *c, T *rate, const T *k) {
+    rate[0] = c[0] - c[0] * c[0] * c[0] - c[1];
+    rate[1] = k[2] * (c[0] - k[1] * c[1] - k[0]);
+  }
+  // The root of u - u^3 = (u - a0) / a1 nearest 0, by Newton's method.
+  static void rest(const float *k, float *c) {
+    double u = 0.0;
+    for (int i = 0; i < 50; i++) {
+      double f = u - u * u * u - (u - k[0]) / k[1];
+      double df = 1.0 - 3.0 * u * u - 1.0 / k[1];
+      u -= f / df;
+    }
+    c[0] = static_cast<float>(u);
+    c[1] = static_cast<float>((u - k[0]) / k[1]);
+  }
+  static void seed(const float *k, float noise, size_t, float *c) {
+    rest(k, c);
+    c[0] += 0.5f * noise;
+  }
+};
+
+// May-Leonard cyclic competition of three species, k = {alpha, beta}:
+//   du_i = u_i (1 - u_i - alpha u_(i+1) - beta u_(i+2))
+// With alpha + beta > 2 the coexistence point is unstable and the species
+// chase each other in spirals.
+struct MayLeonardModel {
+  static constexpr int species = 3;
+  static constexpr const char *name = "may_leonard";
+  static constexpr const char *paramNames[] = {"alpha", "beta"};
+  static constexpr bool clampUnit = true;
+
+  template <class T>
+  static void react(const T *c, T *rate, const T *k) {
+    for (int i = 0; i < 3; i++) {
+      rate[i] = c[i] * (T(1.0f) - c[i] - k[0] * c[(i + 1) % 3] - k[1] * c[(i + 2) % 3]);
+    }
+  }
+  static void rest(const float *k, float *c) {
+    c[0] = c[1] = c[2] = 1.0f / (1.0f + k[0] + k[1]);
+  }
+  // Each noise cell goes to one species, in turn along the row.
+  static void seed(const float *k, float noise, size_t cell, float *c) {
+    rest(k, c);
+    if (noise > 0.0f) {
+      c[cell % 3] = 1.0f;
+    }
+  }
+};
+
+enum class ReactionModel { GrayScott, Brusselator, Schnakenberg, FitzHughNagumo, MayLeonard };
+
+// Calls fn(Model{}) with the model type named by `name` and returns its result.
+template <class Fn>
+auto withModel(const std::string &name, Fn &&fn) {
+  if (name == GrayScottModel::name) {
+    return fn(GrayScottModel{});
+  }
+  if (name == BrusselatorModel::name) {
+    return fn(BrusselatorModel{});
+  }
+  if (name == SchnakenbergModel::name) {
+    return fn(SchnakenbergModel{});
+  }
+  if (name == FitzHughNagumoModel::name) {
+    return fn(FitzHughNagumoModel{});
+  }
+  if (name == MayLeonardModel::name) {
+    return fn(MayLeonardModel{});
+  }
+  throw std::invalid_argument("Unknown reaction model: " + name);
+}
+
+template <class Model>
+constexpr ReactionModel modelId() {
+  if constexpr (std::is_same_v<Model, GrayScottModel>) {
+    return ReactionModel::GrayScott;
+  } else if constexpr (std::is_same_v<Model, BrusselatorModel>) {
+    return ReactionModel::Brusselator;
+  } else if constexpr (std::is_same_v<Model, SchnakenbergModel>) {
+    return ReactionModel::Schnakenberg;
+  } else if constexpr (std::is_same_v<Model, FitzHughNagumoModel>) {
+    return ReactionModel::FitzHughNagumo;
+  } else {
+    return ReactionModel::MayLeonard;
+  }
+}
+
+// Resolves a config's diffusion rates and named parameters for Model. The
+// Gray-Scott model falls back to simArgs. Throws std::invalid_argument for a
+// missing or unknown parameter or the wrong number of diffusion rates.
+template <class Model>
+ModelArgs modelArgs(const Config &config) {
+  const ModelConfig &model = config.model;
+  ModelArgs args = {};
+  args.timeStep = config.simArgs.timeStep;
+  constexpr int paramCount = sizeof(Model::paramNames) / sizeof(Model::paramNames[0]);
+  if constexpr (std::is_same_v<Model, GrayScottModel>) {
+    if (model.diffusion.empty()) {
+      args.diffusion[0] = config.simArgs.diffA;
+      args.diffusion[1] = config.simArgs.diffB;
+    }
+    args.param[0] = config.simArgs.feed;
+    args.param[1] = config.simArgs.kill;
+  }
+  if (!model.diffusion.empty()) {
+    if (model.diffusion.size() != size_t(Model::species)) {
+      throw std::invalid_argument(config.name + ": model " + Model::name + " needs " +
+                                  std::to_string(Model::species) + " diffusion rates");
+    }
+    for (int s = 0; s < Model::species; s++) {
+      args.diffusion[s] = model.diffusion[s];
+    }
+  } else if (!std::is_same_v<Model, GrayScottModel>) {
+    throw std::invalid_argument(config.name + ": model " + Model::name +
+                                " needs \"diffusion\" rates");
+  }
+  for (const auto &[key, value] : model.params) {
+    int i = 0;
+    while (i < paramCount && key != Model::paramNames[i]) {
+      i++;
+    }
+    if (i == paramCount) {
+      throw std::invalid_argument(config.name + ": model " + Model::name +
+                                  " has no parameter " + key);
+    }
+  }
+  for (int i = 0; i < paramCount; i++) {
+    auto it = model.params.find(Model::paramNames[i]);
+    if (it != model.params.end()) {
+      args.param[i] = it->second;
+    } else if (!std::is_same_v<Model, GrayScottModel>) {
+      throw std::invalid_argument(config.name + ": model " + Model::name + " needs parameter " +
+                                  Model::paramNames[i]);
+    }
+  }
+  return args;
+}
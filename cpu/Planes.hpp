@@ -0,0 +1,77 @@
+#pragma once
+// Structure-of-arrays state: separate A and B planes, each row starting on a
+// 64-byte boundary, with a ghost border like PaddedGrid.
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include "Grid.hpp"
+
+// Bytes every plane row is aligned to (one cache line, one AVX-512 register).
+constexpr size_t kPlaneAlignment = 64;
+constexpr int kPlaneAlignFloats = kPlaneAlignment / sizeof(float);
+
+template <class T>
+struct AlignedAllocator {
+  using value_type = T;
+
+  AlignedAllocator() = default;
+  template <class U>
+  AlignedAllocator(const AlignedAllocator<U> &) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(kPlaneAlignment)));
+  }
+  void deallocate(T *p, size_t) { ::operator delete(p, std::align_val_t(kPlaneAlignment)); }
+
+  template <class U>
+  bool operator==(const AlignedAllocator<U> &) const { return true; }
+  template <class U>
+  bool operator!=(const AlignedAllocator<U> &) const { return false; }
+};
+
+using AlignedFloats = std::vector<float, AlignedAllocator<float>>;
+
+inline int roundUpFloats(int n) {
+  return (n + kPlaneAlignFloats - 1) / kPlaneAlignFloats * kPlaneAlignFloats;
+}
+
+// Row layout: [lead: ghost cells right-aligned][width interior cells][ghost + pad].
+// `lead` is a whole cache line so that interior cell 0 of every row is aligned.
+struct PlaneGrid {
+  int width = 0;
+  int height = 0;
+  int ghost = 0;
+  int lead = 0;   // floats before interior cell 0 of a row
+  int stride = 0; // floats per row, a multiple of 16
+  AlignedFloats a;
+  AlignedFloats b;
+
+  PlaneGrid() = default;
+  PlaneGrid(int w, int h, int g)
+      : width(w), height(h), ghost(g), lead(roundUpFloats(g)),
+        stride(roundUpFloats(lead + w + g)), a(size_t(stride) * (h + 2 * g), 0.0f),
+        b(size_t(stride) * (h + 2 * g), 0.0f) {}
+
+  float *rowA(int y) { return a.data() + size_t(y + ghost) * stride + lead; }
+  float *rowB(int y) { return b.data() + size_t(y + ghost) * stride + lead; }
+  const float *rowA(int y) const { return a.data() + size_t(y + ghost) * stride + lead; }
+  const float *rowB(int y) const { return b.data() + size_t(y + ghost) * stride + lead; }
+
+  void load(const Grid &grid) {
+    for (int y = 0; y < height; y++) {
+      const float *src = grid.row(y);
+      float *dstA = rowA(y);
+      float *dstB = rowB(y);
+      for (int x = 0; x < width; x++) {
+        dstA[x] = src[2 * x];
+        dstB[x] = src[2 * x + 1];
+      }
+    }
+  }
+
+  size_t bytes() const { return (a.size() + b.size()) * sizeof(float); }
+
+  // Interleaved view for exporters that expect the texture layout.
+  StateView view() const { return {width, height, rowA(0), rowB(0), 1, stride}; }
+};
@@ -0,0 +1,203 @@
+// Super-time-stepping engine: second-order Runge-Kutta-Legendre (RKL2, Meyer,
+// Balsara and Aslam 2014) on SoA planes. One step of size tau is s explicit
+// stages, each a stencil pass through the rate kernel, arranged as a
+// Legendre recursion whose stability interval grows with s^2:
+//
+//   tau <= tau_euler * (s^2 + s - 2) / 4,   tau_euler = explicitStepLimit(2)
+//
+// so s stages buy a step (s^2 + s - 2) / 4 times the forward Euler limit
+// for the cost of s evaluations. The stages integrate the whole right-hand
+// side, diffusion and reaction. The reaction stays inside the stability
+// interval, but each stage takes it explicitly, so the step comes from
+// implicitTimeStep() under the reaction's limit: at dt = 1 coral, worms and
+// u_skate_world die out. The stage count is the smallest s that makes that
+// step stable for diffusion.
+//
+// Each stage computes the rates of one row into a per-thread buffer and
+// combines them with the earlier stages right away, so a stage is a single
+// pass over the planes:
+//
+//   Y1 = Y0 + mu~1 tau L(Y0)
+//   Yj = mu_j Y(j-1) + nu_j Y(j-2) + (1 - mu_j - nu_j) Y0
+//        + mu~j tau L(Y(j-1)) + gamma~j tau L(Y0),   j = 2..s
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "Boundary.hpp"
+#include "Engine.hpp"
+#include "Kernels.hpp"
+#include "Planes.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+// Fraction of the stability interval used.
+constexpr float kStabilitySafety = 0.9f;
+
+struct StageCoefficients {
+  float mu, nu, muTilde, gammaTilde;
+};
+
+// RKL2 recursion coefficients for s stages (index j = 1..s; entry 0 unused).
+std::vector<StageCoefficients> rkl2Coefficients(int s) {
+  std::vector<double> b(s + 1);
+  for (int j = 0; j <= s; j++) {
+    b[j] = j < 2 ? 1.0 / 3.0 : (double(j) * j + j - 2.0) / (2.0 * j * (j + 1.0));
+  }
+  const double w1 = 4.0 / (double(s) * s + s - 2.0);
+  std::vector<StageCoefficients> c(s + 1, StageCoefficients{0, 0, 0, 0});
+  c[1].muTilde = float(b[1] * w1);
+  for (int j = 2; j <= s; j++) {
+    const double mu = (2.0 * j - 1.0) / j * b[j] / b[j - 1];
+    const double nu = -(j - 1.0) / j * b[j] / b[j - 2];
+    const double muTilde = mu * w1;
+    const double gammaTilde = -(1.0 - b[j - 1]) * muTilde;
+    c[j] = {float(mu), float(nu), float(muTilde), float(gammaTilde)};
+  }
+  return c;
+}
+
+template <class Boundary>
+class RklEngine : public Engine {
+public:
+  RklEngine(const Config &config, const EngineOptions &options)
+      : Engine(config), _kernel(rateKernel(options.isa)),
+        _combine(combineKernel(options.isa)), _pool(options.threads),
+        _rates(_pool.size()) {
+    const float eulerLimit = kStabilitySafety * explicitStepLimit(config.simArgs, 2.0f);
+    const float tau = implicitTimeStep(config, options);
+    _stages = 2;
+    while (eulerLimit * (float(_stages) * _stages + _stages - 2.0f) / 4.0f < tau) {
+      _stages++;
+    }
+    _config.simArgs.timeStep = tau;
+    _coefficients = rkl2Coefficients(_stages);
+    for (PlaneGrid &grid : _y) {
+      grid = PlaneGrid(config.width, config.height, 1);
+    }
+    _rate0 = PlaneGrid(config.width, config.height, 0);
+    for (RowRates &rates : _rates) {
+      rates.a.resize(roundUpFloats(config.width));
+      rates.b.resize(roundUpFloats(config.width));
+    }
+    char dt[32];
+    snprintf(dt, sizeof(dt), "%g", tau);
+    _name = "rkl/" + std::string(Boundary::name) + "/" + isaName(resolveIsa(options.isa)) +
+            "/" + std::to_string(_pool.size()) + "t/dt=" + dt + "/s=" + std::to_string(_stages);
+  }
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(const Grid &grid) override { _y[_current].load(grid); }
+  StateView stateView() const override { return _y[_current].view(); }
+  size_t stateBytes() const override {
+    size_t bytes = _rate0.bytes();
+    for (const PlaneGrid &grid : _y) {
+      bytes += grid.bytes();
+    }
+    return bytes;
+  }
+
+  std::string stats() const override {
+    char text[128];
+    snprintf(text, sizeof(text), "%d stages per step, %.1fx the forward Euler step limit",
+             _stages, (float(_stages) * _stages + _stages - 2.0f) / 4.0f);
+    return text;
+  }
+
+  void step(int steps) override {
+    _pool.run([&](int thread) {
+      int rowBegin, rowEnd;
+      splitRange(_config.height, _pool.size(), thread, rowBegin, rowEnd);
+      for (int s = 0; s < steps; s++) {
+        // Y0 and the two previous stages rotate through the four planes.
+        int y0 = _current;
+        int prev2 = y0;
+        int prev = y0;
+        for (int j = 1; j <= _stages; j++) {
+          int out = 0;
+          while (out == y0 || out == prev || out == prev2) {
+            out++;
+          }
+          stage(j, _y[y0], _y[prev], _y[prev2], _y[out], rowBegin, rowEnd, thread);
+          prev2 = prev;
+          prev = out;
+        }
+        if (thread == 0) {
+          _current = prev;
+        }
+        _pool.barrier();
+      }
+    });
+  }
+
+private:
+  struct RowRates {
+    AlignedFloats a, b;
+  };
+
+  PlaneKernel _kernel;
+  CombineKernel _combine;
+  ThreadPool _pool;
+  int _stages = 0;
+  std::vector<StageCoefficients> _coefficients;
+  PlaneGrid _y[4]; // Y0, Y(j-2), Y(j-1) and the stage being written
+  PlaneGrid _rate0; // L(Y0)
+  std::vector<RowRates> _rates; // one row per thread
+  int _current = 0;
+  std::string _name;
+
+  // Writes stage j into `out` for this thread's rows. Stage 1 also stores
+  // L(Y0) for the later stages.
+  void stage(int j, const PlaneGrid &y0, PlaneGrid &in, const PlaneGrid &prev2, PlaneGrid &out,
+             int rowBegin, int rowEnd, int thread) {
+    fillGhostColumns<Boundary>(in, rowBegin, rowEnd);
+    if (thread == 0) {
+      fillGhostRows<Boundary>(in);
+    }
+    _pool.barrier();
+    const float tau = _config.simArgs.timeStep;
+    const StageCoefficients &c = _coefficients[j];
+    const float weights[] = {c.mu, c.nu, 1.0f - c.mu - c.nu, c.muTilde * tau,
+                             c.gammaTilde * tau};
+    const float firstWeights[] = {1.0f, c.muTilde * tau};
+    RowRates &rates = _rates[thread];
+    const int width = _config.width;
+    for (int y = rowBegin; y < rowEnd; y++) {
+      PlaneRow row = {in.rowA(y - 1), in.rowA(y),     in.rowA(y + 1), in.rowB(y - 1),
+                      in.rowB(y),     in.rowB(y + 1), rates.a.data(), rates.b.data()};
+      _kernel(row, width, _config.simArgs);
+      for (int plane = 0; plane < 2; plane++) {
+        auto rowOf = [&](auto &grid) { return plane ? grid.rowB(y) : grid.rowA(y); };
+        const float *rate = plane ? rates.b.data() : rates.a.data();
+        float *rate0 = rowOf(_rate0);
+        float *dst = rowOf(out);
+        if (j == 1) {
+          std::copy(rate, rate + width, rate0);
+          const float *src[] = {rowOf(y0), rate};
+          _combine(dst, src, firstWeights, 2, width);
+        } else {
+          const float *src[] = {rowOf(in), rowOf(prev2), rowOf(y0), rate, rate0};
+          _combine(dst, src, weights, 5, width);
+        }
+        // The last stage is the new state: clamp it to [0, 1] as sim_main
+        // does. The stages before it are not states and are left alone.
+        if (j == _stages) {
+          for (int x = 0; x < width; x++) {
+            dst[x] = std::clamp(dst[x], 0.0f, 1.0f);
+          }
+        }
+      }
+    }
+    _pool.barrier();
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Engine> makeRklEngine(const Config &config, const EngineOptions &options) {
+  return withBoundary(config.boundary, [&](auto boundary) -> std::unique_ptr<Engine> {
+    return std::make_unique<RklEngine<decltype(boundary)>>(config, options);
+  });
+}
@@ -0,0 +1,66 @@
+// Reference engine: one cell at a time, every neighbour looked up through the
+// boundary policy (for periodic grids, wrap by modulo indexing). Kept
+// deliberately simple; the faster engines are checked against it.
+
+#include "Boundary.hpp"
+#include "Engine.hpp"
+#include "Kernels.hpp"
+
+namespace {
+
+template <class Boundary>
+class ScalarEngine : public Engine {
+public:
+  explicit ScalarEngine(const Config &config)
+      : Engine(config), _simInput(config.width, config.height),
+        _simOutput(config.width, config.height) {}
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(const Grid &grid) override { _simInput = grid; }
+  StateView stateView() const override { return _simInput.view(); }
+  size_t stateBytes() const override { return _simInput.bytes() + _simOutput.bytes(); }
+
+  void step(int steps) override {
+    for (int i = 0; i < steps; i++) {
+      stepOnce();
+      // Swap grids for next step, same as the texture ping-pong in Renderer::draw
+      std::swap(_simInput, _simOutput);
+    }
+  }
+
+private:
+  Grid _simInput;
+  Grid _simOutput;
+  std::string _name = std::string("scalar/") + Boundary::name;
+
+  void stepOnce() {
+    const int w = _config.width;
+    const int h = _config.height;
+    const SimArgs &args = _config.simArgs;
+    const bool rateField = _config.rates.active();
+    for (int y = 0; y < h; y++) {
+      float *out = _simOutput.row(y);
+      for (int x = 0; x < w; x++) {
+        auto cell = [&](int dx, int dy, int c) {
+          return boundaryCell<Boundary>(_simInput, x + dx, y + dy, c);
+        };
+        float a = cell(0, 0, 0);
+        float b = cell(0, 0, 1);
+        float lapA = cell(0, -1, 0) + cell(0, 1, 0) + cell(-1, 0, 0) + cell(1, 0, 0) - 4.0f * a;
+        float lapB = cell(0, -1, 1) + cell(0, 1, 1) + cell(-1, 0, 1) + cell(1, 0, 1) - 4.0f * b;
+        grayScottCell(a, b, lapA, lapB, rateField ? cellArgs(_config, x, y) : args, out[2 * x],
+                      out[2 * x + 1]);
+      }
+    }
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Engine> makeScalarEngine(const Config &config, const EngineOptions &options) {
+  (void)options;
+  return withBoundary(config.boundary, [&](auto boundary) -> std::unique_ptr<Engine> {
+    return std::make_unique<ScalarEngine<decltype(boundary)>>(config);
+  });
+}
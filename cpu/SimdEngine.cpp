@@ -0,0 +1,41 @@
+// Single-threaded engine using the widest row kernel the CPU supports.
+
+#include "Engine.hpp"
+#include "Kernels.hpp"
+
+namespace {
+
+class SimdEngine : public Engine {
+public:
+  SimdEngine(const Config &config, Isa isa)
+      : Engine(config), _isa(resolveIsa(isa)), _kernel(rowKernel(_isa)),
+        _simInput(config.width, config.height), _simOutput(config.width, config.height),
+        _name(std::string("simd/") + isaName(_isa)) {}
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(const Grid &grid) override { _simInput = grid; }
+  StateView stateView() const override { return _simInput.view(); }
+  size_t stateBytes() const override { return _simInput.bytes() + _simOutput.bytes(); }
+
+  void step(int steps) override {
+    for (int i = 0; i < steps; i++) {
+      stepRegionPeriodic(_simInput, _simOutput, 0, _config.width, 0, _config.height, _kernel,
+                         _config.simArgs);
+      std::swap(_simInput, _simOutput);
+    }
+  }
+
+private:
+  Isa _isa;
+  RowKernel _kernel;
+  Grid _simInput;
+  Grid _simOutput;
+  std::string _name;
+};
+
+} // namespace
+
+std::unique_ptr<Engine> makeSimdEngine(const Config &config, const EngineOptions &options) {
+  return std::make_unique<SimdEngine>(config, options.isa);
+}
@@ -0,0 +1,81 @@
+// Threaded engine on structure-of-arrays planes. Same tiling, ghost border and
+// boundary policies as the ghost engine, but A and B live in separate
+// 64-byte aligned planes, so the kernel loads whole registers of one species
+// without the deinterleaving shuffles the RG layout needs.
+
+#include "Boundary.hpp"
+#include "Engine.hpp"
+#include "Kernels.hpp"
+#include "Planes.hpp"
+#include "ThreadPool.hpp"
+#include "Tiling.hpp"
+
+namespace {
+
+template <class Boundary>
+class SoaEngine : public Engine {
+public:
+  SoaEngine(const Config &config, const EngineOptions &options)
+      : Engine(config), _kernel(planeKernel(options.isa)), _pool(options.threads),
+        _grids{PlaneGrid(config.width, config.height, 1),
+               PlaneGrid(config.width, config.height, 1)} {
+    int tileWidth = options.tileWidth;
+    int tileHeight = options.tileHeight;
+    autoTileSize(config.width, config.height, _pool.size(), tileWidth, tileHeight);
+    _tiles = makeTiles(config.width, config.height, tileWidth, tileHeight);
+    _name = "soa/" + std::string(Boundary::name) + "/" + isaName(resolveIsa(options.isa)) +
+            "/" + std::to_string(_pool.size()) + "t/" + std::to_string(tileWidth) + "x" +
+            std::to_string(tileHeight);
+  }
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(const Grid &grid) override { _grids[_current].load(grid); }
+  StateView stateView() const override { return _grids[_current].view(); }
+  size_t stateBytes() const override { return _grids[0].bytes() + _grids[1].bytes(); }
+
+  void step(int steps) override {
+    const int threads = _pool.size();
+    const int tileCount = static_cast<int>(_tiles.size());
+    _pool.run([&](int thread) {
+      int begin, end, rowBegin, rowEnd;
+      splitRange(tileCount, threads, thread, begin, end);
+      splitRange(_config.height, threads, thread, rowBegin, rowEnd);
+      for (int s = 0; s < steps; s++) {
+        PlaneGrid &in = _grids[(_current + s) % 2];
+        PlaneGrid &out = _grids[(_current + s + 1) % 2];
+        fillGhostColumns<Boundary>(in, rowBegin, rowEnd);
+        if (thread == 0) {
+          fillGhostRows<Boundary>(in);
+        }
+        _pool.barrier();
+        for (int t = begin; t < end; t++) {
+          const Tile &tile = _tiles[t];
+          for (int y = tile.y0; y < tile.y1; y++) {
+            PlaneRow row = {in.rowA(y - 1), in.rowA(y),  in.rowA(y + 1), in.rowB(y - 1),
+                            in.rowB(y),     in.rowB(y + 1), out.rowA(y), out.rowB(y)};
+            _kernel(row.at(tile.x0), tile.x1 - tile.x0, _config.simArgs);
+          }
+        }
+        _pool.barrier();
+      }
+    });
+    _current = (_current + steps) % 2;
+  }
+
+private:
+  PlaneKernel _kernel;
+  ThreadPool _pool;
+  PlaneGrid _grids[2];
+  int _current = 0;
+  std::vector<Tile> _tiles;
+  std::string _name;
+};
+
+} // namespace
+
+std::unique_ptr<Engine> makeSoaEngine(const Config &config, const EngineOptions &options) {
+  return withBoundary(config.boundary, [&](auto boundary) -> std::unique_ptr<Engine> {
+    return std::make_unique<SoaEngine<decltype(boundary)>>(config, options);
+  });
+}
@@ -0,0 +1,212 @@
+// Sparse engine: SoA planes like the soa engine, but only tiles with activity
+// nearby are stepped. Many presets leave large areas sitting at the trivial
+// steady state A = 1, B = 0 for thousands of steps; recomputing them is waste.
+//
+// After stepping a tile we record the largest change of A or B in it. A tile
+// whose change stays under the threshold is quiescent. It is stepped again
+// only while it or one of its 8 neighbours is active: the stencil reaches one
+// cell per step, so activity at a neighbour's edge shows up in this tile's
+// border on the next step, wakes it, and it carries on from there.
+//
+// Measuring the change costs about as much as a third of the update itself,
+// so it is only done every kCheckInterval steps; in between, tiles keep the
+// state they were given at the last check. That is only sound while activity
+// cannot cross a whole tile between checks, so no tile is narrower or
+// shorter than kCheckInterval cells (unless the grid is).
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include "Boundary.hpp"
+#include "Engine.hpp"
+#include "Kernels.hpp"
+#include "Planes.hpp"
+#include "ThreadPool.hpp"
+#include "Tiling.hpp"
+
+namespace {
+
+constexpr int kCheckInterval = 8;
+
+template <class Boundary>
+class SparseEngine : public Engine {
+public:
+  SparseEngine(const Config &config, const EngineOptions &options)
+      : Engine(config), _kernel(planeKernel(options.isa)), _pool(options.threads),
+        _threshold(options.sparseThreshold),
+        _grids{PlaneGrid(config.width, config.height, 1),
+               PlaneGrid(config.width, config.height, 1)} {
+    // Small tiles: the finer the grid of tiles, the more of it can sleep.
+    int tileWidth = options.tileWidth > 0 ? options.tileWidth : 64;
+    int tileHeight = options.tileHeight > 0 ? options.tileHeight : 64;
+    tileWidth = std::min(std::max(tileWidth, kCheckInterval), config.width);
+    tileHeight = std::min(std::max(tileHeight, kCheckInterval), config.height);
+    // As many tiles as fit whole, sharing the remainder, so the last one is
+    // not a narrow strip.
+    _tilesX = std::max(1, config.width / tileWidth);
+    _tilesY = std::max(1, config.height / tileHeight);
+    for (int ty = 0; ty < _tilesY; ty++) {
+      for (int tx = 0; tx < _tilesX; tx++) {
+        Tile tile;
+        splitRange(config.width, _tilesX, tx, tile.x0, tile.x1);
+        splitRange(config.height, _tilesY, ty, tile.y0, tile.y1);
+        _tiles.push_back(tile);
+      }
+    }
+    // Everything starts active: the seed noise is spread over the whole grid.
+    _active.assign(_tiles.size(), 1);
+    _stepped.assign(_tiles.size(), 1);
+    _stepNow.assign(_tiles.size(), 1);
+    _name = "sparse/" + std::string(Boundary::name) + "/" + isaName(resolveIsa(options.isa)) +
+            "/" + std::to_string(_pool.size()) + "t/" + std::to_string(tileWidth) + "x" +
+            std::to_string(tileHeight);
+  }
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(const Grid &grid) override {
+    _grids[_current].load(grid);
+    std::fill(_active.begin(), _active.end(), 1);
+    std::fill(_stepped.begin(), _stepped.end(), 1);
+  }
+  StateView stateView() const override { return _grids[_current].view(); }
+  size_t stateBytes() const override { return _grids[0].bytes() + _grids[1].bytes(); }
+
+  std::string stats() const override {
+    char text[128];
+    double total = double(_totalSteps) * _tiles.size();
+    snprintf(text, sizeof(text), "Active tiles %.1f%% on average, %.1f%% in the last step",
+             total > 0 ? 100.0 * _steppedTiles / total : 100.0, 100.0 * _lastActiveFraction);
+    return text;
+  }
+
+  void step(int steps) override {
+    const int threads = _pool.size();
+    const int tileCount = static_cast<int>(_tiles.size());
+    _pool.run([&](int thread) {
+      int rowBegin, rowEnd;
+      splitRange(_config.height, threads, thread, rowBegin, rowEnd);
+      for (int s = 0; s < steps; s++) {
+        PlaneGrid &in = _grids[(_current + s) % 2];
+        PlaneGrid &out = _grids[(_current + s + 1) % 2];
+        fillGhostColumns<Boundary>(in, rowBegin, rowEnd);
+        if (thread == 0) {
+          fillGhostRows<Boundary>(in);
+          scheduleTiles();
+          _nextTile.store(0, std::memory_order_relaxed);
+        }
+        _pool.barrier();
+        // Tiles are handed out dynamically: the active ones cluster.
+        for (int t = _nextTile.fetch_add(1); t < tileCount; t = _nextTile.fetch_add(1)) {
+          if (_stepNow[t] && _checkNow) {
+            _active[t] = stepTile<true>(in, out, _tiles[t]);
+          } else if (_stepNow[t]) {
+            stepTile<false>(in, out, _tiles[t]);
+          } else if (_stepped[t]) {
+            // First step asleep: bring the other buffer up to date once, after
+            // which both hold the same values and the tile can be left alone.
+            copyTile(in, out, _tiles[t]);
+            _active[t] = 0;
+          }
+        }
+        _pool.barrier();
+      }
+    });
+    _current = (_current + steps) % 2;
+  }
+
+private:
+  PlaneKernel _kernel;
+  ThreadPool _pool;
+  float _threshold;
+  PlaneGrid _grids[2];
+  int _current = 0;
+  std::vector<Tile> _tiles;
+  int _tilesX, _tilesY;
+  std::vector<char> _active;  // change above threshold when last stepped
+  std::vector<char> _stepped; // stepped in the previous step
+  std::vector<char> _stepNow;
+  bool _checkNow = true;
+  std::atomic<int> _nextTile{0};
+  long long _totalSteps = 0;
+  long long _steppedTiles = 0;
+  double _lastActiveFraction = 1.0;
+  std::string _name;
+
+  // Marks the tiles to step: active ones and their neighbours. Runs on one
+  // thread between barriers.
+  void scheduleTiles() {
+    std::swap(_stepped, _stepNow);
+    int count = 0;
+    for (int ty = 0; ty < _tilesY; ty++) {
+      for (int tx = 0; tx < _tilesX; tx++) {
+        char wake = 0;
+        for (int dy = -1; dy <= 1 && !wake; dy++) {
+          for (int dx = -1; dx <= 1 && !wake; dx++) {
+            int nx = tx + dx;
+            int ny = ty + dy;
+            if constexpr (std::is_same_v<Boundary, PeriodicBoundary>) {
+              nx = (nx + _tilesX) % _tilesX;
+              ny = (ny + _tilesY) % _tilesY;
+            } else if (nx < 0 || nx >= _tilesX || ny < 0 || ny >= _tilesY) {
+              continue;
+            }
+            wake = _active[ny * _tilesX + nx];
+          }
+        }
+        _stepNow[ty * _tilesX + tx] = wake;
+        count += wake;
+      }
+    }
+    _checkNow = _totalSteps % kCheckInterval == 0;
+    _totalSteps++;
+    _steppedTiles += count;
+    _lastActiveFraction = double(count) / _tiles.size();
+  }
+
+  // Steps one tile and, if asked to check, reports whether any cell changed
+  // by more than the threshold.
+  template <bool Check>
+  bool stepTile(const PlaneGrid &in, PlaneGrid &out, const Tile &tile) {
+    const int width = tile.x1 - tile.x0;
+    int changed = 0;
+    for (int y = tile.y0; y < tile.y1; y++) {
+      PlaneRow row = {in.rowA(y - 1), in.rowA(y),  in.rowA(y + 1), in.rowB(y - 1),
+                      in.rowB(y),     in.rowB(y + 1), out.rowA(y), out.rowB(y)};
+      row = row.at(tile.x0);
+      _kernel(row, width, _config.simArgs);
+      if constexpr (Check) {
+        changed |= rowChanged(row.aMid, row.aOut, width, _threshold);
+        changed |= rowChanged(row.bMid, row.bOut, width, _threshold);
+      }
+    }
+    return changed;
+  }
+
+  // An integer OR reduction so the compiler vectorizes it; a float max
+  // reduction would stay scalar without -ffast-math.
+  static int rowChanged(const float *__restrict before, const float *__restrict after,
+                        int count, float threshold) {
+    int changed = 0;
+    for (int x = 0; x < count; x++) {
+      changed |= std::fabs(after[x] - before[x]) > threshold;
+    }
+    return changed;
+  }
+
+  static void copyTile(const PlaneGrid &in, PlaneGrid &out, const Tile &tile) {
+    for (int y = tile.y0; y < tile.y1; y++) {
+      std::copy(in.rowA(y) + tile.x0, in.rowA(y) + tile.x1, out.rowA(y) + tile.x0);
+      std::copy(in.rowB(y) + tile.x0, in.rowB(y) + tile.x1, out.rowB(y) + tile.x0);
+    }
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Engine> makeSparseEngine(const Config &config, const EngineOptions &options) {
+  return withBoundary(config.boundary, [&](auto boundary) -> std::unique_ptr<Engine> {
+    return std::make_unique<SparseEngine<decltype(boundary)>>(config, options);
+  });
+}
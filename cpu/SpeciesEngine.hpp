@@ -0,0 +1,145 @@
+#pragma once
+// Engines on one plane per species (the model and expression engines): the
+// planes, the ghost cells and the threaded row loop. Subclasses provide the
+// update of one row and the Dirichlet wall value of each species.
+
+#include <string>
+#include "Boundary.hpp"
+#include "Engine.hpp"
+#include "Kernels.hpp"
+#include "Planes.hpp"
+#include "ThreadPool.hpp"
+
+// `species` planes laid out like PlaneGrid with one ghost cell, back to back.
+struct SpeciesPlanes {
+  int width = 0;
+  int height = 0;
+  int lead = 0;   // floats before interior cell 0 of a row
+  int stride = 0; // floats per row
+  size_t planeStride = 0;
+  AlignedFloats cells;
+
+  SpeciesPlanes() = default;
+  SpeciesPlanes(int w, int h, int species)
+      : width(w), height(h), lead(roundUpFloats(1)), stride(roundUpFloats(lead + w + 1)),
+        planeStride(size_t(stride) * (h + 2)), cells(planeStride * species, 0.0f) {}
+
+  float *row(int s, int y) { return cells.data() + s * planeStride + size_t(y + 1) * stride + lead; }
+  const float *row(int s, int y) const {
+    return cells.data() + s * planeStride + size_t(y + 1) * stride + lead;
+  }
+
+  size_t bytes() const { return cells.size() * sizeof(float); }
+};
+
+template <class Boundary>
+class SpeciesEngine : public Engine {
+public:
+  const char *name() const override { return _name.c_str(); }
+
+  // Species 0 and 1 from A and B, any others at their wall value.
+  void setState(const Grid &grid) override {
+    load(grid, [&](const float *cell, size_t, float *c) {
+      for (int s = 2; s < _species; s++) {
+        c[s] = _wall[s];
+      }
+      c[0] = cell[0];
+      c[1] = cell[1];
+    });
+  }
+
+  // Species 0 and 1 as A and B.
+  StateView stateView() const override {
+    const SpeciesPlanes &planes = _planes[_current];
+    return {planes.width, planes.height, planes.row(0, 0), planes.row(1, 0), 1, planes.stride};
+  }
+
+  size_t stateBytes() const override { return _planes[0].bytes() + _planes[1].bytes(); }
+
+  void step(int steps) override {
+    _pool.run([&](int thread) {
+      int rowBegin, rowEnd;
+      splitRange(_config.height, _pool.size(), thread, rowBegin, rowEnd);
+      for (int s = 0; s < steps; s++) {
+        SpeciesPlanes &in = _planes[(_current + s) % 2];
+        SpeciesPlanes &out = _planes[(_current + s + 1) % 2];
+        fillGhostColumns(in, rowBegin, rowEnd);
+        if (thread == 0) {
+          fillGhostRows(in);
+        }
+        _pool.barrier();
+        ModelRow row = {};
+        for (int y = rowBegin; y < rowEnd; y++) {
+          for (int c = 0; c < _species; c++) {
+            row.up[c] = in.row(c, y - 1);
+            row.mid[c] = in.row(c, y);
+            row.down[c] = in.row(c, y + 1);
+            row.out[c] = out.row(c, y);
+          }
+          stepRow(row, _config.width);
+        }
+        _pool.barrier();
+      }
+    });
+    _current = (_current + steps) % 2;
+  }
+
+protected:
+  // Walls default to A = 1, B = 0 like the other engines, and 0 for more species.
+  SpeciesEngine(const Config &config, const EngineOptions &options, int species)
+      : Engine(config), _species(species), _pool(options.threads),
+        _planes{SpeciesPlanes(config.width, config.height, species),
+                SpeciesPlanes(config.width, config.height, species)} {
+    _wall[0] = fixedA<Boundary>();
+    _wall[1] = fixedB<Boundary>();
+  }
+
+  // Steps one row of `count` cells; called from every pool thread.
+  virtual void stepRow(const ModelRow &row, int count) = 0;
+
+  // Sets every cell from fn(grid cell, cell index, species values).
+  template <class Fn>
+  void load(const Grid &grid, Fn &&fn) {
+    SpeciesPlanes &planes = _planes[_current];
+    for (int y = 0; y < grid.height; y++) {
+      const float *src = grid.row(y);
+      for (int x = 0; x < grid.width; x++) {
+        float c[kMaxSpecies] = {};
+        fn(src + 2 * x, size_t(y) * grid.width + x, c);
+        for (int s = 0; s < _species; s++) {
+          planes.row(s, y)[x] = c[s];
+        }
+      }
+    }
+  }
+
+  const int _species;
+  ThreadPool _pool;
+  SpeciesPlanes _planes[2];
+  int _current = 0;
+  float _wall[kMaxSpecies] = {}; // Dirichlet wall value of each species
+  std::string _name;
+
+private:
+  void fillGhostColumns(SpeciesPlanes &planes, int y0, int y1) const {
+    for (int s = 0; s < _species; s++) {
+      for (int y = y0; y < y1; y++) {
+        fillPlaneGhostColumns<Boundary>(planes.row(s, y), planes.width, 1, _wall[s]);
+      }
+    }
+  }
+
+  void fillGhostRows(SpeciesPlanes &planes) const {
+    const int h = planes.height;
+    for (int s = 0; s < _species; s++) {
+      for (int dstY : {-1, h}) {
+        int srcY = 0;
+        if constexpr (!Boundary::fixed) {
+          srcY = Boundary::source(dstY, h);
+        }
+        fillPlaneGhostRow<Boundary>(planes.row(s, dstY), planes.row(s, srcY), planes.width, 1,
+                                    _wall[s]);
+      }
+    }
+  }
+};
@@ -0,0 +1,393 @@
+// Spectral engine: diffusion is solved exactly in Fourier space and only the
+// reaction is stepped explicitly, so the step size is no longer held under
+// the diffusion limit of the explicit engines (about 0.25 / diffA).
+//
+// The state is kept as the 2D transforms of A and B. The linear operator is
+// the Fourier symbol of the same 5-point laplacian the other engines use,
+//   L(kx, ky) = D * (2 cos(2 pi kx / W) + 2 cos(2 pi ky / H) - 4),
+// so this integrates the same semi-discrete system, just with a different
+// time discretisation. Periodic boundaries only.
+//
+//   etdrk4  Cox-Matthews exponential time differencing, 4th order, with the
+//           Kassam-Trefethen contour integrals for the coefficients.
+//           Four reaction evaluations (two FFTs each) per step.
+//   imex    semi-implicit Euler: reaction explicit, diffusion backward
+//           Euler. One reaction evaluation per step, first order.
+//
+// Either way the reaction is explicit, so the step is held under its limit
+// (implicitTimeStep()). Each step clamps the state it starts from to [0, 1]
+// in physical space, as sim_main does, which costs one more forward
+// transform per step.
+//
+// A and B are real, so one complex transform carries both: z = A + iB, and
+// the two spectra are separated again with the conjugate symmetry
+// A^(k) = (Z(k) + conj Z(-k)) / 2,  B^(k) = (Z(k) - conj Z(-k)) / 2i.
+
+#include <algorithm>
+#include <cmath>
+#include "Engine.hpp"
+#include "Fft.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+// Rows or columns transformed together, so the butterflies run over 32
+// sequences at once (256-byte runs of the packed scratch).
+constexpr int kBlock = 32;
+
+enum class Scheme { Etdrk4, Imex };
+
+// Per-mode step coefficients of one species.
+struct Coefficients {
+  std::vector<float> e, e2, q, f1, f2, f3;
+
+  void resize(size_t n) {
+    for (std::vector<float> *v : {&e, &e2, &q, &f1, &f2, &f3}) {
+      v->resize(n);
+    }
+  }
+};
+
+// A pair of spectra, A and B.
+struct Spectra {
+  std::vector<Complex> a, b;
+
+  void resize(size_t n) {
+    a.resize(n);
+    b.resize(n);
+  }
+};
+
+// ETDRK4 coefficients for one mode with linear rate `l` and step `h`. The
+// phi-functions cancel catastrophically near hl = 0, so they are averaged
+// over a circle of radius 1 around hl in the complex plane instead.
+void etdrk4Coefficients(double h, double l, Coefficients &c, size_t i) {
+  constexpr int kContourPoints = 32;
+  std::complex<double> q = 0, f1 = 0, f2 = 0, f3 = 0;
+  for (int j = 0; j < kContourPoints; j++) {
+    std::complex<double> r = h * l + std::polar(1.0, 2.0 * M_PI * (j + 0.5) / kContourPoints);
+    std::complex<double> er = std::exp(r);
+    std::complex<double> r3 = r * r * r;
+    q += (std::exp(r / 2.0) - 1.0) / r;
+    f1 += (-4.0 - r + er * (4.0 - 3.0 * r + r * r)) / r3;
+    f2 += (2.0 + r + er * (r - 2.0)) / r3;
+    f3 += (-4.0 - 3.0 * r - r * r + er * (4.0 - r)) / r3;
+  }
+  c.e[i] = float(std::exp(h * l));
+  c.e2[i] = float(std::exp(h * l / 2.0));
+  c.q[i] = float(h * q.real() / kContourPoints);
+  c.f1[i] = float(h * f1.real() / kContourPoints);
+  c.f2[i] = float(h * f2.real() / kContourPoints);
+  c.f3[i] = float(h * f3.real() / kContourPoints);
+}
+
+// Semi-implicit Euler: v' = (v + h N) / (1 - h l), stored as e = 1 / (1 - h l)
+// and q = h / (1 - h l).
+void imexCoefficients(double h, double l, Coefficients &c, size_t i) {
+  c.e[i] = float(1.0 / (1.0 - h * l));
+  c.q[i] = float(h / (1.0 - h * l));
+}
+
+class SpectralEngine : public Engine {
+public:
+  SpectralEngine(const Config &config, const EngineOptions &options, Scheme scheme)
+      : Engine(config), _scheme(scheme), _width(config.width), _height(config.height),
+        _fftX(config.width), _fftY(config.height), _pool(options.threads) {
+    const size_t n = size_t(_width) * _height;
+    _config.simArgs.timeStep = implicitTimeStep(config, options);
+    for (Spectra *s : {&_v, &_nv}) {
+      s->resize(n);
+    }
+    if (scheme == Scheme::Etdrk4) {
+      for (Spectra *s : {&_a, &_c, &_na, &_nb}) {
+        s->resize(n);
+      }
+    }
+    _z.resize(n);
+    _zState.resize(n);
+    _scratch.resize(_pool.size());
+    for (std::vector<Complex> &scratch : _scratch) {
+      scratch.resize(size_t(std::max(_width, _height)) * kBlock);
+    }
+    _snapshot = Grid(_width, _height);
+    computeCoefficients();
+    char dt[32];
+    snprintf(dt, sizeof(dt), "%g", _config.simArgs.timeStep);
+    _name = std::string("spectral/") + (scheme == Scheme::Etdrk4 ? "etdrk4" : "imex") +
+            "/dt=" + dt + "/" + std::to_string(_pool.size()) + "t";
+  }
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(const Grid &grid) override {
+    _pool.run([&](int thread) {
+      int begin, end;
+      splitRange(_height, _pool.size(), thread, begin, end);
+      for (int y = begin; y < end; y++) {
+        const float *src = grid.row(y);
+        Complex *z = _z.data() + size_t(y) * _width;
+        for (int x = 0; x < _width; x++) {
+          z[x] = Complex(src[2 * x], src[2 * x + 1]);
+        }
+      }
+      _pool.barrier();
+      transform2d(_z.data(), false, thread);
+      unpack(_z, _v, thread);
+      physical(thread);
+    });
+  }
+
+  StateView stateView() const override { return _snapshot.view(); }
+
+  size_t stateBytes() const override {
+    size_t spectra = _v.a.size() * (_scheme == Scheme::Etdrk4 ? 6 : 2);
+    size_t coefficients = _coefA.e.size() * (_scheme == Scheme::Etdrk4 ? 12 : 4);
+    return (spectra + _z.size() + _zState.size()) * sizeof(Complex) + coefficients * sizeof(float) +
+           _snapshot.bytes();
+  }
+
+  void step(int steps) override {
+    _pool.run([&](int thread) {
+      for (int s = 0; s < steps; s++) {
+        if (_scheme == Scheme::Etdrk4) {
+          stepEtdrk4(thread);
+        } else {
+          stepImex(thread);
+        }
+      }
+      physical(thread);
+    });
+  }
+
+private:
+  Scheme _scheme;
+  int _width, _height;
+  Fft _fftX, _fftY;
+  ThreadPool _pool;
+  Coefficients _coefA, _coefB;
+  Spectra _v;           // current state
+  Spectra _nv;          // reaction at v
+  Spectra _a, _c;       // ETDRK4 stages (b is kept in _c until c replaces it)
+  Spectra _na, _nb;     // reaction at the stages
+  std::vector<Complex> _z; // packed physical / transform buffer
+  std::vector<Complex> _zState; // clamped state while _z holds the reaction
+  std::vector<std::vector<Complex>> _scratch; // one per thread
+  Grid _snapshot;       // physical state after the last step() or setState()
+  std::string _name;
+
+  void computeCoefficients() {
+    const size_t n = size_t(_width) * _height;
+    const int coefficientCount = _scheme == Scheme::Etdrk4 ? 6 : 2;
+    _coefA.resize(n);
+    _coefB.resize(n);
+    if (coefficientCount == 2) {
+      for (Coefficients *c : {&_coefA, &_coefB}) {
+        for (std::vector<float> *v : {&c->e2, &c->f1, &c->f2, &c->f3}) {
+          v->clear();
+          v->shrink_to_fit();
+        }
+      }
+    }
+    std::vector<double> symbolX(_width), symbolY(_height);
+    for (int k = 0; k < _width; k++) {
+      symbolX[k] = 2.0 * std::cos(2.0 * M_PI * k / _width) - 2.0;
+    }
+    for (int k = 0; k < _height; k++) {
+      symbolY[k] = 2.0 * std::cos(2.0 * M_PI * k / _height) - 2.0;
+    }
+    const double h = _config.simArgs.timeStep;
+    const double diffA = _config.simArgs.diffA;
+    const double diffB = _config.simArgs.diffB;
+    // The symbol is even in kx and ky: compute one quadrant, mirror the rest.
+    _pool.run([&](int thread) {
+      int begin, end;
+      splitRange(_height / 2 + 1, _pool.size(), thread, begin, end);
+      for (int ky = begin; ky < end; ky++) {
+        for (int kx = 0; kx <= _width / 2; kx++) {
+          const double lap = symbolX[kx] + symbolY[ky];
+          const size_t i = size_t(ky) * _width + kx;
+          if (_scheme == Scheme::Etdrk4) {
+            etdrk4Coefficients(h, diffA * lap, _coefA, i);
+            etdrk4Coefficients(h, diffB * lap, _coefB, i);
+          } else {
+            imexCoefficients(h, diffA * lap, _coefA, i);
+            imexCoefficients(h, diffB * lap, _coefB, i);
+          }
+        }
+      }
+    });
+    for (Coefficients *c : {&_coefA, &_coefB}) {
+      for (std::vector<float> *v : {&c->e, &c->e2, &c->q, &c->f1, &c->f2, &c->f3}) {
+        if (v->empty()) {
+          continue;
+        }
+        for (int ky = 0; ky < _height; ky++) {
+          const int sy = std::min(ky, _height - ky);
+          for (int kx = 0; kx < _width; kx++) {
+            const int sx = std::min(kx, _width - kx);
+            (*v)[size_t(ky) * _width + kx] = (*v)[size_t(sy) * _width + sx];
+          }
+        }
+      }
+    }
+  }
+
+  // Forward or inverse 2D transform of `data`: blocks of rows, then blocks
+  // of columns. Called by every thread of the pool.
+  void transform2d(Complex *data, bool inverse, int thread) {
+    const int threads = _pool.size();
+    Complex *scratch = _scratch[thread].data();
+    int begin, end;
+    splitRange((_height + kBlock - 1) / kBlock, threads, thread, begin, end);
+    for (int block = begin; block < end; block++) {
+      const int y0 = block * kBlock;
+      const int count = std::min(kBlock, _height - y0);
+      Complex *rows = data + size_t(y0) * _width;
+      inverse ? _fftX.inverse(rows, count, 1, _width, scratch)
+              : _fftX.forward(rows, count, 1, _width, scratch);
+    }
+    _pool.barrier();
+    splitRange((_width + kBlock - 1) / kBlock, threads, thread, begin, end);
+    for (int block = begin; block < end; block++) {
+      const int x0 = block * kBlock;
+      const int count = std::min(kBlock, _width - x0);
+      inverse ? _fftY.inverse(data + x0, count, _width, 1, scratch)
+              : _fftY.forward(data + x0, count, _width, 1, scratch);
+    }
+    _pool.barrier();
+  }
+
+  // Splits the transform in z into the spectra of its real and imaginary
+  // parts. Ends with a barrier, so z may be overwritten afterwards.
+  void unpack(const std::vector<Complex> &z, Spectra &out, int thread) {
+    int begin, end;
+    splitRange(_height, _pool.size(), thread, begin, end);
+    for (int ky = begin; ky < end; ky++) {
+      const int my = ky == 0 ? 0 : _height - ky;
+      for (int kx = 0; kx < _width; kx++) {
+        const int mx = kx == 0 ? 0 : _width - kx;
+        const Complex zk = z[size_t(ky) * _width + kx];
+        const Complex zm = std::conj(z[size_t(my) * _width + mx]);
+        const size_t i = size_t(ky) * _width + kx;
+        out.a[i] = 0.5f * (zk + zm);
+        const Complex d = zk - zm; // B^ = d / 2i = -i d / 2
+        out.b[i] = Complex(0.5f * d.imag(), -0.5f * d.real());
+      }
+    }
+    _pool.barrier();
+  }
+
+  // Reaction terms of the state with spectra `in`, returned as spectra. With
+  // clampState, `in` is first clamped to [0, 1] as sim_main clamps after
+  // every step, at the cost of one more forward transform. Each step clamps
+  // the state it starts from; physical() clamps the snapshot.
+  void reaction(Spectra &in, Spectra &out, int thread, bool clampState = false) {
+    int begin, end;
+    splitRange(_height, _pool.size(), thread, begin, end);
+    const size_t first = size_t(begin) * _width;
+    const size_t last = size_t(end) * _width;
+    for (size_t i = first; i < last; i++) {
+      _z[i] = in.a[i] + Complex(-in.b[i].imag(), in.b[i].real()); // A^ + i B^
+    }
+    _pool.barrier();
+    transform2d(_z.data(), true, thread);
+    const float scale = 1.0f / (float(_width) * _height);
+    const float feed = _config.simArgs.feed;
+    const float feedKill = _config.simArgs.feed + _config.simArgs.kill;
+    for (size_t i = first; i < last; i++) {
+      float a = _z[i].real() * scale;
+      float b = _z[i].imag() * scale;
+      if (clampState) {
+        a = std::clamp(a, 0.0f, 1.0f);
+        b = std::clamp(b, 0.0f, 1.0f);
+        _zState[i] = Complex(a, b);
+      }
+      const float r = a * b * b;
+      _z[i] = Complex(feed * (1.0f - a) - r, r - feedKill * b);
+    }
+    _pool.barrier();
+    if (clampState) {
+      transform2d(_zState.data(), false, thread);
+      unpack(_zState, in, thread);
+    }
+    transform2d(_z.data(), false, thread);
+    unpack(_z, out, thread);
+  }
+
+  // Applies fn(i) to the modes of this thread's rows, then waits for all.
+  template <class Fn>
+  void forModes(int thread, Fn &&fn) {
+    int begin, end;
+    splitRange(_height, _pool.size(), thread, begin, end);
+    for (size_t i = size_t(begin) * _width; i < size_t(end) * _width; i++) {
+      fn(i);
+    }
+    _pool.barrier();
+  }
+
+  void stepEtdrk4(int thread) {
+    const Coefficients &ca = _coefA;
+    const Coefficients &cb = _coefB;
+    reaction(_v, _nv, thread, true);
+    forModes(thread, [&](size_t i) {
+      _a.a[i] = ca.e2[i] * _v.a[i] + ca.q[i] * _nv.a[i];
+      _a.b[i] = cb.e2[i] * _v.b[i] + cb.q[i] * _nv.b[i];
+    });
+    reaction(_a, _na, thread);
+    forModes(thread, [&](size_t i) {
+      _c.a[i] = ca.e2[i] * _v.a[i] + ca.q[i] * _na.a[i];
+      _c.b[i] = cb.e2[i] * _v.b[i] + cb.q[i] * _na.b[i];
+    });
+    reaction(_c, _nb, thread);
+    forModes(thread, [&](size_t i) {
+      _c.a[i] = ca.e2[i] * _a.a[i] + ca.q[i] * (2.0f * _nb.a[i] - _nv.a[i]);
+      _c.b[i] = cb.e2[i] * _a.b[i] + cb.q[i] * (2.0f * _nb.b[i] - _nv.b[i]);
+      _na.a[i] += _nb.a[i]; // only the sum of the middle stages is needed
+      _na.b[i] += _nb.b[i];
+    });
+    reaction(_c, _nb, thread);
+    forModes(thread, [&](size_t i) {
+      _v.a[i] = ca.e[i] * _v.a[i] + ca.f1[i] * _nv.a[i] + 2.0f * ca.f2[i] * _na.a[i] +
+                ca.f3[i] * _nb.a[i];
+      _v.b[i] = cb.e[i] * _v.b[i] + cb.f1[i] * _nv.b[i] + 2.0f * cb.f2[i] * _na.b[i] +
+                cb.f3[i] * _nb.b[i];
+    });
+  }
+
+  void stepImex(int thread) {
+    reaction(_v, _nv, thread, true);
+    forModes(thread, [&](size_t i) {
+      _v.a[i] = _coefA.e[i] * _v.a[i] + _coefA.q[i] * _nv.a[i];
+      _v.b[i] = _coefB.e[i] * _v.b[i] + _coefB.q[i] * _nv.b[i];
+    });
+  }
+
+  // Inverse transform of the current spectra into the snapshot, clamped like
+  // the state the next step starts from.
+  void physical(int thread) {
+    int begin, end;
+    splitRange(_height, _pool.size(), thread, begin, end);
+    for (size_t i = size_t(begin) * _width; i < size_t(end) * _width; i++) {
+      _z[i] = _v.a[i] + Complex(-_v.b[i].imag(), _v.b[i].real());
+    }
+    _pool.barrier();
+    transform2d(_z.data(), true, thread);
+    const float scale = 1.0f / (float(_width) * _height);
+    for (int y = begin; y < end; y++) {
+      const Complex *z = _z.data() + size_t(y) * _width;
+      float *dst = _snapshot.row(y);
+      for (int x = 0; x < _width; x++) {
+        dst[2 * x] = std::clamp(z[x].real() * scale, 0.0f, 1.0f);
+        dst[2 * x + 1] = std::clamp(z[x].imag() * scale, 0.0f, 1.0f);
+      }
+    }
+    _pool.barrier();
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Engine> makeSpectralEngine(const Config &config, const EngineOptions &options,
+                                           bool imex) {
+  return std::make_unique<SpectralEngine>(config, options, imex ? Scheme::Imex : Scheme::Etdrk4);
+}
@@ -0,0 +1,58 @@
+#pragma once
+// Generic stencil kernel, included by the kernel translation units only, with
+// the vector types of ModelKernels.hpp (declared in an anonymous namespace in
+// each of them, for the same linkage reason).
+
+#include "Kernels.hpp"
+
+// Steps cells [x, count) of `row` in whole vectors and returns the first cell
+// left over (fewer than V::width of them). The laplacian starts from the
+// centre term and adds each group of Stencil::group with one multiply-add,
+// the group's four taps summed pairwise; the reaction is the Gray-Scott
+// update of react() in KernelsAvx2.cpp, in the same operation order.
+template <class Stencil, class V>
+int stepStencilCells(const StencilRow &row, int x, int count, const SimArgs &args) {
+  constexpr int r = kMaxStencilRadius;
+  const V diffA(args.diffA);
+  const V diffB(args.diffB);
+  const V feed(args.feed);
+  const V minusFeedKill(-(args.feed + args.kill));
+  const V dt(args.timeStep);
+  const V centre(Stencil::centre);
+  const V zero(0.0f);
+  const V one(1.0f);
+  V weight[Stencil::groups];
+  for (int g = 0; g < Stencil::groups; g++) {
+    weight[g] = V(Stencil::group[g].weight);
+  }
+  // Row pointers in locals, which the compiler keeps in registers across the
+  // stores.
+  const float *a[2 * r + 1], *b[2 * r + 1];
+  for (int i = r - Stencil::radius; i <= r + Stencil::radius; i++) {
+    a[i] = row.a[i];
+    b[i] = row.b[i];
+  }
+  float *aOut = row.aOut;
+  float *bOut = row.bOut;
+  for (; x + V::width <= count; x += V::width) {
+    const V ca = V::load(a[r] + x);
+    const V cb = V::load(b[r] + x);
+    V lapA = centre * ca;
+    V lapB = centre * cb;
+    for (int g = 0; g < Stencil::groups; g++) {
+      const StencilTap *t = Stencil::group[g].taps;
+      V sumA = (V::load(a[r + t[0].dy] + x + t[0].dx) + V::load(a[r + t[1].dy] + x + t[1].dx)) +
+               (V::load(a[r + t[2].dy] + x + t[2].dx) + V::load(a[r + t[3].dy] + x + t[3].dx));
+      V sumB = (V::load(b[r + t[0].dy] + x + t[0].dx) + V::load(b[r + t[1].dy] + x + t[1].dx)) +
+               (V::load(b[r + t[2].dy] + x + t[2].dx) + V::load(b[r + t[3].dy] + x + t[3].dx));
+      lapA = madd(weight[g], sumA, lapA);
+      lapB = madd(weight[g], sumB, lapB);
+    }
+    const V reaction = ca * (cb * cb);
+    const V deltaA = madd(diffA, lapA, madd(feed, one - ca, zero - reaction));
+    const V deltaB = madd(diffB, lapB, madd(minusFeedKill, cb, reaction));
+    vmin(vmax(madd(dt, deltaA, ca), zero), one).store(aOut + x);
+    vmin(vmax(madd(dt, deltaB, cb), zero), one).store(bOut + x);
+  }
+  return x;
+}
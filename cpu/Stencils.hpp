@@ -0,0 +1,108 @@
+#pragma once
+// Laplacian stencils of the stencil engine, chosen by the pattern's
+// "stencil" key. Each is a type whose taps the generic kernel in
+// StencilKernels.hpp unrolls at compile time. Taps come in groups of four
+// that share a weight (the stencils are symmetric under quarter turns), so a
+// group costs three adds and one multiply-add per cell:
+//
+//   5-point    the [0 1 0; 1 -4 1; 0 1 0] of sim_main, second order with an
+//              anisotropic error term h^2/12 (d4/dx4 + d4/dy4)
+//   9-point    Patra and Karttunen's isotropic stencil, sides 2/3, corners
+//              1/6, centre -10/3: still second order, but the error term is
+//              a multiple of the bilaplacian and has no preferred direction
+//   4th-order  the fourth-order cross, 4/3 at distance one, -1/12 at
+//              distance two, centre -5
+//
+// A fourth-order stencil on the 13-point diamond (|dx| + |dy| <= 2) must put
+// zero weight on the diagonals, since their x^2 y^2 moment cannot cancel
+// otherwise, so the fourth-order cross is that stencil with its zeros
+// dropped.
+
+#include <algorithm>
+#include <string>
+#include "Config.hpp"
+
+enum class Stencil { FivePoint, NinePoint, FourthOrder };
+
+// Farthest tap from the centre along either axis, over all stencils.
+constexpr int kMaxStencilRadius = 2;
+
+struct StencilTap {
+  int dx, dy;
+};
+
+struct StencilGroup {
+  float weight;
+  StencilTap taps[4];
+};
+
+struct FivePointStencil {
+  static constexpr int radius = 1;
+  static constexpr int groups = 1;
+  static constexpr float centre = -4.0f;
+  // Up and down first: the same sums as the plane kernels, so the 5-point
+  // instantiation rounds like them.
+  static constexpr StencilGroup group[groups] = {{1.0f, {{0, -1}, {0, 1}, {-1, 0}, {1, 0}}}};
+};
+
+struct NinePointStencil {
+  static constexpr int radius = 1;
+  static constexpr int groups = 2;
+  static constexpr float centre = -10.0f / 3.0f;
+  static constexpr StencilGroup group[groups] = {
+      {2.0f / 3.0f, {{0, -1}, {0, 1}, {-1, 0}, {1, 0}}},
+      {1.0f / 6.0f, {{-1, -1}, {1, -1}, {-1, 1}, {1, 1}}}};
+};
+
+struct FourthOrderStencil {
+  static constexpr int radius = 2;
+  static constexpr int groups = 2;
+  static constexpr float centre = -5.0f;
+  static constexpr StencilGroup group[groups] = {
+      {4.0f / 3.0f, {{0, -1}, {0, 1}, {-1, 0}, {1, 0}}},
+      {-1.0f / 12.0f, {{0, -2}, {0, 2}, {-2, 0}, {2, 0}}}};
+};
+
+inline const char *stencilName(Stencil stencil) {
+  switch (stencil) {
+  case Stencil::NinePoint:
+    return "9-point";
+  case Stencil::FourthOrder:
+    return "4th-order";
+  default:
+    return "5-point";
+  }
+}
+
+// Parses "5-point", "9-point" or "4th-order". Returns false on anything else.
+inline bool parseStencil(const std::string &name, Stencil &stencil) {
+  for (Stencil s : {Stencil::FivePoint, Stencil::NinePoint, Stencil::FourthOrder}) {
+    if (name == stencilName(s)) {
+      stencil = s;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Taps of the stencil including the centre.
+inline int stencilTaps(Stencil stencil) { return stencil == Stencil::FivePoint ? 5 : 9; }
+
+// Largest |eigenvalue| of the stencil on a periodic grid, at the
+// checkerboard mode: 8 for the 5-point stencil, 16/3 for the 9-point one
+// and 32/3 for the fourth-order cross.
+inline float stencilSpectralRadius(Stencil stencil) {
+  switch (stencil) {
+  case Stencil::NinePoint:
+    return 16.0f / 3.0f;
+  case Stencil::FourthOrder:
+    return 32.0f / 3.0f;
+  default:
+    return 8.0f;
+  }
+}
+
+// explicitStepLimit() of Kernels.hpp for any stencil.
+inline float stencilStepLimit(Stencil stencil, const SimArgs &args, float stabilityRadius) {
+  return stabilityRadius / (stencilSpectralRadius(stencil) * std::max(args.diffA, args.diffB));
+}
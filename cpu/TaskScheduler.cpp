@@ -0,0 +1,98 @@
+#include "TaskScheduler.hpp"
+
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define RD_CPU_RELAX() _mm_pause()
+#else
+#define RD_CPU_RELAX() std::this_thread::yield()
+#endif
+
+namespace {
+
+// Index of the calling thread in the pool of the running scheduler.
+thread_local int tWorker = 0;
+
+// Spins before yielding, as Barrier::wait does.
+const int kSpinLimit = 4096;
+
+} // namespace
+
+TaskScheduler::TaskScheduler(ThreadPool &pool) : _pool(pool) {
+  for (int i = 0; i < pool.size(); i++) {
+    _deques.push_back(std::make_unique<Deque>());
+  }
+}
+
+void TaskScheduler::run(const std::function<void()> &root) {
+  _finished.store(false, std::memory_order_relaxed);
+  _pool.run([&](int thread) {
+    tWorker = thread;
+    if (thread == 0) {
+      root();
+      _finished.store(true, std::memory_order_release);
+      return;
+    }
+    int spins = 0;
+    while (!_finished.load(std::memory_order_acquire)) {
+      if (Task *task = steal()) {
+        task->call();
+        spins = 0;
+      } else if (spins < kSpinLimit) {
+        RD_CPU_RELAX();
+        spins++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+}
+
+void TaskScheduler::push(Task *task) {
+  Deque &deque = *_deques[tWorker];
+  std::lock_guard<std::mutex> lock(deque.mutex);
+  deque.tasks.push_back(task);
+}
+
+bool TaskScheduler::popBack(Task *task) {
+  Deque &deque = *_deques[tWorker];
+  std::lock_guard<std::mutex> lock(deque.mutex);
+  // Everything pushed after `task` has been popped or joined again, so the
+  // back is `task` unless a thief took it, and with it the whole deque.
+  if (deque.tasks.empty() || deque.tasks.back() != task) {
+    return false;
+  }
+  deque.tasks.pop_back();
+  return true;
+}
+
+TaskScheduler::Task *TaskScheduler::steal() {
+  const int threads = static_cast<int>(_deques.size());
+  for (int i = 1; i < threads; i++) {
+    Deque &victim = *_deques[(tWorker + i) % threads];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      Task *task = victim.tasks.front();
+      victim.tasks.pop_front();
+      _steals.fetch_add(1, std::memory_order_relaxed);
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+void TaskScheduler::join(Task &task) {
+  int spins = 0;
+  while (!task.done.load(std::memory_order_acquire)) {
+    if (Task *other = steal()) {
+      other->call();
+      spins = 0;
+    } else if (spins < kSpinLimit) {
+      RD_CPU_RELAX();
+      spins++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
@@ -0,0 +1,85 @@
+#pragma once
+// Work-stealing fork-join scheduler on the threads of a ThreadPool, for
+// engines that split their work recursively instead of into one range per
+// thread. Every thread keeps a deque of the tasks it has spawned: it pushes
+// and pops at the back, so it runs its own work depth first, and idle
+// threads steal from the front, where a recursive split leaves the oldest
+// and largest pieces.
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+#include "ThreadPool.hpp"
+
+class TaskScheduler {
+public:
+  explicit TaskScheduler(ThreadPool &pool);
+
+  int size() const { return _pool.size(); }
+
+  // Runs root() on thread 0 while the other threads steal the tasks it
+  // spawns. Returns when root() has returned; parallel() joins every task
+  // it spawns, so nothing is left running by then.
+  void run(const std::function<void()> &root);
+
+  // Runs first() and second() concurrently and returns when both have
+  // finished. Only valid inside run(). second() is offered to the other
+  // threads; if none has taken it by the time first() returns, the caller
+  // runs it itself, and if one has, the caller runs stolen work while it
+  // waits.
+  template <class First, class Second>
+  void parallel(First &&first, Second &&second) {
+    Call<std::remove_reference_t<Second>> task(second);
+    push(&task);
+    first();
+    if (popBack(&task)) {
+      task.call();
+    } else {
+      join(task);
+    }
+  }
+
+  // Tasks taken from another thread's deque since the scheduler was created.
+  size_t steals() const { return _steals.load(std::memory_order_relaxed); }
+
+private:
+  struct Task {
+    virtual ~Task() = default;
+    virtual void call() = 0;
+    std::atomic<bool> done{false};
+  };
+
+  template <class F>
+  struct Call : Task {
+    explicit Call(F &f) : f(f) {}
+    void call() override {
+      f();
+      done.store(true, std::memory_order_release);
+    }
+    F &f;
+  };
+
+  // One cache line per deque, so pushes of neighbouring threads do not
+  // contend for it.
+  struct alignas(64) Deque {
+    std::mutex mutex;
+    std::deque<Task *> tasks;
+  };
+
+  ThreadPool &_pool;
+  std::vector<std::unique_ptr<Deque>> _deques;
+  std::atomic<bool> _finished{false};
+  std::atomic<size_t> _steals{0};
+
+  void push(Task *task);
+  // Pops the back of the calling thread's deque if it is `task`.
+  bool popBack(Task *task);
+  // Takes the front task of another thread's deque, nullptr if all are empty.
+  Task *steal();
+  void join(Task &task);
+};
@@ -0,0 +1,135 @@
+// Temporally blocked engine. Instead of sweeping the whole grid once per
+// step, each tile is copied together with a k-cell halo into a private
+// buffer, advanced k steps there while it is hot in cache, and written back
+// once. The halo shrinks by one cell per step, so the tile interior ends up
+// exactly as a step-by-step sweep would leave it; the price is recomputing
+// the halo cells that neighbouring tiles also compute.
+
+#include <array>
+#include "Engine.hpp"
+#include "Kernels.hpp"
+#include "ThreadPool.hpp"
+#include "Tiling.hpp"
+
+namespace {
+
+class TemporalEngine : public Engine {
+public:
+  TemporalEngine(const Config &config, const EngineOptions &options)
+      : Engine(config), _kernel(rowKernel(options.isa)), _pool(options.threads),
+        _grids{Grid(config.width, config.height), Grid(config.width, config.height)} {
+    int tileWidth = options.tileWidth;
+    int tileHeight = options.tileHeight;
+    _k = options.timeBlock;
+    autoTimeBlock(config.width, config.height, tileWidth, tileHeight, _k);
+    _tiles = makeTiles(config.width, config.height, tileWidth, tileHeight);
+    _scratch.resize(_pool.size());
+    size_t scratchCells = size_t(tileWidth + 2 * _k) * (tileHeight + 2 * _k);
+    for (auto &buffers : _scratch) {
+      buffers[0].resize(2 * scratchCells);
+      buffers[1].resize(2 * scratchCells);
+    }
+    _name = "temporal/" + std::string(isaName(resolveIsa(options.isa))) + "/" +
+            std::to_string(_pool.size()) + "t/" + std::to_string(tileWidth) + "x" +
+            std::to_string(tileHeight) + "/k" + std::to_string(_k);
+  }
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(const Grid &grid) override { _grids[_current] = grid; }
+  StateView stateView() const override { return _grids[_current].view(); }
+
+  size_t stateBytes() const override {
+    size_t bytes = _grids[0].bytes() + _grids[1].bytes();
+    for (const auto &buffers : _scratch) {
+      bytes += (buffers[0].size() + buffers[1].size()) * sizeof(float);
+    }
+    return bytes;
+  }
+
+  void step(int steps) override {
+    const int threads = _pool.size();
+    const int tileCount = static_cast<int>(_tiles.size());
+    _pool.run([&](int thread) {
+      int begin, end;
+      splitRange(tileCount, threads, thread, begin, end);
+      int current = _current;
+      for (int done = 0; done < steps;) {
+        int fused = std::min(_k, steps - done);
+        const Grid &in = _grids[current];
+        Grid &out = _grids[1 - current];
+        for (int t = begin; t < end; t++) {
+          stepTile(in, out, _tiles[t], fused, _scratch[thread]);
+        }
+        _pool.barrier();
+        current = 1 - current;
+        done += fused;
+      }
+    });
+    // Each pass of up to k steps lands in the other grid.
+    int passes = (steps + _k - 1) / _k;
+    _current = (_current + passes) % 2;
+  }
+
+private:
+  RowKernel _kernel;
+  ThreadPool _pool;
+  Grid _grids[2];
+  int _current = 0;
+  int _k;
+  std::vector<Tile> _tiles;
+  std::vector<std::array<std::vector<float>, 2>> _scratch;
+  std::string _name;
+
+  void stepTile(const Grid &in, Grid &out, const Tile &tile, int fused,
+                std::array<std::vector<float>, 2> &scratch) {
+    const int w = in.width;
+    const int h = in.height;
+    const int localWidth = tile.x1 - tile.x0 + 2 * fused;
+    const int localHeight = tile.y1 - tile.y0 + 2 * fused;
+    const int stride = 2 * localWidth;
+
+    // Load tile + halo, wrapping periodically.
+    float *src = scratch[0].data();
+    for (int ly = 0; ly < localHeight; ly++) {
+      int gy = ((tile.y0 - fused + ly) % h + h) % h;
+      const float *row = in.row(gy);
+      float *dst = src + size_t(ly) * stride;
+      // Copy in contiguous runs; only the runs that cross the grid edge wrap.
+      for (int lx = 0; lx < localWidth;) {
+        int gx = ((tile.x0 - fused + lx) % w + w) % w;
+        int run = std::min(localWidth - lx, w - gx);
+        std::copy(row + 2 * gx, row + 2 * (gx + run), dst + 2 * lx);
+        lx += run;
+      }
+    }
+
+    // Advance in cache. After step s the valid region has shrunk by s cells.
+    float *dst = scratch[1].data();
+    for (int s = 1; s <= fused; s++) {
+      for (int ly = s; ly < localHeight - s; ly++) {
+        const float *mid = src + size_t(ly) * stride + 2 * s;
+        kernel(mid - stride, mid, mid + stride, dst + size_t(ly) * stride + 2 * s,
+               localWidth - 2 * s);
+      }
+      std::swap(src, dst);
+    }
+
+    // Write back the interior.
+    const int tileWidth = tile.x1 - tile.x0;
+    for (int y = tile.y0; y < tile.y1; y++) {
+      const float *row = src + size_t(y - tile.y0 + fused) * stride + 2 * fused;
+      std::copy(row, row + 2 * tileWidth, out.row(y) + 2 * tile.x0);
+    }
+  }
+
+  void kernel(const float *up, const float *mid, const float *down, float *out, int count) {
+    _kernel(up, mid, down, out, count, _config.simArgs);
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Engine> makeTemporalEngine(const Config &config, const EngineOptions &options) {
+  return std::make_unique<TemporalEngine>(config, options);
+}
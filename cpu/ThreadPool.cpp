@@ -0,0 +1,87 @@
+#include "ThreadPool.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define RD_CPU_RELAX() _mm_pause()
+#else
+#define RD_CPU_RELAX() std::this_thread::yield()
+#endif
+
+void Barrier::wait() {
+  const int kSpinLimit = 4096;
+  unsigned generation = _generation.load(std::memory_order_acquire);
+  if (_waiting.fetch_add(1, std::memory_order_acq_rel) == _count - 1) {
+    // Last one in releases everybody.
+    _waiting.store(0, std::memory_order_relaxed);
+    _generation.fetch_add(1, std::memory_order_release);
+    return;
+  }
+  int spins = 0;
+  while (_generation.load(std::memory_order_acquire) == generation) {
+    if (spins < kSpinLimit) {
+      RD_CPU_RELAX();
+      spins++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+ThreadPool::ThreadPool(int threads)
+    : _size(threads > 0 ? threads : static_cast<int>(std::thread::hardware_concurrency())),
+      _barrier(_size > 0 ? _size : 1) {
+  if (_size < 1) {
+    _size = 1;
+  }
+  for (int i = 1; i < _size; i++) {
+    _workers.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _wake.notify_all();
+  for (std::thread &worker : _workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::run(const std::function<void(int)> &job) {
+  if (_size == 1) {
+    job(0);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _job = &job;
+    _pending = _size - 1;
+    _generation++;
+  }
+  _wake.notify_all();
+  job(0);
+  std::unique_lock<std::mutex> lock(_mutex);
+  _done.wait(lock, [this] { return _pending == 0; });
+  _job = nullptr;
+}
+
+void ThreadPool::workerLoop(int index) {
+  unsigned long seen = 0;
+  std::unique_lock<std::mutex> lock(_mutex);
+  for (;;) {
+    _wake.wait(lock, [&] { return _stop || _generation != seen; });
+    if (_stop) {
+      return;
+    }
+    seen = _generation;
+    const std::function<void(int)> *job = _job;
+    lock.unlock();
+    (*job)(index);
+    lock.lock();
+    if (--_pending == 0) {
+      _done.notify_one();
+    }
+  }
+}
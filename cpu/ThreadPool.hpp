@@ -0,0 +1,62 @@
+#pragma once
+// Persistent worker pool for the CPU engines. Threads are started once with
+// the engine and parked between jobs, so stepping never spawns threads.
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Reusable barrier for the threads of one ThreadPool::run. Spins briefly
+// before yielding, since the gap between steps is usually short.
+class Barrier {
+public:
+  explicit Barrier(int count) : _count(count) {}
+  void wait();
+
+private:
+  const int _count;
+  std::atomic<int> _waiting{0};
+  std::atomic<unsigned> _generation{0};
+};
+
+class ThreadPool {
+public:
+  // `threads` includes the calling thread; 0 means one per hardware thread.
+  explicit ThreadPool(int threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  int size() const { return _size; }
+
+  // Runs job(threadIndex) once on every thread, the caller being thread 0.
+  // Returns when all threads have finished.
+  void run(const std::function<void(int)> &job);
+
+  // Waits for every thread of the current run() to arrive.
+  void barrier() { _barrier.wait(); }
+
+private:
+  int _size;
+  std::vector<std::thread> _workers;
+  std::mutex _mutex;
+  std::condition_variable _wake;
+  std::condition_variable _done;
+  const std::function<void(int)> *_job = nullptr;
+  unsigned long _generation = 0;
+  int _pending = 0;
+  bool _stop = false;
+  Barrier _barrier;
+
+  void workerLoop(int index);
+};
+
+// Splits [0, count) into `parts` contiguous ranges and returns range `part`.
+inline void splitRange(int count, int parts, int part, int &begin, int &end) {
+  begin = static_cast<int>(static_cast<long long>(count) * part / parts);
+  end = static_cast<int>(static_cast<long long>(count) * (part + 1) / parts);
+}
@@ -0,0 +1,67 @@
+// Multi-threaded engine. The grid is cut into cache-sized tiles and every
+// thread of a persistent pool owns a contiguous run of them, so a thread keeps
+// touching the same memory from step to step. A barrier between steps stands
+// in for the texture swap in Renderer::draw.
+
+#include "Engine.hpp"
+#include "Kernels.hpp"
+#include "ThreadPool.hpp"
+#include "Tiling.hpp"
+
+namespace {
+
+class TiledEngine : public Engine {
+public:
+  TiledEngine(const Config &config, const EngineOptions &options)
+      : Engine(config), _kernel(rowKernel(options.isa)), _pool(options.threads),
+        _grids{Grid(config.width, config.height), Grid(config.width, config.height)} {
+    int tileWidth = options.tileWidth;
+    int tileHeight = options.tileHeight;
+    autoTileSize(config.width, config.height, _pool.size(), tileWidth, tileHeight);
+    _tiles = makeTiles(config.width, config.height, tileWidth, tileHeight);
+    _name = "tiled/" + std::string(isaName(resolveIsa(options.isa))) + "/" +
+            std::to_string(_pool.size()) + "t/" + std::to_string(tileWidth) + "x" +
+            std::to_string(tileHeight);
+  }
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(const Grid &grid) override { _grids[_current] = grid; }
+  StateView stateView() const override { return _grids[_current].view(); }
+  size_t stateBytes() const override { return _grids[0].bytes() + _grids[1].bytes(); }
+
+  void step(int steps) override {
+    const int threads = _pool.size();
+    const int tileCount = static_cast<int>(_tiles.size());
+    _pool.run([&](int thread) {
+      int begin, end;
+      splitRange(tileCount, threads, thread, begin, end);
+      for (int s = 0; s < steps; s++) {
+        const Grid &in = _grids[(_current + s) % 2];
+        Grid &out = _grids[(_current + s + 1) % 2];
+        for (int t = begin; t < end; t++) {
+          const Tile &tile = _tiles[t];
+          stepRegionPeriodic(in, out, tile.x0, tile.x1, tile.y0, tile.y1, _kernel,
+                             _config.simArgs);
+        }
+        // Nobody reads the next input before every tile of it is written.
+        _pool.barrier();
+      }
+    });
+    _current = (_current + steps) % 2;
+  }
+
+private:
+  RowKernel _kernel;
+  ThreadPool _pool;
+  Grid _grids[2];
+  int _current = 0;
+  std::vector<Tile> _tiles;
+  std::string _name;
+};
+
+} // namespace
+
+std::unique_ptr<Engine> makeTiledEngine(const Config &config, const EngineOptions &options) {
+  return std::make_unique<TiledEngine>(config, options);
+}
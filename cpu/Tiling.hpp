@@ -0,0 +1,68 @@
+#pragma once
+// Splitting the grid into rectangular tiles for the threaded engines.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "CacheInfo.hpp"
+
+struct Tile {
+  int x0, x1; // columns [x0, x1)
+  int y0, y1; // rows [y0, y1)
+};
+
+// Fills in any non-positive tile dimension. Tiles are sized so that one
+// tile's input and output (8 bytes per cell each) fit in the L2 cache, then
+// shrunk until there are a few tiles per thread to balance the load.
+inline void autoTileSize(int width, int height, int threads, int &tileWidth, int &tileHeight) {
+  const size_t bytesPerCell = 2 * 2 * sizeof(float);
+  const size_t l2 = cacheSize(2);
+  if (tileWidth <= 0) {
+    // Keep a handful of rows resident: the stencil streams rows top to bottom.
+    tileWidth = static_cast<int>(l2 / (8 * bytesPerCell));
+    tileWidth = std::max(16, tileWidth / 16 * 16);
+  }
+  tileWidth = std::min(tileWidth, width);
+  if (tileHeight <= 0) {
+    tileHeight = std::max(4, static_cast<int>(l2 / (bytesPerCell * tileWidth)));
+    int tilesX = (width + tileWidth - 1) / tileWidth;
+    int wantedTiles = 4 * std::max(1, threads);
+    int tilesY = std::max(1, (wantedTiles + tilesX - 1) / tilesX);
+    tileHeight = std::min(tileHeight, std::max(1, (height + tilesY - 1) / tilesY));
+  }
+  tileHeight = std::min(tileHeight, height);
+}
+
+// Temporal blocking: picks the number of fused steps `k` and the tile size
+// for any value left non-positive. A tile plus its k-cell halo is held twice
+// (ping-pong) in a private buffer that should stay within half of L2. Each
+// fused step recomputes part of the halo, so k is kept to about 1/16 of the
+// buffer side, which bounds the redundant work to roughly 30%.
+inline void autoTimeBlock(int width, int height, int &tileWidth, int &tileHeight, int &k) {
+  const size_t bytesPerCell = 2 * sizeof(float);
+  const size_t l2 = cacheSize(2);
+  int side = static_cast<int>(std::sqrt(double(l2) / 2 / (2 * bytesPerCell)));
+  side = std::max(32, side);
+  if (k <= 0) {
+    k = std::clamp(side / 16, 1, 32);
+  }
+  if (tileWidth <= 0) {
+    tileWidth = std::max(8, side - 2 * k);
+  }
+  if (tileHeight <= 0) {
+    tileHeight = std::max(8, side - 2 * k);
+  }
+  tileWidth = std::min(tileWidth, width);
+  tileHeight = std::min(tileHeight, height);
+}
+
+// Row-major list of tiles covering the grid.
+inline std::vector<Tile> makeTiles(int width, int height, int tileWidth, int tileHeight) {
+  std::vector<Tile> tiles;
+  for (int y = 0; y < height; y += tileHeight) {
+    for (int x = 0; x < width; x += tileWidth) {
+      tiles.push_back({x, std::min(x + tileWidth, width), y, std::min(y + tileHeight, height)});
+    }
+  }
+  return tiles;
+}
@@ -0,0 +1,268 @@
+// Cache-oblivious engine on SoA planes. Instead of sweeping the whole grid
+// once per step as soa (and Renderer::draw) does, the steps of one step()
+// call are cut recursively into space-time trapezoids, after Frigo and
+// Strumpen: a trapezoid wide enough for its height is cut along x or y into
+// two sides and a middle piece, a tall one in half in time, until the pieces
+// are small. Each level halves the working set, so some level fits each
+// cache, whatever its size, with nothing tuned to it. The two sides of a
+// space cut do not depend on each other (Pochoir's parallel cut), so they
+// run as tasks on the work-stealing scheduler.
+//
+// Every cell is still computed from its neighbours one step earlier by the
+// soa plane kernel, in two buffers by step parity, so the result matches soa
+// bit for bit. Cuts keep each piece's dependencies inside pieces that are
+// finished or its own, and a cell is not overwritten two steps later until
+// every cell that reads it has run. Periodic grids are cut as a torus: each
+// band of steps is an upright trapezoid that shrinks away from the edges,
+// followed by inverted ones that grow across them, with coordinates past
+// the edge wrapping.
+//
+// The gain depends on the steps per step() call and on the grid not fitting
+// in cache. On one core at 4096x4096 and 200 steps per call it runs at 1.5
+// times soa's cell rate with AVX-512 and 1.6 times with AVX2; at 1024x1024
+// and 2048x2048, where soa's sweep already stays cached, at 0.93 to 0.97.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <type_traits>
+#include "Boundary.hpp"
+#include "Engine.hpp"
+#include "Kernels.hpp"
+#include "Planes.hpp"
+#include "TaskScheduler.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+// Smallest extent along x and y a space cut leaves. They keep leaf rows long
+// enough for the vector kernels and the recursion overhead small; the cache
+// sizes play no part.
+constexpr int kLeafWidth = 1024;
+constexpr int kLeafHeight = 32;
+
+// Steps [t0, t1) of a step() call over, at step t, the cells
+// [lo[d] + dlo[d] (t - t0), hi[d] + dhi[d] (t - t0)) along x (d = 0) and
+// y (d = 1). Slopes are -1, 0 or 1, the reach of the 5-point stencil.
+struct Zoid {
+  int t0, t1;
+  int lo[2], hi[2];
+  int dlo[2], dhi[2];
+};
+
+template <class Boundary>
+class TrapezoidEngine : public Engine {
+public:
+  TrapezoidEngine(const Config &config, const EngineOptions &options)
+      : Engine(config), _kernel(planeKernel(options.isa)), _pool(options.threads),
+        _scheduler(_pool), _grids{PlaneGrid(config.width, config.height, 1),
+                                  PlaneGrid(config.width, config.height, 1)} {
+    if constexpr (Boundary::fixed) {
+      // Wall ghosts are constant, so both buffers get them once.
+      for (PlaneGrid &grid : _grids) {
+        fillGhostColumns<Boundary>(grid, 0, config.height);
+        fillGhostRows<Boundary>(grid);
+      }
+    }
+    _name = "trapezoid/" + std::string(Boundary::name) + "/" +
+            isaName(resolveIsa(options.isa)) + "/" + std::to_string(_pool.size()) + "t";
+  }
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setState(const Grid &grid) override { _grids[_current].load(grid); }
+  StateView stateView() const override { return _grids[_current].view(); }
+  size_t stateBytes() const override { return _grids[0].bytes() + _grids[1].bytes(); }
+
+  std::string stats() const override {
+    char stats[128];
+    snprintf(stats, sizeof(stats), "%zu leaves, %zu steals in the last step() call",
+             _leaves.load(), _steals);
+    return stats;
+  }
+
+  void step(int steps) override {
+    const int w = _config.width;
+    const int h = _config.height;
+    const size_t steals = _scheduler.steals();
+    _leaves = 0;
+    _scheduler.run([&] {
+      if constexpr (std::is_same_v<Boundary, PeriodicBoundary>) {
+        // A band may be at most half as tall as the grid is narrow, so the
+        // upright piece does not shrink past nothing.
+        const int band = std::max(1, std::min(w, h) / 2);
+        for (int t = 0; t < steps; t += band) {
+          const Zoid upright = {t, std::min(steps, t + band), {0, 0}, {w, h}, {1, 1}, {-1, -1}};
+          walk(upright);
+          const Zoid seamX = seam(upright, 0);
+          const Zoid seamY = seam(upright, 1);
+          _scheduler.parallel([&] { walk(seamX); }, [&] { walk(seamY); });
+          walk(seam(seamX, 1));
+        }
+      } else {
+        walk({0, steps, {0, 0}, {w, h}, {0, 0}, {0, 0}});
+      }
+    });
+    _steals = _scheduler.steals() - steals;
+    _current = (_current + steps) % 2;
+  }
+
+private:
+  PlaneKernel _kernel;
+  ThreadPool _pool;
+  TaskScheduler _scheduler;
+  PlaneGrid _grids[2];
+  int _current = 0;
+  std::atomic<size_t> _leaves{0};
+  size_t _steals = 0;
+  std::string _name;
+
+  // The inverted piece of an upright periodic band along d: it starts empty
+  // at the far edge and grows by one cell each way per step, across it.
+  static Zoid seam(Zoid zoid, int d) {
+    const int n = d == 0 ? zoid.hi[0] - zoid.lo[0] : zoid.hi[1] - zoid.lo[1];
+    zoid.lo[d] = zoid.hi[d] = zoid.lo[d] + n;
+    zoid.dlo[d] = -1;
+    zoid.dhi[d] = 1;
+    return zoid;
+  }
+
+  void walk(const Zoid &zoid) {
+    static constexpr int kLeaf[2] = {kLeafWidth, kLeafHeight};
+    const int height = zoid.t1 - zoid.t0;
+    // Cut the dimension with the most leaves' worth of room, if it is wide
+    // enough at both ends to leave two sides with room for their slopes.
+    int cut = -1;
+    int room = 1;
+    bool tooTall = false;
+    for (int d = 0; d < 2; d++) {
+      const int bottom = zoid.hi[d] - zoid.lo[d];
+      const int top = bottom + (zoid.dhi[d] - zoid.dlo[d]) * height;
+      if (std::max(bottom, top) < 2 * kLeaf[d]) {
+        continue;
+      }
+      if (std::min(bottom, top) < 2 * height) {
+        tooTall = true;
+      } else if (std::max(bottom, top) / kLeaf[d] > room) {
+        cut = d;
+        room = std::max(bottom, top) / kLeaf[d];
+      }
+    }
+    if (cut >= 0) {
+      spaceCut(zoid, cut);
+    } else if (tooTall && height > 1) {
+      const int half = height / 2;
+      Zoid lower = zoid;
+      Zoid upper = zoid;
+      lower.t1 = upper.t0 = zoid.t0 + half;
+      for (int d = 0; d < 2; d++) {
+        upper.lo[d] += zoid.dlo[d] * half;
+        upper.hi[d] += zoid.dhi[d] * half;
+      }
+      walk(lower);
+      walk(upper);
+    } else {
+      leaf(zoid);
+    }
+  }
+
+  // Cuts along d through the middle of the narrower end, with lines of
+  // slope -1 and 1 between the sides and the middle piece. A trapezoid that
+  // narrows upwards gives two upright sides, which run in parallel, and an
+  // inverted middle that fills the gap between them afterwards; one that
+  // widens gives an upright middle first and inverted sides after it.
+  void spaceCut(const Zoid &zoid, int d) {
+    const int height = zoid.t1 - zoid.t0;
+    const int bottom = zoid.hi[d] - zoid.lo[d];
+    const int top = bottom + (zoid.dhi[d] - zoid.dlo[d]) * height;
+    Zoid left = zoid;
+    Zoid middle = zoid;
+    Zoid right = zoid;
+    if (top <= bottom) {
+      const int m = zoid.lo[d] + zoid.dlo[d] * height + top / 2;
+      left.hi[d] = m;
+      left.dhi[d] = -1;
+      right.lo[d] = m;
+      right.dlo[d] = 1;
+      middle.lo[d] = middle.hi[d] = m;
+      middle.dlo[d] = -1;
+      middle.dhi[d] = 1;
+      _scheduler.parallel([&] { walk(left); }, [&] { walk(right); });
+      walk(middle);
+    } else {
+      const int m = zoid.lo[d] + bottom / 2;
+      middle.lo[d] = left.hi[d] = m - height;
+      middle.hi[d] = right.lo[d] = m + height;
+      middle.dlo[d] = left.dhi[d] = 1;
+      middle.dhi[d] = right.dlo[d] = -1;
+      walk(middle);
+      _scheduler.parallel([&] { walk(left); }, [&] { walk(right); });
+    }
+  }
+
+  // Steps the leaf row by row, one step at a time. Periodic coordinates may
+  // lie up to one grid past the edge; a row range that crosses it is stepped
+  // as two segments.
+  void leaf(const Zoid &zoid) {
+    const int w = _config.width;
+    const int h = _config.height;
+    for (int t = zoid.t0; t < zoid.t1; t++) {
+      const int k = t - zoid.t0;
+      PlaneGrid &in = _grids[(_current + t) % 2];
+      PlaneGrid &out = _grids[(_current + t + 1) % 2];
+      const int x0 = zoid.lo[0] + zoid.dlo[0] * k;
+      const int x1 = zoid.hi[0] + zoid.dhi[0] * k;
+      const int y0 = zoid.lo[1] + zoid.dlo[1] * k;
+      const int y1 = zoid.hi[1] + zoid.dhi[1] * k;
+      for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1;) {
+          const int end = std::min(x1, x < w ? w : 2 * w);
+          const int begin = x < w ? x : x - w;
+          stepSegment(in, out, y < h ? y : y - h, begin, begin + end - x);
+          x = end;
+        }
+      }
+    }
+    _leaves.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Steps cells [x0, x1) of row y. The ghost cells the segment reads are
+  // refreshed first: the cells they copy are at the same step, and no other
+  // piece reads or writes them until this one has moved on.
+  void stepSegment(PlaneGrid &in, PlaneGrid &out, int y, int x0, int x1) {
+    const int w = _config.width;
+    const int h = _config.height;
+    int up = y - 1;
+    int down = y + 1;
+    if constexpr (!Boundary::fixed) {
+      float *a = in.rowA(y);
+      float *b = in.rowB(y);
+      if (x0 == 0) {
+        a[-1] = a[Boundary::source(-1, w)];
+        b[-1] = b[Boundary::source(-1, w)];
+      }
+      if (x1 == w) {
+        a[w] = a[Boundary::source(w, w)];
+        b[w] = b[Boundary::source(w, w)];
+      }
+      // Rows above and below the grid are read where they come from.
+      if (y == 0) {
+        up = Boundary::source(-1, h);
+      }
+      if (y == h - 1) {
+        down = Boundary::source(h, h);
+      }
+    }
+    PlaneRow row = {in.rowA(up),  in.rowA(y),     in.rowA(down), in.rowB(up),
+                    in.rowB(y),   in.rowB(down),  out.rowA(y),   out.rowB(y)};
+    _kernel(row.at(x0), x1 - x0, _config.simArgs);
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Engine> makeTrapezoidEngine(const Config &config, const EngineOptions &options) {
+  return withBoundary(config.boundary, [&](auto boundary) -> std::unique_ptr<Engine> {
+    return std::make_unique<TrapezoidEngine<decltype(boundary)>>(config, options);
+  });
+}
@@ -0,0 +1,201 @@
+#include "VolumeEngine.hpp"
+#include <cstring>
+#include <stdexcept>
+#include "Boundary.hpp"
+#include "CacheInfo.hpp"
+#include "Kernels.hpp"
+#include "Planes.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+// A and B volumes: depth slices laid out like PlaneGrid with one ghost cell,
+// plus a ghost slice in front and behind. Ghost slices are whole copies, so
+// their ghost rows and columns (the edges and corners of the shell) are
+// filled too.
+struct VolumePlanes {
+  int width = 0;
+  int height = 0;
+  int depth = 0;
+  int lead = 0;   // floats before interior cell 0 of a row
+  int stride = 0; // floats per row
+  size_t sliceStride = 0; // floats per slice, ghost rows included
+  AlignedFloats a;
+  AlignedFloats b;
+
+  VolumePlanes() = default;
+  VolumePlanes(int w, int h, int d)
+      : width(w), height(h), depth(d), lead(roundUpFloats(1)), stride(roundUpFloats(lead + w + 1)),
+        sliceStride(size_t(stride) * (h + 2)), a(sliceStride * (d + 2), 0.0f),
+        b(sliceStride * (d + 2), 0.0f) {}
+
+  size_t offset(int y, int z) const {
+    return size_t(z + 1) * sliceStride + size_t(y + 1) * stride + lead;
+  }
+  float *rowA(int y, int z) { return a.data() + offset(y, z); }
+  float *rowB(int y, int z) { return b.data() + offset(y, z); }
+  const float *rowA(int y, int z) const { return a.data() + offset(y, z); }
+  const float *rowB(int y, int z) const { return b.data() + offset(y, z); }
+
+  void loadSlice(int z, const Grid &grid) {
+    for (int y = 0; y < height; y++) {
+      const float *src = grid.row(y);
+      float *dstA = rowA(y, z);
+      float *dstB = rowB(y, z);
+      for (int x = 0; x < width; x++) {
+        dstA[x] = src[2 * x];
+        dstB[x] = src[2 * x + 1];
+      }
+    }
+  }
+
+  // Copies slice `src`, ghosts included, over slice `dst`.
+  void copySlice(int src, int dst) {
+    const size_t from = size_t(src + 1) * sliceStride;
+    const size_t to = size_t(dst + 1) * sliceStride;
+    memcpy(a.data() + to, a.data() + from, sliceStride * sizeof(float));
+    memcpy(b.data() + to, b.data() + from, sliceStride * sizeof(float));
+  }
+
+  size_t bytes() const { return (a.size() + b.size()) * sizeof(float); }
+
+  StateView view(int z) const { return {width, height, rowA(0, z), rowB(0, z), 1, stride}; }
+};
+
+// Rows per band: the band's rows of the three input slices and the output
+// slice should fit in half of L2.
+int autoBandRows(int stride, int height) {
+  const size_t rowBytes = 2 * size_t(stride) * sizeof(float);
+  const size_t rows = cacheSize(2) / 2 / (4 * rowBytes);
+  return std::clamp(static_cast<int>(rows), 1, height);
+}
+
+template <class Boundary>
+class BlockedVolumeEngine : public VolumeEngine {
+public:
+  BlockedVolumeEngine(const Config &config, const EngineOptions &options)
+      : VolumeEngine(config), _kernel(volumeKernel(options.isa)), _pool(options.threads),
+        _volumes{VolumePlanes(config.width, config.height, config.depth),
+                 VolumePlanes(config.width, config.height, config.depth)} {
+    _bandRows = options.tileHeight > 0 ? std::min(options.tileHeight, config.height)
+                                       : autoBandRows(_volumes[0].stride, config.height);
+    if constexpr (Boundary::fixed) {
+      // Never written by a step: fill the wall slices once.
+      for (VolumePlanes &volume : _volumes) {
+        for (int z : {-1, config.depth}) {
+          const size_t from = size_t(z + 1) * volume.sliceStride;
+          std::fill_n(volume.a.data() + from, volume.sliceStride, Boundary::valueA);
+          std::fill_n(volume.b.data() + from, volume.sliceStride, Boundary::valueB);
+        }
+      }
+    }
+    _name = "volume/" + std::string(Boundary::name) + "/" + isaName(resolveIsa(options.isa)) +
+            "/" + std::to_string(_pool.size()) + "t/" + std::to_string(_bandRows) + " rows";
+  }
+
+  const char *name() const override { return _name.c_str(); }
+
+  void setSlice(int z, const Grid &grid) override { _volumes[_current].loadSlice(z, grid); }
+  StateView slice(int z) const override { return _volumes[_current].view(z); }
+  size_t stateBytes() const override { return _volumes[0].bytes() + _volumes[1].bytes(); }
+
+  void step(int steps) override {
+    const int w = _config.width;
+    const int h = _config.height;
+    const int d = _config.depth;
+    _pool.run([&](int thread) {
+      int z0, z1;
+      splitRange(d, _pool.size(), thread, z0, z1);
+      for (int s = 0; s < steps; s++) {
+        VolumePlanes &in = _volumes[(_current + s) % 2];
+        VolumePlanes &out = _volumes[(_current + s + 1) % 2];
+        for (int z = z0; z < z1; z++) {
+          fillSliceGhosts(in, z);
+        }
+        _pool.barrier();
+        for (int y0 = 0; y0 < h; y0 += _bandRows) {
+          const int y1 = std::min(y0 + _bandRows, h);
+          for (int z = z0; z < z1; z++) {
+            for (int y = y0; y < y1; y++) {
+              VolumeRow row = {{in.rowA(y - 1, z), in.rowA(y, z), in.rowA(y + 1, z),
+                                in.rowB(y - 1, z), in.rowB(y, z), in.rowB(y + 1, z),
+                                out.rowA(y, z), out.rowB(y, z)},
+                               in.rowA(y, z - 1),
+                               in.rowA(y, z + 1),
+                               in.rowB(y, z - 1),
+                               in.rowB(y, z + 1)};
+              _kernel(row, w, _config.simArgs);
+            }
+          }
+        }
+        _pool.barrier();
+      }
+    });
+    _current = (_current + steps) % 2;
+  }
+
+private:
+  VolumeKernel _kernel;
+  ThreadPool _pool;
+  VolumePlanes _volumes[2];
+  int _current = 0;
+  int _bandRows = 0;
+  std::string _name;
+
+  // Ghost rows and columns of slice z, then the ghost slices copied from it.
+  // Only the thread owning z touches them.
+  void fillSliceGhosts(VolumePlanes &volume, int z) {
+    const int w = volume.width;
+    const int h = volume.height;
+    for (int y = 0; y < h; y++) {
+      fillPlaneGhostColumns<Boundary>(volume.rowA(y, z), w, 1, fixedA<Boundary>());
+      fillPlaneGhostColumns<Boundary>(volume.rowB(y, z), w, 1, fixedB<Boundary>());
+    }
+    for (int dstY : {-1, h}) {
+      int srcY = 0;
+      if constexpr (!Boundary::fixed) {
+        srcY = Boundary::source(dstY, h);
+      }
+      fillPlaneGhostRow<Boundary>(volume.rowA(dstY, z), volume.rowA(srcY, z), w, 1,
+                                  fixedA<Boundary>());
+      fillPlaneGhostRow<Boundary>(volume.rowB(dstY, z), volume.rowB(srcY, z), w, 1,
+                                  fixedB<Boundary>());
+    }
+    if constexpr (!Boundary::fixed) {
+      for (int dstZ : {-1, volume.depth}) {
+        if (Boundary::source(dstZ, volume.depth) == z) {
+          volume.copySlice(z, dstZ);
+        }
+      }
+    }
+  }
+};
+
+} // namespace
+
+std::unique_ptr<VolumeEngine> makeSeededVolumeEngine(const Config &config,
+                                                     const EngineOptions &options) {
+  if (config.rates.active()) {
+    throw std::invalid_argument("The volume engine only supports uniform feed and kill rates, " +
+                                config.name + " varies them over the grid");
+  }
+  if (!config.model.grayScott()) {
+    throw std::invalid_argument("The volume engine only runs the Gray-Scott model, " +
+                                config.name + " uses " + config.model.name);
+  }
+  if (config.stencil != "5-point") {
+    throw std::invalid_argument("The volume engine has its own 7-point stencil, " +
+                                config.name + " asks for " + config.stencil);
+  }
+  std::unique_ptr<VolumeEngine> engine =
+      withBoundary(config.boundary, [&](auto boundary) -> std::unique_ptr<VolumeEngine> {
+        return std::make_unique<BlockedVolumeEngine<decltype(boundary)>>(config, options);
+      });
+  Grid slice(config.width, config.height);
+  srand(options.seed);
+  for (int z = 0; z < config.depth; z++) {
+    fillNoise(slice, config.noiseDensity);
+    engine->setSlice(z, slice);
+  }
+  return engine;
+}